@@ -0,0 +1,238 @@
+#include "client_sim.h"
+#include "net_common.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define CLIENT_SNAP_FRESH 4     // set in `middle` when it holds an unread snapshot
+
+double ClientSimNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+//------------------------------------------------------------------------------------
+// Triple buffer
+//------------------------------------------------------------------------------------
+static void PublishSnapshot(ClientSimTripleBuffer *tb)
+{
+    int prev = atomic_exchange_explicit(&tb->middle, tb->back | CLIENT_SNAP_FRESH, memory_order_acq_rel);
+    tb->back = prev & ~CLIENT_SNAP_FRESH;
+}
+
+const ClientSimSnapshot *ClientSimLatest(ClientSim *sim)
+{
+    ClientSimTripleBuffer *tb = &sim->snapshots;
+    if (atomic_load_explicit(&tb->middle, memory_order_relaxed) & CLIENT_SNAP_FRESH) {
+        int prev = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+        tb->front = prev & ~CLIENT_SNAP_FRESH;
+    }
+    return &tb->slots[tb->front];
+}
+
+//------------------------------------------------------------------------------------
+// Fixed-step ticking (sim thread, or the render thread via ClientSimPump)
+//------------------------------------------------------------------------------------
+static int StepAndPublish(ClientSim *sim)
+{
+    ClientSimSnapshot *snap = &sim->snapshots.slots[sim->snapshots.back];
+    for (int i = 0; i < sim->arena.unitCount; i++) {
+        snap->prevPosition[i] = sim->arena.units[i].position;
+        snap->prevFacing[i] = sim->arena.units[i].facingAngle;
+    }
+    const ProjectilePool *pool = &sim->arena.projectiles;
+    for (int p = 0; p < pool->capacity; p++)
+        snap->prevProjectile[p] = pool->items[p].position;
+    int result = CombatArenaTick(&sim->arena, CLIENT_SIM_DT, sim->events);
+    if (sim->replayDir) {
+        CombatRecorderTick(&sim->recorder, &sim->arena);
+        if (result) CombatRecorderEnd(&sim->recorder, &sim->arena, result);
+    }
+    snap->arena = sim->arena;
+    snap->result = result;
+    snap->timeScale = atomic_load_explicit(&sim->timeScale, memory_order_relaxed);
+    snap->publishTime = ClientSimNow();
+#ifdef COMBAT_PROFILE
+    snap->prof = sim->prof;
+#endif
+    PublishSnapshot(&sim->snapshots);
+    return result;
+}
+
+static void SleepSeconds(double s)
+{
+    if (s <= 0.0) return;
+    struct timespec ts = { (time_t)s, (long)((s - (double)(time_t)s) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+// Fixed-step accumulator: bank scaled wall time, run every whole step that's due.
+// Returns the wall seconds until the next step is due (or a short idle once decided).
+static double AdvanceSim(ClientSim *sim)
+{
+    double now = ClientSimNow();
+    float scale = atomic_load_explicit(&sim->timeScale, memory_order_relaxed);
+    sim->accum += (now - sim->lastTime) * scale;
+    sim->lastTime = now;
+    // After a stall (debugger, window drag) drop time instead of fast-forwarding
+    if (sim->accum > CLIENT_SIM_MAX_CATCHUP * CLIENT_SIM_DT)
+        sim->accum = CLIENT_SIM_MAX_CATCHUP * CLIENT_SIM_DT;
+
+    while (!sim->result && sim->accum >= CLIENT_SIM_DT) {
+        sim->accum -= CLIENT_SIM_DT;
+        sim->result = StepAndPublish(sim);
+    }
+
+    if (sim->result || scale <= 0.0f) return 0.005;
+    return (CLIENT_SIM_DT - sim->accum) / scale;
+}
+
+static void *ClientSimThread(void *arg)
+{
+    ClientSim *sim = arg;
+    CombatProfileBind(&sim->prof);
+    while (!atomic_load_explicit(&sim->quit, memory_order_acquire))
+        SleepSeconds(AdvanceSim(sim));
+    CombatProfileBind(NULL);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------------
+// Render-thread API
+//------------------------------------------------------------------------------------
+void ClientSimStart(ClientSim *sim, const Unit units[], int unitCount,
+                    CombatEventQueue *events, bool threaded)
+{
+    if (sim->running) ClientSimStop(sim);
+
+    memset(&sim->arena, 0, sizeof(sim->arena));
+    memcpy(sim->arena.units, units, sizeof(Unit) * unitCount);
+    sim->arena.unitCount = unitCount;
+    CombatArenaBegin(&sim->arena);
+    if (sim->replayDir) {
+        NetUnit netUnits[NET_MAX_UNITS];
+        int netCount = serialize_units(units, unitCount, netUnits, NET_MAX_UNITS);
+        CombatRecorderBegin(&sim->recorder, &sim->arena, netUnits, netCount, 0, 0,
+                            CLIENT_SIM_DT, CLIENT_SIM_DT);
+    }
+    sim->events = events;
+    sim->accum = 0.0;
+    sim->lastTime = ClientSimNow();
+    sim->result = 0;
+    atomic_store(&sim->quit, false);
+    atomic_store(&sim->timeScale, 1.0f);
+#ifdef COMBAT_PROFILE
+    CombatProfileReset(&sim->prof);
+#endif
+
+    // Seed the front slot with the starting board so the first frame has a snapshot
+    ClientSimTripleBuffer *tb = &sim->snapshots;
+    tb->back = 0;
+    tb->front = 1;
+    atomic_store(&tb->middle, 2);
+    ClientSimSnapshot *first = &tb->slots[tb->front];
+    first->arena = sim->arena;
+    for (int i = 0; i < unitCount; i++) {
+        first->prevPosition[i] = units[i].position;
+        first->prevFacing[i] = units[i].facingAngle;
+    }
+    first->result = 0;
+    first->timeScale = 1.0f;
+    first->publishTime = ClientSimNow();
+#ifdef COMBAT_PROFILE
+    first->prof = sim->prof;
+#endif
+
+    sim->threaded = threaded && pthread_create(&sim->thread, NULL, ClientSimThread, sim) == 0;
+    sim->running = true;
+}
+
+void ClientSimStop(ClientSim *sim)
+{
+    if (!sim->running) return;
+    if (sim->threaded) {
+        atomic_store_explicit(&sim->quit, true, memory_order_release);
+        pthread_join(sim->thread, NULL);
+    }
+    sim->running = false;
+    // Events from ticks after the render thread stopped presenting
+    CombatEvent ev;
+    while (CombatEventPop(sim->events, &ev)) { }
+
+    // Battles left before they ended have no END chunk and aren't saved
+    if (sim->replayDir && sim->recorder.finished) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/combat_%ld.rpl", sim->replayDir, (long)time(NULL));
+        if (CombatRecorderSave(&sim->recorder, path)) printf("[REPLAY] Saved %s\n", path);
+    }
+    CombatRecorderFree(&sim->recorder);
+}
+
+void ClientSimSetTimeScale(ClientSim *sim, float scale)
+{
+    atomic_store_explicit(&sim->timeScale, scale, memory_order_relaxed);
+}
+
+void ClientSimPump(ClientSim *sim)
+{
+    if (!sim->running || sim->threaded) return;
+    CombatProfileBind(&sim->prof);
+    AdvanceSim(sim);
+    CombatProfileBind(NULL);
+}
+
+float ClientSimAlpha(const ClientSimSnapshot *snap, double now)
+{
+    float alpha = (float)((now - snap->publishTime) * snap->timeScale / CLIENT_SIM_DT);
+    if (alpha < 0.0f) alpha = 0.0f;
+    if (alpha > 1.0f) alpha = 1.0f;
+    return alpha;
+}
+
+void ClientSimApply(const ClientSimSnapshot *snap, float alpha,
+                    Unit units[], Modifier modifiers[],
+                    ProjectilePool *pool, Fissure fissures[])
+{
+    const CombatArena *a = &snap->arena;
+    for (int i = 0; i < a->unitCount; i++) {
+        const Unit *s = &a->units[i];
+        Unit *u = &units[i];
+        Vector3 p0 = snap->prevPosition[i];
+        u->position.x = p0.x + (s->position.x - p0.x) * alpha;
+        u->position.z = p0.z + (s->position.z - p0.z) * alpha;
+        // Shortest way round so 350 -> 10 doesn't spin through 180
+        float dFacing = fmodf(s->facingAngle - snap->prevFacing[i] + 540.0f, 360.0f) - 180.0f;
+        u->facingAngle = snap->prevFacing[i] + dFacing * alpha;
+        u->currentHealth = s->currentHealth;
+        u->attackCooldown = s->attackCooldown;
+        u->targetIndex = s->targetIndex;
+        u->active = s->active;
+        memcpy(u->abilities, s->abilities, sizeof(u->abilities));
+        u->nextAbilitySlot = s->nextAbilitySlot;
+        u->gazeAccum = s->gazeAccum;
+        u->shieldHP = s->shieldHP;
+        u->abilityCastDelay = s->abilityCastDelay;
+        u->chargeTarget = s->chargeTarget;
+        u->hookPullDest = s->hookPullDest;
+        u->hookPullSpeed = s->hookPullSpeed;
+        u->castPause = s->castPause;
+    }
+    memcpy(modifiers, a->modifiers, sizeof(a->modifiers));
+    *pool = a->projectiles;
+    // A slot freed and reused within the tick has no meaningful previous position;
+    // anything that moved further than it could fly in one tick is drawn as-is
+    for (int l = 0; l < pool->liveCount; l++) {
+        Projectile *p = &pool->items[pool->live[l]];
+        Vector3 p0 = snap->prevProjectile[pool->live[l]];
+        float dx = p->position.x - p0.x, dy = p->position.y - p0.y, dz = p->position.z - p0.z;
+        float maxStep = p->speed * CLIENT_SIM_DT * 1.5f + 0.01f;
+        if (dx*dx + dy*dy + dz*dz > maxStep * maxStep) continue;
+        p->position.x = p0.x + dx * alpha;
+        p->position.y = p0.y + dy * alpha;
+        p->position.z = p0.z + dz * alpha;
+    }
+    memcpy(fissures, a->fissures, sizeof(a->fissures));
+}
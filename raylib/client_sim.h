@@ -0,0 +1,88 @@
+#pragma once
+#include "combat_sim.h"
+#include "combat_prof.h"
+#include "combat_replay.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------------
+// Client combat sim thread — runs CombatArenaTick at the server's fixed rate on
+// its own thread, so outcomes never depend on render frame rate and a slow frame
+// can't stretch a step (no projectile tunnelling). After every tick the sim
+// publishes an immutable snapshot through a triple buffer; the render thread grabs
+// the newest one whenever it draws, interpolates positions and facing from the
+// tick before, and pops that tick's events off the shared event queue.
+//
+// Without a thread (pthread_create failed or --no-sim-thread) the same fixed-step
+// accumulator runs from ClientSimPump on the render thread.
+//
+// Only the deterministic combat state moves to the sim thread. Particles, floating
+// texts, shake, animation and audio stay on the render thread, driven by events.
+//------------------------------------------------------------------------------------
+#define CLIENT_SIM_DT          (1.0f / 60.0f)   // same rate as the server (COMBAT_DT)
+#define CLIENT_SIM_MAX_CATCHUP 4                // ticks run back-to-back before dropping time
+
+typedef struct {
+    CombatArena arena;                  // state after the tick
+    Vector3 prevPosition[MAX_UNITS];    // unit positions one tick earlier
+    float prevFacing[MAX_UNITS];        // unit facing one tick earlier
+    Vector3 prevProjectile[MAX_PROJECTILES]; // projectile positions one tick earlier
+    int result;                         // CombatArenaTick result (0 = still fighting)
+    double publishTime;                 // ClientSimNow() when published
+    float timeScale;                    // slow-mo in effect for this tick
+#ifdef COMBAT_PROFILE
+    CombatProfile prof;                 // battle profile totals after the tick
+#endif
+} ClientSimSnapshot;
+
+// Lock-free triple buffer: the producer writes `back`, the consumer reads `front`,
+// and `middle` holds the last published slot (plus a fresh bit) for them to swap.
+typedef struct {
+    ClientSimSnapshot slots[3];
+    _Atomic int middle;
+    int back;                           // producer only
+    int front;                          // consumer only
+} ClientSimTripleBuffer;
+
+typedef struct {
+    pthread_t thread;
+    bool running;                       // owner (render) thread only
+    bool threaded;                      // false = ticked from ClientSimPump
+    atomic_bool quit;
+    _Atomic float timeScale;            // slow-mo multiplier set by the render thread
+    CombatArena arena;                  // sim thread only while running
+    double accum;                       // sim seconds owed (ticking thread only)
+    double lastTime;                    // ClientSimNow() at the last advance
+    int result;                         // last tick result; ticking stops once non-zero
+    ClientSimTripleBuffer snapshots;
+    CombatEventQueue *events;           // sim thread pushes, render thread pops
+#ifdef COMBAT_PROFILE
+    CombatProfile prof;                 // ticking thread only; read it from snapshots
+#endif
+    const char *replayDir;              // non-NULL: record each battle to <dir>/combat_<time>.rpl
+    CombatRecorder recorder;            // sim thread only while running
+} ClientSim;
+
+double ClientSimNow(void);
+
+// Copy the board into the sim and start ticking; units/modifiers/fissures/pool are
+// set up by CombatArenaBegin exactly as a server battle would be. Falls back to
+// render-thread ticking when threaded is false or the thread can't be created.
+void ClientSimStart(ClientSim *sim, const Unit units[], int unitCount,
+                    CombatEventQueue *events, bool threaded);
+// Join the sim thread, drop events nobody will present and save the replay if
+// recording. Safe when not running.
+void ClientSimStop(ClientSim *sim);
+void ClientSimSetTimeScale(ClientSim *sim, float scale);
+// Run any fixed steps that are due when there is no sim thread; no-op otherwise
+void ClientSimPump(ClientSim *sim);
+
+// Newest published snapshot; stays valid and unchanged until the next call
+const ClientSimSnapshot *ClientSimLatest(ClientSim *sim);
+// How far (0..1) render time has moved past the snapshot's tick
+float ClientSimAlpha(const ClientSimSnapshot *snap, double now);
+// Copy the sim-owned fields of a snapshot into the render thread's copies, leaving
+// presentation fields (anim, hit flash, Y smoothing, selection) untouched
+void ClientSimApply(const ClientSimSnapshot *snap, float alpha,
+                    Unit units[], Modifier modifiers[],
+                    ProjectilePool *pool, Fissure fissures[]);
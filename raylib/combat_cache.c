@@ -0,0 +1,273 @@
+#include "combat_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMBAT_CACHE_MAGIC 0x31484343u   // "CCH1"
+
+//------------------------------------------------------------------------------------
+// Canonical key
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t lo, hi;
+} KeyHasher;
+
+static uint64_t Mix64(uint64_t x)
+{
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Two independently seeded lanes so the key is 128 bits wide
+static void KeyInt(KeyHasher *h, int64_t v)
+{
+    h->lo = Mix64(h->lo ^ (uint64_t)v) + 0x9E3779B97F4A7C15ull;
+    h->hi = Mix64(h->hi + (uint64_t)v * 0xD6E8FEB86659FD93ull) ^ 0xA0761D6478BD642Full;
+}
+
+static void KeyFloat(KeyHasher *h, float f)
+{
+    f += 0.0f;                  // -0 and +0 hash the same
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    KeyInt(h, bits);
+}
+
+CombatCacheKey CombatCacheKeyFor(const CombatArena *arena, uint32_t variant)
+{
+    KeyHasher h = { 0x243F6A8885A308D3ull, 0x13198A2E03707344ull };
+    KeyInt(&h, COMBAT_SIM_VERSION);
+    KeyInt(&h, variant);
+    KeyInt(&h, arena->unitCount);
+    for (int i = 0; i < arena->unitCount; i++) {
+        const Unit *u = &arena->units[i];
+        KeyInt(&h, u->active);
+        if (!u->active) continue;
+        KeyInt(&h, u->typeIndex);
+        KeyInt(&h, u->team);
+        KeyInt(&h, u->rarity);
+        KeyFloat(&h, u->position.x);
+        KeyFloat(&h, u->position.z);
+        KeyFloat(&h, u->facingAngle);
+        KeyFloat(&h, u->currentHealth);
+        KeyFloat(&h, u->attackCooldown);
+        KeyFloat(&h, u->hpMultiplier);
+        KeyFloat(&h, u->dmgMultiplier);
+        KeyFloat(&h, u->speedMultiplier);
+        KeyFloat(&h, u->scaleOverride);
+        KeyFloat(&h, u->shieldHP);
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            const AbilitySlot *s = &u->abilities[a];
+            KeyInt(&h, s->abilityId);
+            if (s->abilityId < 0) continue;
+            KeyInt(&h, s->level);
+            KeyFloat(&h, s->cooldownRemaining);
+            KeyInt(&h, s->triggered);
+        }
+    }
+    return (CombatCacheKey){ h.lo, h.hi };
+}
+
+//------------------------------------------------------------------------------------
+// Cache
+//------------------------------------------------------------------------------------
+static int BucketFor(const CombatCache *cache, CombatCacheKey key)
+{
+    return (int)(key.lo & (uint64_t)(cache->bucketCount - 1));
+}
+
+static void LruUnlink(CombatCache *cache, int e)
+{
+    CombatCacheEntry *en = &cache->entries[e];
+    if (en->lruPrev >= 0) cache->entries[en->lruPrev].lruNext = en->lruNext;
+    else cache->lruHead = en->lruNext;
+    if (en->lruNext >= 0) cache->entries[en->lruNext].lruPrev = en->lruPrev;
+    else cache->lruTail = en->lruPrev;
+    en->lruPrev = en->lruNext = -1;
+}
+
+static void LruPushFront(CombatCache *cache, int e)
+{
+    CombatCacheEntry *en = &cache->entries[e];
+    en->lruPrev = -1;
+    en->lruNext = cache->lruHead;
+    if (cache->lruHead >= 0) cache->entries[cache->lruHead].lruPrev = e;
+    cache->lruHead = e;
+    if (cache->lruTail < 0) cache->lruTail = e;
+}
+
+static int FindEntry(const CombatCache *cache, CombatCacheKey key)
+{
+    for (int e = cache->buckets[BucketFor(cache, key)]; e >= 0; e = cache->entries[e].hashNext)
+        if (cache->entries[e].key.lo == key.lo && cache->entries[e].key.hi == key.hi) return e;
+    return -1;
+}
+
+static void DropReplay(CombatCache *cache, CombatCacheEntry *en)
+{
+    if (!en->outcome.replay) return;
+    cache->replayBytes -= (size_t)en->outcome.replaySize;
+    free((void *)en->outcome.replay);
+    en->outcome.replay = NULL;
+    en->outcome.replaySize = 0;
+}
+
+static void RemoveEntry(CombatCache *cache, int e)
+{
+    CombatCacheEntry *en = &cache->entries[e];
+    int *link = &cache->buckets[BucketFor(cache, en->key)];
+    while (*link != e) link = &cache->entries[*link].hashNext;
+    *link = en->hashNext;
+    LruUnlink(cache, e);
+    DropReplay(cache, en);
+    en->used = false;
+    cache->count--;
+}
+
+bool CombatCacheInit(CombatCache *cache, int capacity, size_t maxReplayBytes)
+{
+    memset(cache, 0, sizeof(*cache));
+    if (capacity < 1) capacity = 1;
+    int buckets = 1;
+    while (buckets < capacity * 2) buckets <<= 1;
+    cache->entries = calloc((size_t)capacity, sizeof(CombatCacheEntry));
+    cache->buckets = malloc(sizeof(int) * (size_t)buckets);
+    if (!cache->entries || !cache->buckets) {
+        CombatCacheFree(cache);
+        return false;
+    }
+    for (int b = 0; b < buckets; b++) cache->buckets[b] = -1;
+    cache->capacity = capacity;
+    cache->bucketCount = buckets;
+    cache->maxReplayBytes = maxReplayBytes;
+    cache->lruHead = cache->lruTail = -1;
+    return true;
+}
+
+void CombatCacheFree(CombatCache *cache)
+{
+    if (cache->entries) {
+        for (int e = 0; e < cache->capacity; e++)
+            free((void *)cache->entries[e].outcome.replay);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    memset(cache, 0, sizeof(*cache));
+}
+
+bool CombatCacheLookup(CombatCache *cache, CombatCacheKey key, CombatOutcome *out)
+{
+    if (!cache->entries) return false;
+    int e = FindEntry(cache, key);
+    if (e < 0) { cache->misses++; return false; }
+    cache->hits++;
+    LruUnlink(cache, e);
+    LruPushFront(cache, e);
+    *out = cache->entries[e].outcome;
+    return true;
+}
+
+void CombatCacheStore(CombatCache *cache, CombatCacheKey key, const CombatOutcome *outcome)
+{
+    if (!cache->entries) return;
+    int e = FindEntry(cache, key);
+    if (e >= 0) RemoveEntry(cache, e);
+
+    size_t replaySize = outcome->replay ? (size_t)outcome->replaySize : 0;
+    if (replaySize > cache->maxReplayBytes) replaySize = 0;
+
+    // Evict from the cold end until there's a free slot and room for the replay
+    while (cache->count > 0 &&
+           (cache->count >= cache->capacity || cache->replayBytes + replaySize > cache->maxReplayBytes))
+        RemoveEntry(cache, cache->lruTail);
+
+    for (e = 0; cache->entries[e].used; e++) { }
+    CombatCacheEntry *en = &cache->entries[e];
+    en->key = key;
+    en->outcome = *outcome;
+    en->outcome.replay = NULL;
+    en->outcome.replaySize = 0;
+    if (replaySize > 0) {
+        uint8_t *copy = malloc(replaySize);
+        if (copy) {
+            memcpy(copy, outcome->replay, replaySize);
+            en->outcome.replay = copy;
+            en->outcome.replaySize = (int)replaySize;
+            cache->replayBytes += replaySize;
+        }
+    }
+    en->used = true;
+    int b = BucketFor(cache, key);
+    en->hashNext = cache->buckets[b];
+    cache->buckets[b] = e;
+    LruPushFront(cache, e);
+    cache->count++;
+}
+
+//------------------------------------------------------------------------------------
+// Persistence
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint32_t magic;
+    uint32_t simVersion;
+    int32_t count;
+} CacheFileHeader;
+
+typedef struct {
+    uint64_t keyLo, keyHi;
+    int32_t result;
+    int32_t tickCount;
+    float simTime;
+    int32_t replaySize;
+} CacheFileEntry;
+
+void CombatCacheLoad(CombatCache *cache, const char *filepath)
+{
+    FILE *f = fopen(filepath, "rb");
+    if (!f) return;
+    CacheFileHeader hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != COMBAT_CACHE_MAGIC ||
+        hdr.simVersion != COMBAT_SIM_VERSION) {
+        fclose(f);
+        return;
+    }
+    // Written coldest first, so storing in file order rebuilds the LRU order
+    for (int i = 0; i < hdr.count; i++) {
+        CacheFileEntry fe;
+        if (fread(&fe, sizeof(fe), 1, f) != 1 || fe.replaySize < 0) break;
+        uint8_t *replay = NULL;
+        if (fe.replaySize > 0) {
+            replay = malloc((size_t)fe.replaySize);
+            if (!replay || fread(replay, 1, (size_t)fe.replaySize, f) != (size_t)fe.replaySize) {
+                free(replay);
+                break;
+            }
+        }
+        CombatOutcome oc = { fe.result, fe.tickCount, fe.simTime, replay, fe.replaySize };
+        CombatCacheStore(cache, (CombatCacheKey){ fe.keyLo, fe.keyHi }, &oc);
+        free(replay);
+    }
+    fclose(f);
+}
+
+void CombatCacheSave(const CombatCache *cache, const char *filepath)
+{
+    if (!cache->entries) return;
+    FILE *f = fopen(filepath, "wb");
+    if (!f) return;
+    CacheFileHeader hdr = { COMBAT_CACHE_MAGIC, COMBAT_SIM_VERSION, cache->count };
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    for (int e = cache->lruTail; e >= 0; e = cache->entries[e].lruPrev) {
+        const CombatCacheEntry *en = &cache->entries[e];
+        CacheFileEntry fe = {
+            en->key.lo, en->key.hi, en->outcome.result, en->outcome.tickCount,
+            en->outcome.simTime, en->outcome.replaySize
+        };
+        fwrite(&fe, sizeof(fe), 1, f);
+        if (en->outcome.replaySize > 0)
+            fwrite(en->outcome.replay, 1, (size_t)en->outcome.replaySize, f);
+    }
+    fclose(f);
+}
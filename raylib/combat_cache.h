@@ -0,0 +1,64 @@
+#pragma once
+#include "combat_sim.h"
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Combat outcome cache — CombatTick is deterministic, so a battle is fully decided
+// by its starting arena. Entries are keyed by a canonical 128-bit hash of both
+// armies (type, team, position, facing, HP, stat multipliers after rarity and
+// synergies, shields, abilities and levels) plus the sim version, and hold the
+// outcome and, optionally, a compact replay. A hit means the battle never needs
+// simulating again.
+//
+// Bounded by entry count (LRU) and total replay bytes; optionally saved to disk.
+// Entries from another COMBAT_SIM_VERSION simply stop matching.
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t lo, hi;
+} CombatCacheKey;
+
+typedef struct {
+    int result;             // CombatTick result: 1 = blue wins, 2 = red wins, 3 = draw
+    int tickCount;          // ticks the battle took
+    float simTime;          // seconds the battle took
+    const uint8_t *replay;  // optional replay bytes (NULL = none)
+    int replaySize;
+} CombatOutcome;
+
+typedef struct {
+    CombatCacheKey key;
+    CombatOutcome outcome;  // replay owned by the cache
+    int lruPrev, lruNext;   // -1 terminated; head = most recently used
+    int hashNext;           // next entry in the same bucket (-1 = end)
+    bool used;
+} CombatCacheEntry;
+
+typedef struct {
+    CombatCacheEntry *entries;
+    int capacity;
+    int count;
+    int *buckets;           // bucket -> first entry (-1 = empty)
+    int bucketCount;        // power of two
+    int lruHead, lruTail;
+    size_t replayBytes;
+    size_t maxReplayBytes;
+    uint64_t hits, misses;
+} CombatCache;
+
+// Key for a battle about to start: call after CombatArenaBegin. variant folds in
+// anything else that changes the outcome (e.g. fixed vs event-driven stepping).
+CombatCacheKey CombatCacheKeyFor(const CombatArena *arena, uint32_t variant);
+
+bool CombatCacheInit(CombatCache *cache, int capacity, size_t maxReplayBytes);
+void CombatCacheFree(CombatCache *cache);
+// On a hit copies the outcome (replay points into the cache and stays valid until
+// the next store) and marks the entry most recently used.
+bool CombatCacheLookup(CombatCache *cache, CombatCacheKey key, CombatOutcome *out);
+// Insert or replace; evicts least recently used entries to stay within bounds.
+// A replay larger than the whole byte budget is dropped, the outcome still stored.
+void CombatCacheStore(CombatCache *cache, CombatCacheKey key, const CombatOutcome *outcome);
+
+// Binary file; a missing file or one from another sim version loads as empty
+void CombatCacheLoad(CombatCache *cache, const char *filepath);
+void CombatCacheSave(const CombatCache *cache, const char *filepath);
@@ -0,0 +1,79 @@
+#include "combat_math.h"
+#include <stdint.h>
+
+// atan(2^-i) in degrees, 16.16 fixed point
+static const int32_t CORDIC_ATAN_DEG[] = {
+    2949120, 1740967, 919879, 466945, 234379, 117304, 58666, 29335,
+    14668, 7334, 3667, 1833, 917, 458, 229, 115, 57, 29, 14, 7, 4, 2, 1,
+};
+#define CORDIC_STEPS  ((int)(sizeof(CORDIC_ATAN_DEG) / sizeof(CORDIC_ATAN_DEG[0])))
+#define CORDIC_GAIN   652032874     // prod 1/sqrt(1 + 2^-2i) in 2.30
+#define DEG_ONE       65536
+#define DEG_90        (90 * DEG_ONE)
+#define DEG_180       (180 * DEG_ONE)
+#define DEG_360       (360 * DEG_ONE)
+
+static uint32_t ISqrt64(uint64_t v)
+{
+    uint64_t r = 0, bit = 1ull << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+        else r >>= 1;
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+float FixedSqrt(float x)
+{
+    if (!(x > 0.0f)) return 0.0f;
+    if (x >= 2147483648.0f) return sqrtf(x);   // beyond any arena distance; sqrtf is exact-rounded
+    // x * 2^32 is exact in double, the conversion truncates the same everywhere
+    uint64_t v = (uint64_t)((double)x * 4294967296.0);
+    return (float)ISqrt64(v) * (1.0f / 65536.0f);
+}
+
+float FixedAtan2Deg(float y, float x)
+{
+    if (x == 0.0f && y == 0.0f) return 0.0f;
+    // Scale by a power of two (exact) so the larger component is ~2^30
+    int e;
+    frexpf(fmaxf(fabsf(x), fabsf(y)), &e);
+    int64_t xi = (int64_t)ldexpf(x, 30 - e);
+    int64_t yi = (int64_t)ldexpf(y, 30 - e);
+    int64_t z = 0;
+    if (xi < 0) {               // rotate into the right half-plane
+        z = yi >= 0 ? DEG_180 : -DEG_180;
+        xi = -xi;
+        yi = -yi;
+    }
+    for (int i = 0; i < CORDIC_STEPS; i++) {
+        int64_t nx;
+        if (yi > 0) { nx = xi + (yi >> i); yi -= xi >> i; z += CORDIC_ATAN_DEG[i]; }
+        else        { nx = xi - (yi >> i); yi += xi >> i; z -= CORDIC_ATAN_DEG[i]; }
+        xi = nx;
+    }
+    return (float)z * (1.0f / DEG_ONE);
+}
+
+void FixedSinCosDeg(float deg, float *s, float *c)
+{
+    int64_t z = (int64_t)(deg * (float)DEG_ONE) % DEG_360;
+    if (z > DEG_180) z -= DEG_360;
+    if (z < -DEG_180) z += DEG_360;
+    // Fold into [-90, 90]: sin is kept, cos flips sign
+    int64_t cosSign = 1;
+    if (z > DEG_90) { z = DEG_180 - z; cosSign = -1; }
+    else if (z < -DEG_90) { z = -DEG_180 - z; cosSign = -1; }
+
+    int64_t xi = CORDIC_GAIN, yi = 0;
+    for (int i = 0; i < CORDIC_STEPS; i++) {
+        int64_t nx;
+        if (z >= 0) { nx = xi - (yi >> i); yi += xi >> i; z -= CORDIC_ATAN_DEG[i]; }
+        else        { nx = xi + (yi >> i); yi -= xi >> i; z += CORDIC_ATAN_DEG[i]; }
+        xi = nx;
+    }
+    *s = (float)yi * (1.0f / 1073741824.0f);
+    *c = (float)(xi * cosSign) * (1.0f / 1073741824.0f);
+}
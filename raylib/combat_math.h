@@ -0,0 +1,35 @@
+#pragma once
+#include "game.h"
+#include <math.h>
+
+//------------------------------------------------------------------------------------
+// Combat math — the only non-trivial math CombatTick is allowed to call.
+//
+// IEEE +, -, *, / and sqrt are correctly rounded everywhere, so once FMA contraction
+// is off (-ffp-contract=off in both Makefiles) the float sim only diverges between
+// builds through libm: atan2f/sinf/cosf differ by an ulp between glibc, musl, the
+// macOS libm and MSVC, and compilers may swap in their own approximations.
+//
+// Build with -DCOMBAT_FIXED_MATH (make FIXED_MATH=1) for lockstep play: these then
+// run on integers only — a bitwise 64-bit isqrt and CORDIC trig against a table of
+// atan(2^-i) in 16.16 degrees — and give bit-identical results on any compiler, -O
+// level or CPU. Without it they are the plain libm calls the sim always used.
+// Results differ between the two modes, so COMBAT_SIM_VERSION tracks the choice.
+//------------------------------------------------------------------------------------
+
+// Integer-only versions, always built so tools can compare them against libm
+float FixedSqrt(float x);                       // ±1/65536 absolute for x < 2^31
+float FixedAtan2Deg(float y, float x);          // degrees in [-180, 180], ±0.0002
+void FixedSinCosDeg(float deg, float *s, float *c);
+
+#ifdef COMBAT_FIXED_MATH
+static inline float CombatSqrt(float x) { return FixedSqrt(x); }
+static inline float CombatAtan2Deg(float y, float x) { return FixedAtan2Deg(y, x); }
+static inline float CombatSinDeg(float deg) { float s, c; FixedSinCosDeg(deg, &s, &c); return s; }
+static inline float CombatCosDeg(float deg) { float s, c; FixedSinCosDeg(deg, &s, &c); return c; }
+#else
+static inline float CombatSqrt(float x) { return sqrtf(x); }
+static inline float CombatAtan2Deg(float y, float x) { return atan2f(y, x) * (180.0f / PI); }
+static inline float CombatSinDeg(float deg) { return sinf(deg * (PI / 180.0f)); }
+static inline float CombatCosDeg(float deg) { return cosf(deg * (PI / 180.0f)); }
+#endif
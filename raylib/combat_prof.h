@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Combat profiling — scoped section timers + counters for CombatTick.
+// Build with -DCOMBAT_PROFILE to enable; otherwise every macro below expands to
+// nothing and the hot path is unchanged.
+//
+// Samples land in whatever CombatProfile is bound on the calling thread
+// (CombatProfileBind), so the server can keep one per battle and per session
+// without threading a pointer through CombatTick.
+//------------------------------------------------------------------------------------
+typedef enum {
+    PROF_SEC_MODIFIERS = 0,   // STEP 1: modifier + fissure tick
+    PROF_SEC_PROJECTILES,     // STEP 2: projectile step
+    PROF_SEC_UNITS,           // STEP 3: per-unit AI, casting, movement, attacks
+    PROF_SEC_GAZE,            // STEP 4: stone gaze accumulation
+    PROF_SEC_END_CHECK,       // STEP 5: round end check
+    PROF_SEC_COUNT
+} ProfSection;
+
+typedef enum {
+    PROF_CNT_QUERIES = 0,     // target searches (closest enemy, chain frost, ally picks)
+    PROF_CNT_MODIFIER_SCANS,  // modifier slots visited
+    PROF_CNT_PROJECTILE_STEPS,// live projectiles stepped
+    PROF_CNT_ABILITY_CASTS,   // abilities cast (actives + passive procs)
+    PROF_CNT_COUNT
+} ProfCounter;
+
+typedef struct {
+    uint64_t ns[PROF_SEC_COUNT];
+    uint64_t counters[PROF_CNT_COUNT];
+    uint64_t ticks;           // CombatTick calls
+    uint64_t battles;         // battles folded in via CombatProfileAdd
+} CombatProfile;
+
+extern const char *PROF_SECTION_NAMES[PROF_SEC_COUNT];
+extern const char *PROF_COUNTER_NAMES[PROF_CNT_COUNT];
+
+void CombatProfileReset(CombatProfile *prof);
+void CombatProfileAdd(CombatProfile *dst, const CombatProfile *src);
+// One-line summary (per-tick averages); returns chars written like snprintf
+int CombatProfileFormat(const CombatProfile *prof, char *buf, int bufSize);
+
+#ifdef COMBAT_PROFILE
+extern _Thread_local CombatProfile *combatProfBound;
+void CombatProfileBind(CombatProfile *prof);   // NULL stops sampling
+uint64_t CombatProfileNow(void);               // monotonic ns
+
+#define PROF_BEGIN(sec)     uint64_t profStart_##sec = CombatProfileNow()
+#define PROF_END(sec)       do { if (combatProfBound) combatProfBound->ns[sec] += CombatProfileNow() - profStart_##sec; } while (0)
+#define PROF_COUNT(cnt, n)  do { if (combatProfBound) combatProfBound->counters[cnt] += (uint64_t)(n); } while (0)
+#define PROF_TICK()         do { if (combatProfBound) combatProfBound->ticks++; } while (0)
+#else
+#define CombatProfileBind(prof) ((void)0)
+#define PROF_BEGIN(sec)     ((void)0)
+#define PROF_END(sec)       ((void)0)
+#define PROF_COUNT(cnt, n)  ((void)0)
+#define PROF_TICK()         ((void)0)
+#endif
@@ -0,0 +1,215 @@
+#include "combat_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//------------------------------------------------------------------------------------
+// Recorder
+//------------------------------------------------------------------------------------
+static bool Reserve(CombatRecorder *rec, int extra)
+{
+    if (rec->failed) return false;
+    if (rec->size + extra <= rec->cap) return true;
+    int cap = rec->cap ? rec->cap : 16 * 1024;
+    while (cap < rec->size + extra) cap *= 2;
+    uint8_t *data = realloc(rec->data, (size_t)cap);
+    if (!data) { rec->failed = true; return false; }
+    rec->data = data;
+    rec->cap = cap;
+    return true;
+}
+
+static void WriteChunk(CombatRecorder *rec, uint32_t tag, const void *a, int aSize,
+                       const void *b, int bSize)
+{
+    uint32_t size = (uint32_t)(aSize + bSize);
+    if (!Reserve(rec, 8 + (int)size)) return;
+    memcpy(rec->data + rec->size, &tag, 4);
+    memcpy(rec->data + rec->size + 4, &size, 4);
+    rec->size += 8;
+    if (aSize) memcpy(rec->data + rec->size, a, (size_t)aSize);
+    if (bSize) memcpy(rec->data + rec->size + aSize, b, (size_t)bSize);
+    rec->size += (int)size;
+}
+
+static void WriteKeyframe(CombatRecorder *rec, const CombatArena *arena)
+{
+    static _Thread_local uint8_t packed[COMBAT_PACK_MAX_SIZE];
+    int len = PackCombatState(arena, packed, sizeof(packed));
+    if (len < 0) { rec->failed = true; return; }
+    int32_t tick = arena->tickCount;
+    WriteChunk(rec, REPLAY_CHUNK_KEYFRAME, &tick, 4, packed, len);
+}
+
+static void PushHash(CombatRecorder *rec, const CombatArena *arena)
+{
+    if (rec->hashCount == rec->hashCap) {
+        int cap = rec->hashCap ? rec->hashCap * 2 : 256;
+        uint64_t *h = realloc(rec->hashes, sizeof(uint64_t) * (size_t)cap);
+        if (!h) { rec->failed = true; return; }
+        rec->hashes = h;
+        rec->hashCap = cap;
+    }
+    rec->hashes[rec->hashCount++] = HashCombatState(arena).all;
+}
+
+void CombatRecorderBegin(CombatRecorder *rec, const CombatArena *arena,
+                         const NetUnit netUnits[], int netUnitCount,
+                         int round, uint32_t flags, float dt, float maxStep)
+{
+    CombatRecorderFree(rec);
+    rec->header = (ReplayHeader){
+        .magic = REPLAY_MAGIC, .formatVersion = REPLAY_FORMAT_VERSION,
+        .headerSize = sizeof(ReplayHeader), .simVersion = COMBAT_SIM_VERSION,
+        .flags = flags, .dt = dt, .maxStep = maxStep, .round = (uint16_t)round,
+        .hashInterval = REPLAY_HASH_TICKS, .keyframeInterval = REPLAY_KEYFRAME_TICKS,
+    };
+    memcpy(rec->header.rngState, arena->rng.s, sizeof(rec->header.rngState));
+    if (!Reserve(rec, sizeof(ReplayHeader))) return;
+    memcpy(rec->data, &rec->header, sizeof(ReplayHeader));
+    rec->size = sizeof(ReplayHeader);
+    if (netUnits && netUnitCount > 0)
+        WriteChunk(rec, REPLAY_CHUNK_UNITS, netUnits, (int)sizeof(NetUnit) * netUnitCount, NULL, 0);
+    WriteKeyframe(rec, arena);
+    PushHash(rec, arena);
+}
+
+void CombatRecorderTick(CombatRecorder *rec, const CombatArena *arena)
+{
+    if (rec->failed || rec->finished) return;
+    if (arena->tickCount % REPLAY_HASH_TICKS == 0) PushHash(rec, arena);
+    if (arena->tickCount % REPLAY_KEYFRAME_TICKS == 0) WriteKeyframe(rec, arena);
+}
+
+void CombatRecorderEnd(CombatRecorder *rec, const CombatArena *arena, int result)
+{
+    if (rec->failed || rec->finished) return;
+    WriteChunk(rec, REPLAY_CHUNK_HASHES, rec->hashes, (int)sizeof(uint64_t) * rec->hashCount, NULL, 0);
+    ReplayEnd end = { result, arena->tickCount, arena->simTime };
+    WriteChunk(rec, REPLAY_CHUNK_END, &end, sizeof(end), NULL, 0);
+    rec->finished = true;
+}
+
+bool CombatRecorderSave(const CombatRecorder *rec, const char *filepath)
+{
+    if (rec->failed || !rec->finished) return false;
+    FILE *f = fopen(filepath, "wb");
+    if (!f) return false;
+    bool ok = fwrite(rec->data, 1, (size_t)rec->size, f) == (size_t)rec->size;
+    return (fclose(f) == 0) && ok;
+}
+
+void CombatRecorderFree(CombatRecorder *rec)
+{
+    free(rec->data);
+    free(rec->hashes);
+    memset(rec, 0, sizeof(*rec));
+}
+
+//------------------------------------------------------------------------------------
+// Playback
+//------------------------------------------------------------------------------------
+bool CombatReplayOpen(CombatReplay *rep, const uint8_t *data, size_t size)
+{
+    memset(rep, 0, sizeof(*rep));
+    if (size < sizeof(ReplayHeader)) return false;
+    const ReplayHeader *hdr = (const ReplayHeader *)data;
+    if (hdr->magic != REPLAY_MAGIC || hdr->formatVersion != REPLAY_FORMAT_VERSION ||
+        hdr->headerSize < sizeof(ReplayHeader) || hdr->headerSize > size) return false;
+    rep->data = data;
+    rep->size = size;
+    rep->header = hdr;
+
+    size_t pos = hdr->headerSize;
+    while (pos + 8 <= size) {
+        uint32_t tag, len;
+        memcpy(&tag, data + pos, 4);
+        memcpy(&len, data + pos + 4, 4);
+        pos += 8;
+        if (len > size - pos) return false;
+        const uint8_t *payload = data + pos;
+        if (tag == REPLAY_CHUNK_UNITS) {
+            rep->netUnits = (const NetUnit *)payload;
+            rep->netUnitCount = (int)(len / sizeof(NetUnit));
+        } else if (tag == REPLAY_CHUNK_KEYFRAME && len >= 4 && rep->keyframeCount < REPLAY_MAX_KEYFRAMES) {
+            int32_t tick;
+            memcpy(&tick, payload, 4);
+            rep->keyframes[rep->keyframeCount] = payload + 4;
+            rep->keyframeSizes[rep->keyframeCount] = (int)len - 4;
+            rep->keyframeTicks[rep->keyframeCount] = tick;
+            rep->keyframeCount++;
+        } else if (tag == REPLAY_CHUNK_HASHES) {
+            rep->hashes = payload;
+            rep->hashCount = (int)(len / sizeof(uint64_t));
+        } else if (tag == REPLAY_CHUNK_END && len >= sizeof(ReplayEnd)) {
+            memcpy(&rep->end, payload, sizeof(ReplayEnd));
+            rep->hasEnd = true;
+        }
+        pos += len;
+    }
+    return rep->keyframeCount > 0;
+}
+
+bool CombatReplayMap(CombatReplay *rep, const char *filepath)
+{
+    memset(rep, 0, sizeof(*rep));
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return false; }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    if (!CombatReplayOpen(rep, data, (size_t)st.st_size)) {
+        munmap(data, (size_t)st.st_size);
+        memset(rep, 0, sizeof(*rep));
+        return false;
+    }
+    rep->mapped = true;
+    return true;
+}
+
+void CombatReplayClose(CombatReplay *rep)
+{
+    if (rep->mapped) munmap((void *)rep->data, rep->size);
+    memset(rep, 0, sizeof(*rep));
+}
+
+bool CombatReplayRestore(const CombatReplay *rep, int tick, CombatArena *arena)
+{
+    int k = -1;
+    for (int i = 0; i < rep->keyframeCount; i++)
+        if (rep->keyframeTicks[i] <= tick && (k < 0 || rep->keyframeTicks[i] > rep->keyframeTicks[k])) k = i;
+    if (k < 0) return false;
+    memcpy(arena->rng.s, rep->header->rngState, sizeof(arena->rng.s));
+    return UnpackCombatState(arena, rep->keyframes[k], rep->keyframeSizes[k]);
+}
+
+int CombatReplayStep(const CombatReplay *rep, CombatArena *arena, CombatEventQueue *events)
+{
+    float step = rep->header->dt;
+    if (rep->header->flags & REPLAY_FLAG_EVENT_STEP)
+        step = CombatNextStep(arena->units, arena->unitCount, arena->modifiers, &arena->projectiles,
+                              arena->fissures, rep->header->dt, rep->header->maxStep);
+    return CombatArenaTick(arena, step, events);
+}
+
+int CombatReplaySeek(const CombatReplay *rep, int tick, CombatArena *arena)
+{
+    if (!CombatReplayRestore(rep, tick, arena)) return -1;
+    int result = 0;
+    while (!result && arena->tickCount < tick) result = CombatReplayStep(rep, arena, NULL);
+    return result;
+}
+
+bool CombatReplayHashAt(const CombatReplay *rep, int tick, uint64_t *hash)
+{
+    int interval = rep->header->hashInterval;
+    if (tick < 0 || interval <= 0 || tick % interval != 0 || tick / interval >= rep->hashCount) return false;
+    memcpy(hash, rep->hashes + (size_t)(tick / interval) * sizeof(uint64_t), sizeof(uint64_t));
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "combat_sim.h"
+#include "net_protocol.h"
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Combat replays — compact, chunked binary recording of one battle.
+//
+//   header  magic, format/sim version, flags, dt, arena rng seed
+//   UNIT    the NetUnit array the players were sent (what MSG_COMBAT_START carried)
+//   KEYF    packed CombatArena state (PackCombatState) every keyframeInterval ticks,
+//           tick 0 included, so playback can seek without simulating from the start
+//   HASH    HashCombatState().all every hashInterval ticks, to detect divergence
+//   END     result, final tick and sim time
+//
+// A chunk is [tag:4][size:4][payload], so readers skip what they don't know. Files
+// are read in place (mmap) — nothing is parsed up front beyond the chunk index.
+// A 30 s battle is typically 10–30 KB.
+//------------------------------------------------------------------------------------
+#define REPLAY_MAGIC            0x594C5052u   // "RPLY"
+#define REPLAY_FORMAT_VERSION   1
+#define REPLAY_KEYFRAME_TICKS   300           // 5 s at 60 Hz
+#define REPLAY_HASH_TICKS       15
+#define REPLAY_MAX_KEYFRAMES    256
+
+#define REPLAY_CHUNK_TAG(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define REPLAY_CHUNK_UNITS    REPLAY_CHUNK_TAG('U', 'N', 'I', 'T')
+#define REPLAY_CHUNK_KEYFRAME REPLAY_CHUNK_TAG('K', 'E', 'Y', 'F')
+#define REPLAY_CHUNK_HASHES   REPLAY_CHUNK_TAG('H', 'A', 'S', 'H')
+#define REPLAY_CHUNK_END      REPLAY_CHUNK_TAG('E', 'N', 'D', ' ')
+
+// Step sizes come from CombatNextStep(dt, maxStep) instead of the fixed dt
+#define REPLAY_FLAG_EVENT_STEP 0x1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t formatVersion;
+    uint16_t headerSize;
+    uint32_t simVersion;        // COMBAT_SIM_VERSION of the recording build
+    uint32_t flags;
+    float dt;                   // fixed step (and base step in event mode)
+    float maxStep;              // event mode: CombatNextStep maxDt
+    uint32_t rngState[4];       // arena rng at the start of the battle
+    uint16_t round;
+    uint16_t hashInterval;
+    uint16_t keyframeInterval;
+} ReplayHeader;
+
+typedef struct __attribute__((packed)) {
+    int32_t result;
+    int32_t tickCount;
+    float simTime;
+} ReplayEnd;
+
+//------------------------------------------------------------------------------------
+// Recorder — call Tick after every CombatArenaTick; output builds in memory
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint8_t *data;
+    int size, cap;
+    uint64_t *hashes;           // buffered until End writes the HASH chunk
+    int hashCount, hashCap;
+    ReplayHeader header;
+    bool failed;                // allocation failed; output is unusable
+    bool finished;
+} CombatRecorder;
+
+// arena: state after CombatArenaBegin. netUnits may be NULL (no UNIT chunk).
+void CombatRecorderBegin(CombatRecorder *rec, const CombatArena *arena,
+                         const NetUnit netUnits[], int netUnitCount,
+                         int round, uint32_t flags, float dt, float maxStep);
+void CombatRecorderTick(CombatRecorder *rec, const CombatArena *arena);
+void CombatRecorderEnd(CombatRecorder *rec, const CombatArena *arena, int result);
+bool CombatRecorderSave(const CombatRecorder *rec, const char *filepath);
+void CombatRecorderFree(CombatRecorder *rec);
+
+//------------------------------------------------------------------------------------
+// Playback — a read-only view over replay bytes (mapped file or cache blob)
+//------------------------------------------------------------------------------------
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    bool mapped;                // data came from CombatReplayMap
+    const ReplayHeader *header;
+    const NetUnit *netUnits;
+    int netUnitCount;
+    const uint8_t *keyframes[REPLAY_MAX_KEYFRAMES];
+    int keyframeSizes[REPLAY_MAX_KEYFRAMES];
+    int keyframeTicks[REPLAY_MAX_KEYFRAMES];
+    int keyframeCount;
+    const uint8_t *hashes;      // uint64 array, possibly unaligned
+    int hashCount;
+    ReplayEnd end;
+    bool hasEnd;
+} CombatReplay;
+
+// Index a replay held in memory (not copied; must outlive the view)
+bool CombatReplayOpen(CombatReplay *rep, const uint8_t *data, size_t size);
+// mmap a replay file and index it
+bool CombatReplayMap(CombatReplay *rep, const char *filepath);
+void CombatReplayClose(CombatReplay *rep);
+
+// Restore the last keyframe at or before tick; returns false if there is none
+bool CombatReplayRestore(const CombatReplay *rep, int tick, CombatArena *arena);
+// One sim step the way the recording stepped (fixed dt or event-driven)
+int CombatReplayStep(const CombatReplay *rep, CombatArena *arena, CombatEventQueue *events);
+// Restore and simulate forward to exactly tick; returns the tick result (0 = still fighting)
+int CombatReplaySeek(const CombatReplay *rep, int tick, CombatArena *arena);
+// Recorded hash for tick, if that tick was hashed
+bool CombatReplayHashAt(const CombatReplay *rep, int tick, uint64_t *hash);
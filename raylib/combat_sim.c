@@ -1,11 +1,87 @@
 #include "combat_sim.h"
+#include "combat_prof.h"
+#include "combat_math.h"
 #include <math.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
 
 #ifndef PI
 #define PI 3.14159265358979323846f
 #endif
 
+//------------------------------------------------------------------------------------
+// Combat event queue (SPSC)
+//------------------------------------------------------------------------------------
+static CombatEventBlock *NewEventBlock(CombatEventQueue *q)
+{
+    CombatEventBlock *b = atomic_exchange_explicit(&q->spare, NULL, memory_order_acquire);
+    if (!b) b = malloc(sizeof(*b));
+    if (!b) return NULL;
+    atomic_store_explicit(&b->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&b->next, NULL, memory_order_relaxed);
+    return b;
+}
+
+bool CombatEventQueueInit(CombatEventQueue *q)
+{
+    atomic_init(&q->spare, NULL);
+    q->head = q->tail = NewEventBlock(q);
+    q->readPos = 0;
+    return q->head != NULL;
+}
+
+void CombatEventQueueFree(CombatEventQueue *q)
+{
+    CombatEventBlock *b = q->head;
+    while (b) {
+        CombatEventBlock *next = atomic_load_explicit(&b->next, memory_order_relaxed);
+        free(b);
+        b = next;
+    }
+    free(atomic_exchange_explicit(&q->spare, NULL, memory_order_relaxed));
+    q->head = q->tail = NULL;
+    q->readPos = 0;
+}
+
+bool CombatEventPush(CombatEventQueue *q, const CombatEvent *ev)
+{
+    CombatEventBlock *b = q->tail;
+    int n = atomic_load_explicit(&b->count, memory_order_relaxed);
+    if (n == COMBAT_EVENT_BLOCK_SIZE) {
+        CombatEventBlock *nb = NewEventBlock(q);
+        if (!nb) return false;
+        // Release: the consumer sees the new block's zeroed count before its link
+        atomic_store_explicit(&b->next, nb, memory_order_release);
+        q->tail = b = nb;
+        n = 0;
+    }
+    b->events[n] = *ev;
+    atomic_store_explicit(&b->count, n + 1, memory_order_release);
+    return true;
+}
+
+bool CombatEventPop(CombatEventQueue *q, CombatEvent *out)
+{
+    CombatEventBlock *b = q->head;
+    if (q->readPos == COMBAT_EVENT_BLOCK_SIZE) {
+        CombatEventBlock *next = atomic_load_explicit(&b->next, memory_order_acquire);
+        if (!next) return false;
+        // The producer is done with b once it has linked next — hand it back
+        free(atomic_exchange_explicit(&q->spare, b, memory_order_acq_rel));
+        q->head = b = next;
+        q->readPos = 0;
+    }
+    if (q->readPos >= atomic_load_explicit(&b->count, memory_order_acquire)) return false;
+    *out = b->events[q->readPos++];
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// CombatTick
+//------------------------------------------------------------------------------------
 // Deterministic hash-based pseudo-random: produces 0.0–1.0 from game state
 static float det_roll(int a, int b, float hp)
 {
@@ -19,28 +95,91 @@ static float det_roll(int a, int b, float hp)
     return (float)(h & 0xFFFF) / 65535.0f;
 }
 
-static void EmitEvent(CombatEvent events[], int *eventCount, CombatEventType type,
-                      int unitIndex, int abilityId, Vector3 position, float v1, float v2)
+static void PushEvent(CombatEventQueue *events, const CombatEvent *ev)
+{
+    if (ev->type == COMBAT_EVT_ABILITY_CAST) PROF_COUNT(PROF_CNT_ABILITY_CASTS, 1);
+    if (events) CombatEventPush(events, ev);
+}
+
+static void EmitEvent(CombatEventQueue *events, CombatEventType type,
+                      int unitIndex, int sourceIndex, int abilityId, Vector3 position,
+                      float v1, float v2)
+{
+    CombatEvent ev = {
+        .type = type, .unitIndex = unitIndex, .sourceIndex = sourceIndex,
+        .abilityId = abilityId, .position = position, .value1 = v1, .value2 = v2
+    };
+    PushEvent(events, &ev);
+}
+
+// Ability credited for a projectile's hits and kills (-1 = basic attack)
+static int ProjectileAbility(ProjectileType type)
+{
+    switch (type) {
+    case PROJ_MAGIC_MISSILE: return ABILITY_MAGIC_MISSILE;
+    case PROJ_CHAIN_FROST:   return ABILITY_CHAIN_FROST;
+    case PROJ_HOOK:          return ABILITY_HOOK;
+    case PROJ_MAELSTROM:     return ABILITY_MAELSTROM;
+    default:                 return -1;
+    }
+}
+
+static void EmitProjectileEvent(CombatEventQueue *events, CombatEventType type,
+                                const Projectile *proj)
 {
-    if (!events || !eventCount) return;
-    if (*eventCount >= MAX_COMBAT_EVENTS) return;
-    events[*eventCount] = (CombatEvent){
-        .type = type, .unitIndex = unitIndex, .abilityId = abilityId,
-        .position = position, .value1 = v1, .value2 = v2
+    CombatEvent ev = {
+        .type = type, .unitIndex = proj->targetIndex, .sourceIndex = proj->sourceIndex,
+        .abilityId = ProjectileAbility(proj->type), .position = proj->position,
+        .color = proj->color
     };
-    (*eventCount)++;
+    PushEvent(events, &ev);
+}
+
+// Report the projectile a Spawn*Projectile call just appended (nothing if the pool was full)
+static void EmitProjectileSpawn(CombatEventQueue *events,
+                                const ProjectilePool *pool, int liveBefore)
+{
+    if (pool->liveCount <= liveBefore) return;
+    EmitProjectileEvent(events, COMBAT_EVT_PROJECTILE_SPAWN,
+                        &pool->items[pool->live[pool->liveCount - 1]]);
+}
+
+// Shield soaks damage first; returns what gets through
+static float AbsorbShield(Unit *u, float dmg)
+{
+    if (u->shieldHP > 0) {
+        if (dmg <= u->shieldHP) { u->shieldHP -= dmg; dmg = 0; }
+        else { dmg -= u->shieldHP; u->shieldHP = 0; }
+    }
+    return dmg;
+}
+
+// Apply final damage to a unit; kills it at 0 HP
+static void DamageUnit(Unit units[], int victim, int source, int abilityId, float dmg,
+                       CombatEventQueue *events)
+{
+    units[victim].currentHealth -= dmg;
+    EmitEvent(events, COMBAT_EVT_DAMAGE, victim, source, abilityId,
+              units[victim].position, dmg, 0);
+    if (units[victim].currentHealth <= 0) {
+        units[victim].active = false;
+        EmitEvent(events, COMBAT_EVT_KILL, victim, source, abilityId,
+                  units[victim].position, 0, 0);
+    }
 }
 
 int CombatTick(Unit units[], int unitCount,
                Modifier modifiers[],
-               Projectile projectiles[],
+               ProjectilePool *pool,
                Fissure fissures[],
                float dt,
-               CombatEvent events[], int *eventCount)
+               CombatEventQueue *events)
 {
-    if (eventCount) *eventCount = 0;
+    PROF_TICK();
 
     // === STEP 1: Tick modifiers ===
+    PROF_BEGIN(PROF_SEC_MODIFIERS);
+    PROF_COUNT(PROF_CNT_MODIFIER_SCANS, MAX_MODIFIERS);
     for (int m = 0; m < MAX_MODIFIERS; m++) {
         if (!modifiers[m].active) continue;
         int ui = modifiers[m].unitIndex;
@@ -64,11 +203,24 @@ int CombatTick(Unit units[], int unitCount,
 
     // === STEP 1b: Tick fissures ===
     if (fissures) UpdateFissures(fissures, dt);
+    PROF_END(PROF_SEC_MODIFIERS);
 
     // === STEP 2: Update projectiles ===
-    for (int p = 0; p < MAX_PROJECTILES; p++) {
-        if (!projectiles[p].active) continue;
+    PROF_BEGIN(PROF_SEC_PROJECTILES);
+    PROF_COUNT(PROF_CNT_PROJECTILE_STEPS, pool->liveCount);
+    // Walk the live list backwards so FreeProjectile's swap-remove never skips one
+    Projectile *projectiles = pool->items;
+    for (int k = pool->liveCount - 1; k >= 0; k--) {
+        int p = pool->live[k];
+        // Charge-up phase: stay in place and grow
+        if (projectiles[p].chargeTimer > 0) {
+            projectiles[p].chargeTimer -= dt;
+            if (projectiles[p].chargeTimer > 0) continue;
+            EmitProjectileEvent(events, COMBAT_EVT_PROJECTILE_LAUNCH, &projectiles[p]);
+        }
         int ti = projectiles[p].targetIndex;
+        int si = projectiles[p].sourceIndex;
+        int abilityId = ProjectileAbility(projectiles[p].type);
         // Target gone?
         if (ti < 0 || ti >= unitCount || !units[ti].active) {
             if ((projectiles[p].type == PROJ_CHAIN_FROST || projectiles[p].type == PROJ_MAELSTROM) && projectiles[p].bouncesRemaining > 0) {
@@ -76,50 +228,40 @@ int CombatTick(Unit units[], int unitCount,
                     projectiles[p].sourceTeam, projectiles[p].lastHitUnit, projectiles[p].bounceRange);
                 if (next >= 0) { projectiles[p].targetIndex = next; continue; }
             }
-            projectiles[p].active = false; continue;
+            FreeProjectile(pool, p); continue;
         }
         // Move toward target
         Vector3 tgt = { units[ti].position.x, units[ti].position.y + 3.0f, units[ti].position.z };
         float pdx = tgt.x - projectiles[p].position.x;
         float pdy = tgt.y - projectiles[p].position.y;
         float pdz = tgt.z - projectiles[p].position.z;
-        float pdist = sqrtf(pdx*pdx + pdy*pdy + pdz*pdz);
+        float pdist = CombatSqrt(pdx*pdx + pdy*pdy + pdz*pdz);
         float pstep = projectiles[p].speed * dt;
 
         if (pdist <= pstep) {
+            EmitProjectileEvent(events, COMBAT_EVT_PROJECTILE_IMPACT, &projectiles[p]);
             // HIT — Hook: damage by distance, then pull target to caster
             if (projectiles[p].type == PROJ_HOOK) {
                 if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                    float hookDist = DistXZ(units[ti].position, units[projectiles[p].sourceIndex].position);
-                    float hitDmg = hookDist * projectiles[p].damage;
-                    if (units[ti].shieldHP > 0) {
-                        if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                        else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                    }
-                    units[ti].currentHealth -= hitDmg;
-                    if (units[ti].currentHealth <= 0) {
-                        units[ti].active = false;
-                    } else {
+                    float hookDist = DistXZ(units[ti].position, units[si].position);
+                    float hitDmg = AbsorbShield(&units[ti], hookDist * projectiles[p].damage);
+                    DamageUnit(units, ti, si, abilityId, hitDmg, events);
+                    if (units[ti].active) {
                         // Start pulling target to caster
-                        units[ti].hookPullDest = units[projectiles[p].sourceIndex].position;
+                        units[ti].hookPullDest = units[si].position;
                         units[ti].hookPullSpeed = projectiles[p].speed;
                         AddModifier(modifiers, ti, MOD_STUN, 10.0f, 0); // stun during pull
                     }
-                    EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, ti, -1,
+                    EmitEvent(events, COMBAT_EVT_SHAKE, ti, -1, -1,
                               units[ti].position, 6.0f, 0.3f);
                 }
-                projectiles[p].active = false;
+                FreeProjectile(pool, p);
             }
             // HIT — Maelstrom: bounce like chain frost
             else if (projectiles[p].type == PROJ_MAELSTROM) {
                 if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                    float hitDmg = projectiles[p].damage;
-                    if (units[ti].shieldHP > 0) {
-                        if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                        else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                    }
-                    units[ti].currentHealth -= hitDmg;
-                    if (units[ti].currentHealth <= 0) units[ti].active = false;
+                    float hitDmg = AbsorbShield(&units[ti], projectiles[p].damage);
+                    DamageUnit(units, ti, si, abilityId, hitDmg, events);
                 }
                 if (projectiles[p].bouncesRemaining > 0) {
                     projectiles[p].bouncesRemaining--;
@@ -129,24 +271,20 @@ int CombatTick(Unit units[], int unitCount,
                     int next = FindChainFrostTarget(units, unitCount, units[ti].position,
                         projectiles[p].sourceTeam, ti, projectiles[p].bounceRange);
                     if (next >= 0) projectiles[p].targetIndex = next;
-                    else projectiles[p].active = false;
+                    else FreeProjectile(pool, p);
                 } else {
-                    projectiles[p].active = false;
+                    FreeProjectile(pool, p);
                 }
             }
             // HIT — Devil Bolt: flat damage ranged auto-attack
             else if (projectiles[p].type == PROJ_DEVIL_BOLT) {
-                int si = projectiles[p].sourceIndex;
                 if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
                     float hitDmg = projectiles[p].damage;
                     float armor = GetModifierValue(modifiers, ti, MOD_ARMOR);
                     hitDmg -= armor;
                     if (hitDmg < 0) hitDmg = 0;
-                    if (units[ti].shieldHP > 0) {
-                        if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                        else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                    }
-                    units[ti].currentHealth -= hitDmg;
+                    hitDmg = AbsorbShield(&units[ti], hitDmg);
+                    DamageUnit(units, ti, si, abilityId, hitDmg, events);
                     // Lifesteal from devil bolt
                     if (si >= 0 && si < unitCount && units[si].active) {
                         float ls = GetModifierValue(modifiers, si, MOD_LIFESTEAL);
@@ -156,9 +294,8 @@ int CombatTick(Unit units[], int unitCount,
                             if (units[si].currentHealth > maxHP) units[si].currentHealth = maxHP;
                         }
                     }
-                    if (units[ti].currentHealth <= 0) units[ti].active = false;
                 }
-                projectiles[p].active = false;
+                FreeProjectile(pool, p);
             }
             // HIT — normal (Magic Missile / Chain Frost)
             else {
@@ -166,17 +303,15 @@ int CombatTick(Unit units[], int unitCount,
                 float hitDmg = projectiles[p].damage;
                 if (projectiles[p].type == PROJ_MAGIC_MISSILE)
                     hitDmg *= UNIT_STATS[units[ti].typeIndex].health * units[ti].hpMultiplier;
-                if (units[ti].shieldHP > 0) {
-                    if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                    else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                }
-                units[ti].currentHealth -= hitDmg;
+                hitDmg = AbsorbShield(&units[ti], hitDmg);
+                DamageUnit(units, ti, si, abilityId, hitDmg, events);
                 if (projectiles[p].stunDuration > 0) {
                     AddModifier(modifiers, ti, MOD_STUN, projectiles[p].stunDuration, 0);
-                    EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, ti, -1,
+                    EmitEvent(events, COMBAT_EVT_STUN, ti, si, abilityId,
+                              units[ti].position, projectiles[p].stunDuration, 0);
+                    EmitEvent(events, COMBAT_EVT_SHAKE, ti, -1, -1,
                               units[ti].position, 5.0f, 0.25f);
                 }
-                if (units[ti].currentHealth <= 0) units[ti].active = false;
             }
             // Chain Frost bounce
             if (projectiles[p].type == PROJ_CHAIN_FROST && projectiles[p].bouncesRemaining > 0) {
@@ -187,9 +322,9 @@ int CombatTick(Unit units[], int unitCount,
                 int next = FindChainFrostTarget(units, unitCount, units[ti].position,
                     projectiles[p].sourceTeam, ti, projectiles[p].bounceRange);
                 if (next >= 0) projectiles[p].targetIndex = next;
-                else projectiles[p].active = false;
+                else FreeProjectile(pool, p);
             } else {
-                projectiles[p].active = false;
+                FreeProjectile(pool, p);
             }
             } // end else (normal projectile hit)
         } else {
@@ -199,7 +334,10 @@ int CombatTick(Unit units[], int unitCount,
         }
     }
 
+    PROF_END(PROF_SEC_PROJECTILES);
+
     // === STEP 3: Process each unit ===
+    PROF_BEGIN(PROF_SEC_UNITS);
     for (int i = 0; i < unitCount; i++)
     {
         if (!units[i].active) continue;
@@ -246,7 +384,7 @@ int CombatTick(Unit units[], int unitCount,
                             if (units[ally].currentHealth > allyMax) units[ally].currentHealth = allyMax;
                             slot->triggered = true;
                             slot->cooldownRemaining = def->cooldown[slot->level];
-                            EmitEvent(events, eventCount, COMBAT_EVT_ABILITY_CAST, i,
+                            EmitEvent(events, COMBAT_EVT_ABILITY_CAST, i, -1,
                                       ABILITY_SUNDER, units[i].position, 0, 0);
                         }
                     }
@@ -258,14 +396,14 @@ int CombatTick(Unit units[], int unitCount,
         if (units[i].hookPullSpeed > 0) {
             float hdx = units[i].hookPullDest.x - units[i].position.x;
             float hdz = units[i].hookPullDest.z - units[i].position.z;
-            float hlen = sqrtf(hdx*hdx + hdz*hdz);
+            float hlen = CombatSqrt(hdx*hdx + hdz*hdz);
             float hstep = units[i].hookPullSpeed * dt;
             if (hlen <= hstep) {
                 // Arrived at destination
                 units[i].position.x = units[i].hookPullDest.x;
                 units[i].position.z = units[i].hookPullDest.z;
                 units[i].hookPullSpeed = 0;
-                EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                           units[i].position, 6.0f, 0.3f);
                 // Remove the pull stun
                 for (int m = 0; m < MAX_MODIFIERS; m++) {
@@ -290,11 +428,11 @@ int CombatTick(Unit units[], int unitCount,
         if (target >= 0 && units[target].active) {
             float dx = units[target].position.x - units[i].position.x;
             float dz = units[target].position.z - units[i].position.z;
-            float goalAngle = atan2f(dx, dz) * (180.0f / PI);
+            float goalAngle = CombatAtan2Deg(dx, dz);
             float diff = goalAngle - units[i].facingAngle;
             while (diff > 180.0f) diff -= 360.0f;
             while (diff < -180.0f) diff += 360.0f;
-            float turnSpeed = 360.0f;
+            float turnSpeed = COMBAT_TURN_SPEED;
             if (fabsf(diff) < turnSpeed * dt)
                 units[i].facingAngle = goalAngle;
             else
@@ -330,12 +468,14 @@ int CombatTick(Unit units[], int unitCount,
             switch (slot->abilityId) {
             case ABILITY_MAGIC_MISSILE: {
                 if (target < 0) break;
-                SpawnProjectile(projectiles, PROJ_MAGIC_MISSILE,
+                int live = pool->liveCount;
+                SpawnProjectile(pool, PROJ_MAGIC_MISSILE,
                     units[i].position, target, i, units[i].team, slot->level,
                     def->values[slot->level][AV_MM_PROJ_SPEED],
                     def->values[slot->level][AV_MM_DAMAGE],
                     def->values[slot->level][AV_MM_STUN_DUR],
                     (Color){120, 80, 255, 255});
+                EmitProjectileSpawn(events, pool, live);
                 slot->cooldownRemaining = def->cooldown[slot->level];
                 castThisFrame = true;
             } break;
@@ -351,7 +491,9 @@ int CombatTick(Unit units[], int unitCount,
                         units[j].position.x = units[i].position.x;
                         units[j].position.z = units[i].position.z;
                         AddModifier(modifiers, j, MOD_STUN, stunDur, 0);
-                        EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, j, -1,
+                        EmitEvent(events, COMBAT_EVT_STUN, j, i, ABILITY_VACUUM,
+                                  units[j].position, stunDur, 0);
+                        EmitEvent(events, COMBAT_EVT_SHAKE, j, -1, -1,
                                   units[j].position, 5.0f, 0.25f);
                         hitAny = true;
                     }
@@ -362,12 +504,14 @@ int CombatTick(Unit units[], int unitCount,
             } break;
             case ABILITY_CHAIN_FROST: {
                 if (target < 0) break;
-                SpawnChainFrostProjectile(projectiles,
+                int live = pool->liveCount;
+                SpawnChainFrostProjectile(pool,
                     units[i].position, target, i, units[i].team, slot->level,
                     def->values[slot->level][AV_CF_PROJ_SPEED],
                     def->values[slot->level][AV_CF_DAMAGE],
                     (int)def->values[slot->level][AV_CF_BOUNCES],
                     def->values[slot->level][AV_CF_BOUNCE_RANGE]);
+                EmitProjectileSpawn(events, pool, live);
                 slot->cooldownRemaining = def->cooldown[slot->level];
                 castThisFrame = true;
             } break;
@@ -385,12 +529,10 @@ int CombatTick(Unit units[], int unitCount,
                     if (j == i || !units[j].active) continue;
                     if (UnitHasModifier(modifiers, j, MOD_INVULNERABLE)) continue;
                     float d = DistXZ(units[i].position, units[j].position);
-                    if (d <= radius) {
-                        units[j].currentHealth -= damage;
-                        if (units[j].currentHealth <= 0) units[j].active = false;
-                    }
+                    if (d <= radius)
+                        DamageUnit(units, j, i, ABILITY_EARTHQUAKE, damage, events);
                 }
-                EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                           units[i].position, 10.0f, 0.5f);
                 slot->cooldownRemaining = def->cooldown[slot->level];
                 castThisFrame = true;
@@ -431,7 +573,7 @@ int CombatTick(Unit units[], int unitCount,
                 // Deal damage in area along fissure line
                 float fdx = units[target].position.x - units[i].position.x;
                 float fdz = units[target].position.z - units[i].position.z;
-                float fdist = sqrtf(fdx * fdx + fdz * fdz);
+                float fdist = CombatSqrt(fdx * fdx + fdz * fdz);
                 float fnorm = (fdist > 0.001f) ? 1.0f / fdist : 0.0f;
                 for (int j = 0; j < unitCount; j++) {
                     if (j == i || !units[j].active) continue;
@@ -442,13 +584,11 @@ int CombatTick(Unit units[], int unitCount,
                     if (proj < 0 || proj > length) continue;
                     float perpX = ux - fdx * fnorm * proj;
                     float perpZ = uz - fdz * fnorm * proj;
-                    float perpDist = sqrtf(perpX * perpX + perpZ * perpZ);
-                    if (perpDist <= width + 3.0f) {
-                        units[j].currentHealth -= damage;
-                        if (units[j].currentHealth <= 0) units[j].active = false;
-                    }
+                    float perpDist = CombatSqrt(perpX * perpX + perpZ * perpZ);
+                    if (perpDist <= width + 3.0f)
+                        DamageUnit(units, j, i, ABILITY_FISSURE, damage, events);
                 }
-                EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                           units[i].position, 6.0f, 0.3f);
                 slot->cooldownRemaining = def->cooldown[slot->level];
                 castThisFrame = true;
@@ -486,7 +626,7 @@ int CombatTick(Unit units[], int unitCount,
                 float shieldDur = swDef->values[slot->level][AV_SW_SHIELD_DUR];
                 units[i].shieldHP = shieldHP;
                 AddModifier(modifiers, i, MOD_SHIELD, shieldDur, shieldHP);
-                EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1, units[i].position, 4.0f, 0.2f);
+                EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1, units[i].position, 4.0f, 0.2f);
                 slot->cooldownRemaining = swDef->cooldown[slot->level];
                 castThisFrame = true;
             } break;
@@ -518,10 +658,12 @@ int CombatTick(Unit units[], int unitCount,
                     hkd = DistXZ(units[i].position, units[hkTarget].position);
                     if (hkd > range) break;
                 }
-                SpawnHookProjectile(projectiles, units[i].position,
+                int live = pool->liveCount;
+                SpawnHookProjectile(pool, units[i].position,
                     hkTarget, i, units[i].team, slot->level,
                     hkDef->values[slot->level][AV_HK_SPEED],
                     hkDef->values[slot->level][AV_HK_DMG_PER_DIST], range);
+                EmitProjectileSpawn(events, pool, live);
                 slot->cooldownRemaining = hkDef->cooldown[slot->level];
                 castThisFrame = true;
             } break;
@@ -538,9 +680,14 @@ int CombatTick(Unit units[], int unitCount,
             default: break;
             }
             if (castThisFrame) {
-                EmitEvent(events, eventCount, COMBAT_EVT_ABILITY_CAST, i,
-                          slot->abilityId, units[i].position, 0, 0);
+                EmitEvent(events, COMBAT_EVT_ABILITY_CAST, i, -1,
+                          slot->abilityId, units[i].position, (float)slot->level, 0);
                 units[i].abilityCastDelay = 0.75f;
+                // Pause caster briefly for projectile abilities
+                if (slot->abilityId == ABILITY_MAGIC_MISSILE ||
+                    slot->abilityId == ABILITY_CHAIN_FROST ||
+                    slot->abilityId == ABILITY_HOOK)
+                    units[i].castPause = CAST_PAUSE_TIME;
             }
         }
 
@@ -570,23 +717,18 @@ int CombatTick(Unit units[], int unitCount,
                         if (UnitHasModifier(modifiers, j, MOD_INVULNERABLE)) continue;
                         float dd = DistXZ(units[ct].position, units[j].position);
                         if (dd <= pcRadius) {
-                            float dmgHit = pcDmg;
-                            if (units[j].shieldHP > 0) {
-                                if (dmgHit <= units[j].shieldHP) { units[j].shieldHP -= dmgHit; dmgHit = 0; }
-                                else { dmgHit -= units[j].shieldHP; units[j].shieldHP = 0; }
-                            }
-                            units[j].currentHealth -= dmgHit;
-                            if (units[j].currentHealth <= 0) units[j].active = false;
+                            float dmgHit = AbsorbShield(&units[j], pcDmg);
+                            DamageUnit(units, j, i, ABILITY_PRIMAL_CHARGE, dmgHit, events);
                             float kx = units[j].position.x - units[ct].position.x;
                             float kz = units[j].position.z - units[ct].position.z;
-                            float klen = sqrtf(kx*kx + kz*kz);
+                            float klen = CombatSqrt(kx*kx + kz*kz);
                             if (klen > 0.001f) {
                                 units[j].position.x += (kx/klen) * pcKnock;
                                 units[j].position.z += (kz/klen) * pcKnock;
                             }
                         }
                     }
-                    EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                    EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                               units[i].position, 8.0f, 0.4f);
                     units[i].chargeTarget = -1;
                     for (int m = 0; m < MAX_MODIFIERS; m++) {
@@ -596,7 +738,7 @@ int CombatTick(Unit units[], int unitCount,
                 } else {
                     float cdx = units[ct].position.x - units[i].position.x;
                     float cdz = units[ct].position.z - units[i].position.z;
-                    float clen = sqrtf(cdx*cdx + cdz*cdz);
+                    float clen = CombatSqrt(cdx*cdx + cdz*cdz);
                     units[i].position.x += (cdx/clen) * chargeSpeed * dt;
                     units[i].position.z += (cdz/clen) * chargeSpeed * dt;
                 }
@@ -604,6 +746,12 @@ int CombatTick(Unit units[], int unitCount,
             }
         }
 
+        // Cast pause — brief freeze after projectile cast
+        if (units[i].castPause > 0) {
+            units[i].castPause -= dt;
+            continue;
+        }
+
         // Movement + basic attack
         if (target < 0) continue;
         float moveSpeed = stats->movementSpeed * units[i].speedMultiplier;
@@ -619,7 +767,7 @@ int CombatTick(Unit units[], int unitCount,
             Vector3 oldPos = units[i].position;
             float dx = units[target].position.x - units[i].position.x;
             float dz = units[target].position.z - units[i].position.z;
-            float len = sqrtf(dx*dx + dz*dz);
+            float len = CombatSqrt(dx*dx + dz*dz);
             if (len > 0.001f) {
                 units[i].position.x += (dx/len) * moveSpeed * dt;
                 units[i].position.z += (dz/len) * moveSpeed * dt;
@@ -654,23 +802,24 @@ int CombatTick(Unit units[], int unitCount,
                 if (isDevil) {
                     // Devil ranged attack — spawn a bolt projectile
                     float dmg = stats->attackDamage * units[i].dmgMultiplier;
-                    SpawnProjectile(projectiles, PROJ_DEVIL_BOLT,
+                    int live = pool->liveCount;
+                    SpawnProjectile(pool, PROJ_DEVIL_BOLT,
                         units[i].position, target, i, units[i].team, 0,
                         50.0f, dmg, 0,
                         (Color){200, 50, 50, 255});
+                    EmitProjectileSpawn(events, pool, live);
                     units[i].attackCooldown = stats->attackSpeed;
+                    units[i].castPause = CAST_PAUSE_TIME;
                 } else {
                 if (!UnitHasModifier(modifiers, target, MOD_INVULNERABLE)) {
                     float dmg = stats->attackDamage * units[i].dmgMultiplier;
                     float armor = GetModifierValue(modifiers, target, MOD_ARMOR);
                     dmg -= armor;
                     if (dmg < 0) dmg = 0;
-                    // Shield absorption
-                    if (units[target].shieldHP > 0) {
-                        if (dmg <= units[target].shieldHP) { units[target].shieldHP -= dmg; dmg = 0; }
-                        else { dmg -= units[target].shieldHP; units[target].shieldHP = 0; }
-                    }
-                    units[target].currentHealth -= dmg;
+                    dmg = AbsorbShield(&units[target], dmg);
+                    EmitEvent(events, COMBAT_EVT_MELEE_HIT, target, i, -1,
+                              units[target].position, 0, 0);
+                    DamageUnit(units, target, i, -1, dmg, events);
                     // Lifesteal
                     float ls = GetModifierValue(modifiers, i, MOD_LIFESTEAL);
                     if (ls > 0) {
@@ -692,7 +841,9 @@ int CombatTick(Unit units[], int unitCount,
                                 }
                             }
                             AddModifier(modifiers, i, MOD_STUN, stunDur, 0);
-                            EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                            EmitEvent(events, COMBAT_EVT_STUN, i, target, ABILITY_CRAGGY_ARMOR,
+                                      units[i].position, stunDur, 0);
+                            EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                                       units[i].position, 3.0f, 0.15f);
                         }
                     }
@@ -708,23 +859,28 @@ int CombatTick(Unit units[], int unitCount,
                                 }
                             }
                             const AbilityDef *mlDef = &ABILITY_DEFS[ABILITY_MAELSTROM];
-                            SpawnMaelstromProjectile(projectiles,
+                            int live = pool->liveCount;
+                            SpawnMaelstromProjectile(pool,
                                 units[target].position, target, i, units[i].team, mlLvl,
                                 mlDef->values[mlLvl][AV_ML_SPEED],
                                 mlDef->values[mlLvl][AV_ML_DAMAGE],
                                 (int)mlDef->values[mlLvl][AV_ML_BOUNCES],
                                 mlDef->values[mlLvl][AV_ML_BOUNCE_RANGE]);
+                            EmitProjectileSpawn(events, pool, live);
                         }
                     }
-                    if (units[target].currentHealth <= 0) units[target].active = false;
                 }
                 units[i].attackCooldown = stats->attackSpeed;
+                EmitEvent(events, COMBAT_EVT_ATTACK, i, i, -1, units[i].position, 0, 0);
                 } // end else (non-devil melee)
             }
         }
     }
 
+    PROF_END(PROF_SEC_UNITS);
+
     // === STEP 4: Stone Gaze accumulation ===
+    PROF_BEGIN(PROF_SEC_GAZE);
     for (int i = 0; i < unitCount; i++) {
         if (!units[i].active) continue;
         bool beingGazed = false;
@@ -733,12 +889,11 @@ int CombatTick(Unit units[], int unitCount,
             if (!UnitHasModifier(modifiers, g, MOD_STONE_GAZE)) continue;
             float dx = units[g].position.x - units[i].position.x;
             float dz = units[g].position.z - units[i].position.z;
-            float distToGazer = sqrtf(dx*dx + dz*dz);
+            float distToGazer = CombatSqrt(dx*dx + dz*dz);
             if (distToGazer < 0.1f) continue;
             // Check if unit i is facing toward gazer g
-            float facingRad = units[i].facingAngle * (PI / 180.0f);
-            float faceDirX = sinf(facingRad);
-            float faceDirZ = cosf(facingRad);
+            float faceDirX = CombatSinDeg(units[i].facingAngle);
+            float faceDirZ = CombatCosDeg(units[i].facingAngle);
             float dot = (dx/distToGazer) * faceDirX + (dz/distToGazer) * faceDirZ;
             float coneAngle = 45.0f;
             for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
@@ -748,7 +903,7 @@ int CombatTick(Unit units[], int unitCount,
                     break;
                 }
             }
-            float coneThresh = cosf(coneAngle * (PI / 180.0f));
+            float coneThresh = CombatCosDeg(coneAngle);
             if (dot >= coneThresh) {
                 units[i].gazeAccum += dt;
                 beingGazed = true;
@@ -760,10 +915,10 @@ int CombatTick(Unit units[], int unitCount,
                         if (units[i].gazeAccum >= thresh) {
                             AddModifier(modifiers, i, MOD_STUN, stunDur, 0);
                             units[i].gazeAccum = 0;
-                            EmitEvent(events, eventCount, COMBAT_EVT_SHAKE, i, -1,
+                            EmitEvent(events, COMBAT_EVT_STUN, i, g, ABILITY_STONE_GAZE,
+                                      units[i].position, stunDur, 0);
+                            EmitEvent(events, COMBAT_EVT_SHAKE, i, -1, -1,
                                       units[i].position, 3.0f, 0.2f);
-                            EmitEvent(events, eventCount, COMBAT_EVT_ABILITY_CAST, i,
-                                      ABILITY_STONE_GAZE, units[i].position, 0, 0);
                         }
                         break;
                     }
@@ -777,11 +932,708 @@ int CombatTick(Unit units[], int unitCount,
         }
     }
 
+    PROF_END(PROF_SEC_GAZE);
+
     // === STEP 5: Check round end ===
+    PROF_BEGIN(PROF_SEC_END_CHECK);
     int ba, ra;
+    int result = 0;                         // still fighting
     CountTeams(units, unitCount, &ba, &ra);
-    if (ba == 0 && ra == 0) return 3; // draw
-    if (ra == 0) return 1;            // blue wins
-    if (ba == 0) return 2;            // red wins
-    return 0;                          // still fighting
+    if (ba == 0 && ra == 0) result = 3;     // draw
+    else if (ra == 0) result = 1;           // blue wins
+    else if (ba == 0) result = 2;           // red wins
+    PROF_END(PROF_SEC_END_CHECK);
+    return result;
+}
+
+//------------------------------------------------------------------------------------
+// Event-driven stepping
+//------------------------------------------------------------------------------------
+// Walking speed as applied by the movement code in CombatTick
+static float UnitMoveSpeed(Unit units[], Modifier modifiers[], int i)
+{
+    float speed = UNIT_STATS[units[i].typeIndex].movementSpeed * units[i].speedMultiplier;
+    float mult = GetModifierValue(modifiers, i, MOD_SPEED_MULT);
+    if (mult > 0) speed *= mult;
+    return speed;
+}
+
+// Signed degrees from unit i's facing to the direction of (dx, dz), in [-180, 180]
+static float FacingOffset(const Unit *u, float dx, float dz)
+{
+    float diff = CombatAtan2Deg(dx, dz) - u->facingAngle;
+    while (diff > 180.0f) diff -= 360.0f;
+    while (diff < -180.0f) diff += 360.0f;
+    return diff;
+}
+
+// Stone Gaze cone half-angle and buildup threshold of gazer g (CombatTick's lookup)
+static void GazeParams(const Unit *g, float *coneAngle, float *thresh)
+{
+    *coneAngle = 45.0f;
+    *thresh = 0.0f;
+    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+        if (g->abilities[a].abilityId != ABILITY_STONE_GAZE) continue;
+        int lvl = g->abilities[a].level;
+        *coneAngle = ABILITY_DEFS[ABILITY_STONE_GAZE].values[lvl][AV_SG_CONE_ANGLE];
+        *thresh = ABILITY_DEFS[ABILITY_STONE_GAZE].values[lvl][AV_SG_GAZE_THRESH];
+        return;
+    }
+}
+
+float CombatNextStep(Unit units[], int unitCount,
+                     Modifier modifiers[],
+                     ProjectilePool *pool,
+                     Fissure fissures[],
+                     float baseDt, float maxDt)
+{
+    float next = maxDt;
+    bool gazeActive = false;
+
+    // Modifier + fissure expiry
+    for (int m = 0; m < MAX_MODIFIERS; m++) {
+        if (!modifiers[m].active) continue;
+        if (modifiers[m].duration > 0) next = fminf(next, modifiers[m].duration);
+        if (modifiers[m].type == MOD_STONE_GAZE) gazeActive = true;
+    }
+    if (fissures) {
+        for (int f = 0; f < MAX_FISSURES; f++)
+            if (fissures[f].active) next = fminf(next, fissures[f].duration);
+    }
+
+    // Fastest walker bounds how quickly any gap can close
+    float maxSpeed = 0.0f;
+    for (int i = 0; i < unitCount; i++)
+        if (units[i].active) maxSpeed = fmaxf(maxSpeed, UnitMoveSpeed(units, modifiers, i));
+
+    // Projectile arrival (target may walk toward it)
+    const Projectile *projectiles = pool->items;
+    for (int k = 0; k < pool->liveCount; k++) {
+        int p = pool->live[k];
+        if (projectiles[p].chargeTimer > 0) {
+            next = fminf(next, projectiles[p].chargeTimer);
+            continue;
+        }
+        int ti = projectiles[p].targetIndex;
+        if (ti < 0 || ti >= unitCount || !units[ti].active) return baseDt; // retarget next tick
+        float pdx = units[ti].position.x - projectiles[p].position.x;
+        float pdy = units[ti].position.y + 3.0f - projectiles[p].position.y;
+        float pdz = units[ti].position.z - projectiles[p].position.z;
+        float pdist = CombatSqrt(pdx*pdx + pdy*pdy + pdz*pdz);
+        next = fminf(next, pdist / (projectiles[p].speed + maxSpeed));
+    }
+
+    // Per-unit timers, casts and approach
+    for (int i = 0; i < unitCount && next > baseDt; i++) {
+        if (!units[i].active) continue;
+        const UnitStats *stats = &UNIT_STATS[units[i].typeIndex];
+        float unitMaxHP = stats->health * units[i].hpMultiplier;
+
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            if (units[i].abilities[a].abilityId < 0) continue;
+            if (units[i].abilities[a].cooldownRemaining > 0)
+                next = fminf(next, units[i].abilities[a].cooldownRemaining);
+        }
+
+        if (units[i].hookPullSpeed > 0) {
+            float hlen = DistXZ(units[i].position, units[i].hookPullDest);
+            next = fminf(next, hlen / units[i].hookPullSpeed);
+            continue;
+        }
+        if (UnitHasModifier(modifiers, i, MOD_STUN)) continue;
+
+        // Passive about to fire (HP only changes on hits, which are events themselves)
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            AbilitySlot *slot = &units[i].abilities[a];
+            if (slot->abilityId != ABILITY_DIG && slot->abilityId != ABILITY_SUNDER) continue;
+            if (slot->triggered || slot->cooldownRemaining > 0) continue;
+            float threshold = (slot->abilityId == ABILITY_DIG)
+                ? ABILITY_DEFS[ABILITY_DIG].values[slot->level][AV_DIG_HP_THRESH]
+                : ABILITY_DEFS[ABILITY_SUNDER].values[slot->level][AV_SU_HP_THRESH];
+            if (units[i].currentHealth <= 0 || units[i].currentHealth > unitMaxHP * threshold) continue;
+            if (slot->abilityId == ABILITY_SUNDER && FindHighestHPAlly(units, unitCount, i) < 0) continue;
+            return baseDt;
+        }
+        if (UnitHasModifier(modifiers, i, MOD_DIG_HEAL)) continue;
+
+        int target = FindClosestEnemy(units, unitCount, i);
+        if (target < 0) continue;
+        float mySpeed = UnitMoveSpeed(units, modifiers, i);
+        float dist = DistXZ(units[i].position, units[target].position);
+
+        // Mid-turn: facing sweeps at COMBAT_TURN_SPEED, and Stone Gaze reads it every tick
+        float turn = fabsf(FacingOffset(&units[i], units[target].position.x - units[i].position.x,
+                                        units[target].position.z - units[i].position.z));
+        if (turn >= COMBAT_TURN_SPEED * baseDt) {
+            if (gazeActive) return baseDt;
+            next = fminf(next, turn / COMBAT_TURN_SPEED);
+        }
+
+        // Ready actives cast this tick unless still out of range
+        if (units[i].abilityCastDelay > 0) {
+            next = fminf(next, units[i].abilityCastDelay);
+        } else {
+            for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+                AbilitySlot *slot = &units[i].abilities[a];
+                if (slot->abilityId < 0 || slot->cooldownRemaining > 0) continue;
+                const AbilityDef *def = &ABILITY_DEFS[slot->abilityId];
+                if (def->isPassive) continue;
+                float castRange = def->range[slot->level];
+                if (castRange > 0 && dist > castRange)
+                    next = fminf(next, (dist - castRange) / (mySpeed + maxSpeed));
+                else
+                    return baseDt;
+            }
+        }
+
+        // Primal Charge closes at charge speed
+        if (units[i].chargeTarget >= 0) {
+            int ct = units[i].chargeTarget;
+            if (ct >= unitCount || !units[ct].active) return baseDt;
+            float chargeSpeed = GetModifierValue(modifiers, i, MOD_CHARGING);
+            if (chargeSpeed <= 0) chargeSpeed = 80.0f;
+            float chargeDist = DistXZ(units[i].position, units[ct].position);
+            next = fminf(next, (chargeDist - ATTACK_RANGE) / (chargeSpeed + maxSpeed));
+            continue;
+        }
+        if (units[i].castPause > 0) {
+            next = fminf(next, units[i].castPause);
+            continue;
+        }
+
+        float attackRange = (units[i].typeIndex == DEVIL_TYPE_INDEX) ? DEVIL_RANGED_RANGE : ATTACK_RANGE;
+        if (dist > attackRange) {
+            next = fminf(next, (dist - attackRange) / (mySpeed + maxSpeed));
+            if (mySpeed > 0) next = fminf(next, COMBAT_STEP_MAX_TRAVEL / mySpeed);
+        } else {
+            next = fminf(next, units[i].attackCooldown);
+        }
+    }
+
+    // Stone Gaze — buildup is linear while a unit faces a gazer and decays linearly
+    // otherwise, so the step ends at the threshold, at decay reaching zero, or when the
+    // unit could cross a cone edge. Walking turns the direction to the gazer and (via
+    // the target) the unit's facing by at most 2 * maxSpeed / distance rad/s each.
+    if (gazeActive) {
+        for (int i = 0; i < unitCount && next > baseDt; i++) {
+            if (!units[i].active) continue;
+            int t = units[i].targetIndex;
+            float targetDist = (t >= 0 && t < unitCount && units[t].active)
+                ? DistXZ(units[i].position, units[t].position) : 0.0f;
+            float faceRate = targetDist > 0.1f ? 2.0f * maxSpeed / targetDist : 0.0f;
+            bool gazed = false;
+            for (int g = 0; g < unitCount; g++) {
+                if (!units[g].active || units[g].team == units[i].team) continue;
+                if (!UnitHasModifier(modifiers, g, MOD_STONE_GAZE)) continue;
+                float dx = units[g].position.x - units[i].position.x;
+                float dz = units[g].position.z - units[i].position.z;
+                float distToGazer = CombatSqrt(dx*dx + dz*dz);
+                if (distToGazer < 0.1f) continue;
+                float coneAngle, thresh;
+                GazeParams(&units[g], &coneAngle, &thresh);
+                float offset = fabsf(FacingOffset(&units[i], dx, dz));
+                float rate = (2.0f * maxSpeed / distToGazer + faceRate) * (180.0f / PI);
+                if (rate > 0) next = fminf(next, fabsf(offset - coneAngle) / rate);
+                if (offset <= coneAngle) {
+                    next = fminf(next, thresh - units[i].gazeAccum);
+                    gazed = true;
+                    break;  // CombatTick only accumulates from the first gazer in view
+                }
+            }
+            if (!gazed && units[i].gazeAccum > 0) next = fminf(next, units[i].gazeAccum * 0.5f);
+        }
+    }
+
+    // Snap to the fixed-step grid by counting ticks the way fixed stepping burns a timer
+    // down (repeated -= baseDt until <= 0), so expiries land on the same tick even when
+    // rounding leaves a timer a hair above zero. Stop one tick short of the event: the
+    // tick it fires on must be a baseDt tick, or everything after it in CombatTick
+    // (walking, gaze, the unit a swap just moved) would get the whole jump's dt.
+    int maxSteps = (int)(maxDt / baseDt + 0.001f);
+    int steps = 0;
+    float left = next;
+    for (; left > 0 && steps < maxSteps; left -= baseDt) steps++;
+    if (left <= 0) steps--;
+    if (steps < 1) steps = 1;
+    return steps * baseDt;
+}
+
+//------------------------------------------------------------------------------------
+// Combat Arena + rollback history
+//------------------------------------------------------------------------------------
+void CombatArenaBegin(CombatArena *arena)
+{
+    memset(arena->modifiers, 0, sizeof(arena->modifiers));
+    memset(arena->fissures, 0, sizeof(arena->fissures));
+    InitProjectilePool(&arena->projectiles, 0);
+    arena->simTime = 0;
+    arena->tickCount = 0;
+}
+
+int CombatArenaTick(CombatArena *arena, float dt, CombatEventQueue *events)
+{
+    int result = CombatTick(arena->units, arena->unitCount, arena->modifiers,
+                            &arena->projectiles, arena->fissures, dt, events);
+    arena->simTime += dt;
+    arena->tickCount++;
+    return result;
+}
+
+void CombatHistoryInit(CombatHistory *h, CombatArena *frames, int capacity)
+{
+    h->frames = frames;
+    h->capacity = capacity;
+    h->head = 0;
+    h->count = 0;
+}
+
+void CombatHistoryPush(CombatHistory *h, const CombatArena *arena)
+{
+    if (h->capacity <= 0) return;
+    h->frames[h->head] = *arena;
+    h->head = (h->head + 1) % h->capacity;
+    if (h->count < h->capacity) h->count++;
+}
+
+const CombatArena *CombatHistoryPeek(const CombatHistory *h, int stepsBack)
+{
+    if (stepsBack < 0 || stepsBack >= h->count) return NULL;
+    int slot = (h->head - 1 - stepsBack + h->capacity) % h->capacity;
+    return &h->frames[slot];
+}
+
+bool CombatHistoryRewind(CombatHistory *h, int stepsBack, CombatArena *arena)
+{
+    const CombatArena *snap = CombatHistoryPeek(h, stepsBack);
+    if (!snap) return false;
+    *arena = *snap;
+    // The restored snapshot stays as the newest entry
+    h->head = (h->head - stepsBack + h->capacity) % h->capacity;
+    h->count -= stepsBack;
+    return true;
+}
+
+//------------------------------------------------------------------------------------
+// Combat profiling
+//------------------------------------------------------------------------------------
+const char *PROF_SECTION_NAMES[PROF_SEC_COUNT] = { "modifiers", "projectiles", "units", "gaze", "end_check" };
+const char *PROF_COUNTER_NAMES[PROF_CNT_COUNT] = { "queries", "modifier_scans", "projectile_steps", "ability_casts" };
+
+void CombatProfileReset(CombatProfile *prof)
+{
+    memset(prof, 0, sizeof(*prof));
+}
+
+void CombatProfileAdd(CombatProfile *dst, const CombatProfile *src)
+{
+    for (int i = 0; i < PROF_SEC_COUNT; i++) dst->ns[i] += src->ns[i];
+    for (int i = 0; i < PROF_CNT_COUNT; i++) dst->counters[i] += src->counters[i];
+    dst->ticks += src->ticks;
+    dst->battles += src->battles ? src->battles : 1;
+}
+
+int CombatProfileFormat(const CombatProfile *prof, char *buf, int bufSize)
+{
+    double ticks = prof->ticks ? (double)prof->ticks : 1.0;
+    uint64_t total = 0;
+    for (int i = 0; i < PROF_SEC_COUNT; i++) total += prof->ns[i];
+    int len = snprintf(buf, bufSize, "%llu ticks %.0f ns/tick |",
+                       (unsigned long long)prof->ticks, (double)total / ticks);
+    for (int i = 0; i < PROF_SEC_COUNT && len < bufSize; i++)
+        len += snprintf(buf + len, bufSize - len, " %s %.0f", PROF_SECTION_NAMES[i], (double)prof->ns[i] / ticks);
+    if (len < bufSize) len += snprintf(buf + len, bufSize - len, " |");
+    for (int i = 0; i < PROF_CNT_COUNT && len < bufSize; i++)
+        len += snprintf(buf + len, bufSize - len, " %s %.3g", PROF_COUNTER_NAMES[i], (double)prof->counters[i] / ticks);
+    return len;
+}
+
+#ifdef COMBAT_PROFILE
+_Thread_local CombatProfile *combatProfBound = NULL;
+
+void CombatProfileBind(CombatProfile *prof)
+{
+    combatProfBound = prof;
+}
+
+uint64_t CombatProfileNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+//------------------------------------------------------------------------------------
+// State hashing + diff
+//------------------------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    size_t offset;
+    bool isFloat;
+} StateField;
+
+#define SF_INT(s, f)   { #f, offsetof(s, f), false }
+#define SF_FLOAT(s, f) { #f, offsetof(s, f), true }
+
+static const StateField UNIT_STATE_FIELDS[] = {
+    SF_INT(Unit, typeIndex), SF_FLOAT(Unit, position.x), SF_FLOAT(Unit, position.y),
+    SF_FLOAT(Unit, position.z), SF_INT(Unit, team), SF_FLOAT(Unit, currentHealth),
+    SF_FLOAT(Unit, attackCooldown), SF_INT(Unit, targetIndex), SF_FLOAT(Unit, facingAngle),
+    SF_INT(Unit, nextAbilitySlot), SF_FLOAT(Unit, gazeAccum), SF_FLOAT(Unit, hpMultiplier),
+    SF_FLOAT(Unit, dmgMultiplier), SF_FLOAT(Unit, speedMultiplier), SF_FLOAT(Unit, shieldHP),
+    SF_FLOAT(Unit, abilityCastDelay), SF_INT(Unit, chargeTarget), SF_FLOAT(Unit, hookPullDest.x),
+    SF_FLOAT(Unit, hookPullDest.z), SF_FLOAT(Unit, hookPullSpeed),
+    SF_FLOAT(Unit, castPause),
+};
+static const StateField SLOT_STATE_FIELDS[] = {
+    SF_INT(AbilitySlot, abilityId), SF_INT(AbilitySlot, level), SF_FLOAT(AbilitySlot, cooldownRemaining),
+};
+static const StateField MODIFIER_STATE_FIELDS[] = {
+    SF_INT(Modifier, type), SF_INT(Modifier, unitIndex), SF_FLOAT(Modifier, duration),
+    SF_FLOAT(Modifier, maxDuration), SF_FLOAT(Modifier, value),
+};
+static const StateField PROJECTILE_STATE_FIELDS[] = {
+    SF_INT(Projectile, type), SF_FLOAT(Projectile, position.x), SF_FLOAT(Projectile, position.y),
+    SF_FLOAT(Projectile, position.z), SF_INT(Projectile, targetIndex), SF_INT(Projectile, sourceIndex),
+    SF_INT(Projectile, sourceTeam), SF_FLOAT(Projectile, speed), SF_FLOAT(Projectile, damage),
+    SF_FLOAT(Projectile, stunDuration), SF_INT(Projectile, bouncesRemaining),
+    SF_FLOAT(Projectile, bounceRange), SF_INT(Projectile, lastHitUnit), SF_INT(Projectile, level),
+    SF_FLOAT(Projectile, chargeTimer),
+};
+static const StateField FISSURE_STATE_FIELDS[] = {
+    SF_FLOAT(Fissure, position.x), SF_FLOAT(Fissure, position.z), SF_FLOAT(Fissure, rotation),
+    SF_FLOAT(Fissure, length), SF_FLOAT(Fissure, width), SF_FLOAT(Fissure, duration),
+    SF_INT(Fissure, sourceTeam), SF_INT(Fissure, sourceIndex),
+};
+#define FIELD_COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+// All hashed fields are 4-byte ints/enums/floats; floats compare by bit pattern
+static uint32_t FieldBits(const void *base, const StateField *f)
+{
+    uint32_t v;
+    memcpy(&v, (const char *)base + f->offset, sizeof(v));
+    return v;
+}
+
+static uint64_t HashFields(uint64_t h, const void *base, const StateField *fields, int count)
+{
+    for (int i = 0; i < count; i++) {
+        uint32_t v = FieldBits(base, &fields[i]);
+        for (int b = 0; b < 4; b++) {
+            h ^= (v >> (b * 8)) & 0xFF;
+            h *= 0x100000001B3ull;   // FNV-1a prime
+        }
+    }
+    return h;
+}
+
+#define FNV_OFFSET 0xCBF29CE484222325ull
+
+static uint64_t HashUnit(const Unit *u)
+{
+    uint64_t h = HashFields(FNV_OFFSET, u, UNIT_STATE_FIELDS, FIELD_COUNT(UNIT_STATE_FIELDS));
+    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+        h = HashFields(h, &u->abilities[a], SLOT_STATE_FIELDS, FIELD_COUNT(SLOT_STATE_FIELDS));
+        h ^= u->abilities[a].triggered; h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+CombatStateHash HashCombatState(const CombatArena *arena)
+{
+    CombatStateHash h = { .units = FNV_OFFSET };
+    for (int i = 0; i < arena->unitCount; i++) {
+        if (!arena->units[i].active) continue;
+        h.units ^= (uint64_t)i; h.units *= 0x100000001B3ull;
+        h.units ^= HashUnit(&arena->units[i]); h.units *= 0x100000001B3ull;
+    }
+    // Sets: sum of per-element hashes is independent of slot order
+    for (int m = 0; m < MAX_MODIFIERS; m++)
+        if (arena->modifiers[m].active)
+            h.modifiers += HashFields(FNV_OFFSET, &arena->modifiers[m], MODIFIER_STATE_FIELDS, FIELD_COUNT(MODIFIER_STATE_FIELDS));
+    for (int k = 0; k < arena->projectiles.liveCount; k++)
+        h.projectiles += HashFields(FNV_OFFSET, &arena->projectiles.items[arena->projectiles.live[k]],
+                                    PROJECTILE_STATE_FIELDS, FIELD_COUNT(PROJECTILE_STATE_FIELDS));
+    for (int f = 0; f < MAX_FISSURES; f++)
+        if (arena->fissures[f].active)
+            h.fissures += HashFields(FNV_OFFSET, &arena->fissures[f], FISSURE_STATE_FIELDS, FIELD_COUNT(FISSURE_STATE_FIELDS));
+    h.all = h.units;
+    h.all = (h.all ^ h.modifiers) * 0x100000001B3ull;
+    h.all = (h.all ^ h.projectiles) * 0x100000001B3ull;
+    h.all = (h.all ^ h.fissures) * 0x100000001B3ull;
+    return h;
+}
+
+static void FormatField(char *buf, int size, const void *base, const StateField *f)
+{
+    if (f->isFloat) {
+        float v; memcpy(&v, (const char *)base + f->offset, sizeof(v));
+        snprintf(buf, size, "%.9g", v);
+    } else {
+        int v; memcpy(&v, (const char *)base + f->offset, sizeof(v));
+        snprintf(buf, size, "%d", v);
+    }
+}
+
+// First field that differs between two structs; -1 if none
+static int FirstFieldDiff(const void *a, const void *b, const StateField *fields, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (FieldBits(a, &fields[i]) != FieldBits(b, &fields[i])) return i;
+    return -1;
+}
+
+static void ReportField(char *out, int outSize, const char *prefix,
+                        const void *a, const void *b, const StateField *f)
+{
+    char va[32], vb[32];
+    FormatField(va, sizeof(va), a, f);
+    FormatField(vb, sizeof(vb), b, f);
+    snprintf(out, outSize, "%s.%s: %s vs %s", prefix, f->name, va, vb);
+}
+
+// Set membership for the slot-order-independent arrays
+static bool ContainsElement(const void *elem, const void *items, size_t stride, const bool *alive,
+                            int count, const StateField *fields, int fieldCount)
+{
+    for (int i = 0; i < count; i++)
+        if (alive[i] && FirstFieldDiff(elem, (const char *)items + i * stride, fields, fieldCount) < 0)
+            return true;
+    return false;
+}
+
+static bool DiffSet(const char *label, const void *itemsA, const bool *aliveA, const void *itemsB,
+                    const bool *aliveB, size_t stride, int count, const StateField *fields,
+                    int fieldCount, char *out, int outSize)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        const void *src = pass ? itemsB : itemsA, *dst = pass ? itemsA : itemsB;
+        const bool *srcAlive = pass ? aliveB : aliveA, *dstAlive = pass ? aliveA : aliveB;
+        for (int i = 0; i < count; i++) {
+            if (!srcAlive[i]) continue;
+            const void *elem = (const char *)src + i * stride;
+            if (ContainsElement(elem, dst, stride, dstAlive, count, fields, fieldCount)) continue;
+            char desc[96] = "";
+            int len = 0;
+            for (int f = 0; f < fieldCount && f < 3; f++) {
+                char v[32];
+                FormatField(v, sizeof(v), elem, &fields[f]);
+                len += snprintf(desc + len, sizeof(desc) - len, "%s%s=%s", f ? " " : "", fields[f].name, v);
+            }
+            snprintf(out, outSize, "%s[%d] {%s...} only in %s", label, i, desc, pass ? "b" : "a");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DiffCombatState(const CombatArena *a, const CombatArena *b, char *out, int outSize)
+{
+    char prefix[48];
+    if (a->unitCount != b->unitCount) {
+        snprintf(out, outSize, "unitCount: %d vs %d", a->unitCount, b->unitCount);
+        return true;
+    }
+    for (int i = 0; i < a->unitCount; i++) {
+        const Unit *ua = &a->units[i], *ub = &b->units[i];
+        if (ua->active != ub->active) {
+            snprintf(out, outSize, "units[%d].active: %d vs %d", i, ua->active, ub->active);
+            return true;
+        }
+        if (!ua->active) continue;
+        snprintf(prefix, sizeof(prefix), "units[%d]", i);
+        int f = FirstFieldDiff(ua, ub, UNIT_STATE_FIELDS, FIELD_COUNT(UNIT_STATE_FIELDS));
+        if (f >= 0) { ReportField(out, outSize, prefix, ua, ub, &UNIT_STATE_FIELDS[f]); return true; }
+        for (int s = 0; s < MAX_ABILITIES_PER_UNIT; s++) {
+            snprintf(prefix, sizeof(prefix), "units[%d].abilities[%d]", i, s);
+            f = FirstFieldDiff(&ua->abilities[s], &ub->abilities[s], SLOT_STATE_FIELDS, FIELD_COUNT(SLOT_STATE_FIELDS));
+            if (f >= 0) { ReportField(out, outSize, prefix, &ua->abilities[s], &ub->abilities[s], &SLOT_STATE_FIELDS[f]); return true; }
+            if (ua->abilities[s].triggered != ub->abilities[s].triggered) {
+                snprintf(out, outSize, "%s.triggered: %d vs %d", prefix, ua->abilities[s].triggered, ub->abilities[s].triggered);
+                return true;
+            }
+        }
+    }
+
+    bool modA[MAX_MODIFIERS], modB[MAX_MODIFIERS];
+    for (int m = 0; m < MAX_MODIFIERS; m++) { modA[m] = a->modifiers[m].active; modB[m] = b->modifiers[m].active; }
+    if (DiffSet("modifiers", a->modifiers, modA, b->modifiers, modB, sizeof(Modifier), MAX_MODIFIERS,
+                MODIFIER_STATE_FIELDS, FIELD_COUNT(MODIFIER_STATE_FIELDS), out, outSize)) return true;
+
+    bool projA[MAX_PROJECTILES], projB[MAX_PROJECTILES];
+    for (int p = 0; p < MAX_PROJECTILES; p++) {
+        projA[p] = a->projectiles.livePos[p] >= 0;
+        projB[p] = b->projectiles.livePos[p] >= 0;
+    }
+    if (DiffSet("projectiles", a->projectiles.items, projA, b->projectiles.items, projB, sizeof(Projectile),
+                MAX_PROJECTILES, PROJECTILE_STATE_FIELDS, FIELD_COUNT(PROJECTILE_STATE_FIELDS), out, outSize)) return true;
+
+    bool fisA[MAX_FISSURES], fisB[MAX_FISSURES];
+    for (int f = 0; f < MAX_FISSURES; f++) { fisA[f] = a->fissures[f].active; fisB[f] = b->fissures[f].active; }
+    return DiffSet("fissures", a->fissures, fisA, b->fissures, fisB, sizeof(Fissure), MAX_FISSURES,
+                   FISSURE_STATE_FIELDS, FIELD_COUNT(FISSURE_STATE_FIELDS), out, outSize);
+}
+
+//------------------------------------------------------------------------------------
+// Compact state packing
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint8_t *buf;
+    int size, pos;
+    bool overflow;
+} PackWriter;
+
+typedef struct {
+    const uint8_t *buf;
+    int size, pos;
+    bool underflow;
+} PackReader;
+
+static void PackBytes(PackWriter *w, const void *src, int n)
+{
+    if (w->pos + n > w->size) { w->overflow = true; return; }
+    memcpy(w->buf + w->pos, src, n);
+    w->pos += n;
+}
+
+static void UnpackBytes(PackReader *r, void *dst, int n)
+{
+    if (r->pos + n > r->size) { r->underflow = true; memset(dst, 0, n); return; }
+    memcpy(dst, r->buf + r->pos, n);
+    r->pos += n;
+}
+
+static void PackU8(PackWriter *w, uint8_t v)   { PackBytes(w, &v, 1); }
+static void PackU16(PackWriter *w, uint16_t v) { PackBytes(w, &v, 2); }
+static uint8_t UnpackU8(PackReader *r)   { uint8_t v;  UnpackBytes(r, &v, 1); return v; }
+static uint16_t UnpackU16(PackReader *r) { uint16_t v; UnpackBytes(r, &v, 2); return v; }
+
+static void PackFields(PackWriter *w, const void *base, const StateField *fields, int count)
+{
+    for (int i = 0; i < count; i++) PackBytes(w, (const char *)base + fields[i].offset, 4);
+}
+
+static void UnpackFields(PackReader *r, void *base, const StateField *fields, int count)
+{
+    for (int i = 0; i < count; i++) UnpackBytes(r, (char *)base + fields[i].offset, 4);
+}
+
+int PackCombatState(const CombatArena *arena, uint8_t *buf, int bufSize)
+{
+    PackWriter w = { buf, bufSize, 0, false };
+    PackBytes(&w, &arena->simTime, 4);
+    PackBytes(&w, &arena->tickCount, 4);
+
+    PackU8(&w, (uint8_t)arena->unitCount);
+    for (int i = 0; i < arena->unitCount; i++) {
+        const Unit *u = &arena->units[i];
+        PackU8(&w, u->active);
+        if (!u->active) continue;
+        PackFields(&w, u, UNIT_STATE_FIELDS, FIELD_COUNT(UNIT_STATE_FIELDS));
+        PackBytes(&w, &u->scaleOverride, 4);
+        PackU8(&w, u->rarity);
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            PackFields(&w, &u->abilities[a], SLOT_STATE_FIELDS, FIELD_COUNT(SLOT_STATE_FIELDS));
+            PackU8(&w, u->abilities[a].triggered);
+        }
+    }
+
+    int mods = 0;
+    for (int m = 0; m < MAX_MODIFIERS; m++) mods += arena->modifiers[m].active;
+    PackU16(&w, (uint16_t)mods);
+    for (int m = 0; m < MAX_MODIFIERS; m++) {
+        if (!arena->modifiers[m].active) continue;
+        PackU16(&w, (uint16_t)m);
+        PackFields(&w, &arena->modifiers[m], MODIFIER_STATE_FIELDS, FIELD_COUNT(MODIFIER_STATE_FIELDS));
+    }
+
+    // Live order and free-list order decide which slot the next spawn gets and the
+    // order projectiles step in, so both travel with the state
+    const ProjectilePool *pool = &arena->projectiles;
+    PackU16(&w, (uint16_t)pool->capacity);
+    PackU16(&w, (uint16_t)pool->liveCount);
+    for (int k = 0; k < pool->liveCount; k++) {
+        const Projectile *p = &pool->items[pool->live[k]];
+        PackU16(&w, (uint16_t)pool->live[k]);
+        PackFields(&w, p, PROJECTILE_STATE_FIELDS, FIELD_COUNT(PROJECTILE_STATE_FIELDS));
+        PackBytes(&w, &p->chargeMax, 4);
+        PackBytes(&w, &p->color, 4);
+    }
+    PackU16(&w, (uint16_t)pool->freeCount);
+    for (int k = 0; k < pool->freeCount; k++) PackU16(&w, (uint16_t)pool->freeList[k]);
+
+    int fis = 0;
+    for (int f = 0; f < MAX_FISSURES; f++) fis += arena->fissures[f].active;
+    PackU8(&w, (uint8_t)fis);
+    for (int f = 0; f < MAX_FISSURES; f++) {
+        if (!arena->fissures[f].active) continue;
+        PackU8(&w, (uint8_t)f);
+        PackFields(&w, &arena->fissures[f], FISSURE_STATE_FIELDS, FIELD_COUNT(FISSURE_STATE_FIELDS));
+    }
+    return w.overflow ? -1 : w.pos;
+}
+
+bool UnpackCombatState(CombatArena *arena, const uint8_t *buf, int size)
+{
+    PackReader r = { buf, size, 0, false };
+    Rng rng = arena->rng;
+    memset(arena, 0, sizeof(*arena));
+    arena->rng = rng;
+    UnpackBytes(&r, &arena->simTime, 4);
+    UnpackBytes(&r, &arena->tickCount, 4);
+
+    arena->unitCount = UnpackU8(&r);
+    if (arena->unitCount > MAX_UNITS) return false;
+    for (int i = 0; i < arena->unitCount; i++) {
+        Unit *u = &arena->units[i];
+        u->active = UnpackU8(&r);
+        if (!u->active) continue;
+        UnpackFields(&r, u, UNIT_STATE_FIELDS, FIELD_COUNT(UNIT_STATE_FIELDS));
+        UnpackBytes(&r, &u->scaleOverride, 4);
+        u->rarity = UnpackU8(&r);
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            UnpackFields(&r, &u->abilities[a], SLOT_STATE_FIELDS, FIELD_COUNT(SLOT_STATE_FIELDS));
+            u->abilities[a].triggered = UnpackU8(&r);
+        }
+    }
+
+    int mods = UnpackU16(&r);
+    for (int k = 0; k < mods && !r.underflow; k++) {
+        int m = UnpackU16(&r);
+        if (m >= MAX_MODIFIERS) return false;
+        UnpackFields(&r, &arena->modifiers[m], MODIFIER_STATE_FIELDS, FIELD_COUNT(MODIFIER_STATE_FIELDS));
+        arena->modifiers[m].active = true;
+    }
+
+    ProjectilePool *pool = &arena->projectiles;
+    for (int p = 0; p < MAX_PROJECTILES; p++) pool->livePos[p] = -1;
+    pool->capacity = UnpackU16(&r);
+    pool->liveCount = UnpackU16(&r);
+    if (pool->capacity > MAX_PROJECTILES || pool->liveCount > pool->capacity) return false;
+    for (int k = 0; k < pool->liveCount; k++) {
+        int slot = UnpackU16(&r);
+        if (slot >= pool->capacity) return false;
+        Projectile *p = &pool->items[slot];
+        UnpackFields(&r, p, PROJECTILE_STATE_FIELDS, FIELD_COUNT(PROJECTILE_STATE_FIELDS));
+        UnpackBytes(&r, &p->chargeMax, 4);
+        UnpackBytes(&r, &p->color, 4);
+        p->active = true;
+        pool->live[k] = slot;
+        pool->livePos[slot] = k;
+    }
+    pool->freeCount = UnpackU16(&r);
+    if (pool->freeCount > pool->capacity) return false;
+    for (int k = 0; k < pool->freeCount; k++) {
+        pool->freeList[k] = UnpackU16(&r);
+        if (pool->freeList[k] >= pool->capacity) return false;
+    }
+
+    int fis = UnpackU8(&r);
+    for (int k = 0; k < fis && !r.underflow; k++) {
+        int f = UnpackU8(&r);
+        if (f >= MAX_FISSURES) return false;
+        UnpackFields(&r, &arena->fissures[f], FISSURE_STATE_FIELDS, FIELD_COUNT(FISSURE_STATE_FIELDS));
+        arena->fissures[f].active = true;
+    }
+    return !r.underflow;
 }
@@ -1,13 +1,137 @@
 #pragma once
 #include "game.h"
 #include "helpers.h"
+#include <stdatomic.h>
 
-// Deterministic combat tick — no rendering, no random calls.
+//------------------------------------------------------------------------------------
+// Combat event queue — unbounded single-producer/single-consumer FIFO. The sim
+// pushes, one consumer (render/audio, a replay writer) pops; events stay queued
+// across ticks until popped. Storage is a chain of fixed blocks, so nothing is
+// ever dropped or moved, and producer and consumer may sit on different threads
+// without locks. Drained blocks go back to the producer through `spare`.
+//------------------------------------------------------------------------------------
+#define COMBAT_EVENT_BLOCK_SIZE 128
+
+typedef struct CombatEventBlock {
+    CombatEvent events[COMBAT_EVENT_BLOCK_SIZE];
+    _Atomic int count;                          // events published in this block
+    struct CombatEventBlock *_Atomic next;      // set once the producer moves on
+} CombatEventBlock;
+
+typedef struct {
+    CombatEventBlock *head;                     // consumer: block being read
+    int readPos;                                // consumer: next slot in head
+    CombatEventBlock *tail;                     // producer: block being written
+    CombatEventBlock *_Atomic spare;            // one drained block for reuse
+} CombatEventQueue;
+
+bool CombatEventQueueInit(CombatEventQueue *q);
+// Neither side may be running
+void CombatEventQueueFree(CombatEventQueue *q);
+// Producer side; false only if a new block can't be allocated
+bool CombatEventPush(CombatEventQueue *q, const CombatEvent *ev);
+// Consumer side; false when nothing is pending
+bool CombatEventPop(CombatEventQueue *q, CombatEvent *out);
+
+// Bump whenever CombatTick can produce a different result for the same inputs;
+// cached outcomes and recorded replays from other versions are then ignored.
+// Fixed-point builds (combat_math.h) get their own version space.
+#ifdef COMBAT_FIXED_MATH
+#define COMBAT_SIM_VERSION (0x10000 | 1)
+#else
+#define COMBAT_SIM_VERSION 1
+#endif
+
+// Deterministic combat tick — no rendering, no random calls. The one combat sim:
+// the server runs it headless, the client runs it and plays the event stream.
 // Returns: 0 = still fighting, 1 = blue wins, 2 = red wins, 3 = draw
-// events[] is filled with visual feedback events (can be NULL for headless).
+// events receives what happened this tick (casts, hits, kills, stuns, projectile
+// spawn/launch/impact, shakes) for particles, sound and UI; NULL for headless.
 int CombatTick(Unit units[], int unitCount,
                Modifier modifiers[],
-               Projectile projectiles[],
+               ProjectilePool *pool,
                Fissure fissures[],
                float dt,
-               CombatEvent events[], int *eventCount);
+               CombatEventQueue *events);
+
+// Event-driven stepping — largest dt (a whole multiple of baseDt, capped at maxDt)
+// CombatTick can take before the next cooldown expiry, projectile arrival, modifier
+// expiry, unit entering range, turn completing or Stone Gaze buildup starting/stopping.
+// Returns baseDt whenever something happens next tick. Results are close to fixed
+// stepping, not identical; combat_diff --candidate event measures how close.
+#define COMBAT_STEP_MAX_TRAVEL 1.0f  // max walk per step (pursuit paths and collisions track fixed stepping)
+#define COMBAT_TURN_SPEED 360.0f     // degrees per second toward the target
+float CombatNextStep(Unit units[], int unitCount,
+                     Modifier modifiers[],
+                     ProjectilePool *pool,
+                     Fissure fissures[],
+                     float baseDt, float maxDt);
+
+//------------------------------------------------------------------------------------
+// Combat Arena — every piece of deterministic combat state in one contiguous block,
+// so a snapshot is a struct copy (single memcpy) and restore is the same copy back.
+// Particles, floating texts and shake are presentation only and live outside.
+//------------------------------------------------------------------------------------
+typedef struct {
+    Unit units[MAX_UNITS];
+    int unitCount;
+    Modifier modifiers[MAX_MODIFIERS];
+    ProjectilePool projectiles;
+    Fissure fissures[MAX_FISSURES];
+    float simTime;          // seconds simulated so far
+    int tickCount;          // CombatArenaTick calls so far
+    Rng rng;                // owner-seeded; waves/abilities rolled into this arena
+} CombatArena;
+
+// Reset modifiers/fissures and size the projectile pool for the units already in the arena
+void CombatArenaBegin(CombatArena *arena);
+// CombatTick on the arena's state; advances simTime/tickCount
+int CombatArenaTick(CombatArena *arena, float dt, CombatEventQueue *events);
+
+// Ring of the last N arena snapshots for rollback. Storage is owned by the caller
+// (a static array or a struct member) — the ring never allocates.
+typedef struct {
+    CombatArena *frames;
+    int capacity;
+    int head;               // slot the next push writes
+    int count;              // valid snapshots (<= capacity)
+} CombatHistory;
+
+void CombatHistoryInit(CombatHistory *h, CombatArena *frames, int capacity);
+// Copy the arena into the ring, overwriting the oldest snapshot when full
+void CombatHistoryPush(CombatHistory *h, const CombatArena *arena);
+// Snapshot stepsBack pushes ago (0 = most recent), or NULL if it has fallen off the ring
+const CombatArena *CombatHistoryPeek(const CombatHistory *h, int stepsBack);
+// Restore the snapshot stepsBack pushes ago into arena and drop everything newer
+// than it, so pushing again continues from the rewound point. Returns false if unavailable.
+bool CombatHistoryRewind(CombatHistory *h, int stepsBack, CombatArena *arena);
+
+//------------------------------------------------------------------------------------
+// State hashing + diff — for checking that a sim change didn't alter outcomes.
+// Only fields CombatTick reads or writes count (animFrame, hitFlash etc. don't).
+// Units hash in index order; modifiers, projectiles and fissures hash as sets so
+// slot placement alone never shows up as a divergence.
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint64_t units;
+    uint64_t modifiers;
+    uint64_t projectiles;
+    uint64_t fissures;
+    uint64_t all;           // combination of the four above
+} CombatStateHash;
+
+CombatStateHash HashCombatState(const CombatArena *arena);
+// Writes the first differing field ("units[3].currentHealth: 120.5 vs 118") to out.
+// Returns false when both states are identical.
+bool DiffCombatState(const CombatArena *a, const CombatArena *b, char *out, int outSize);
+
+//------------------------------------------------------------------------------------
+// Compact state packing — the hashed fields of live units, modifiers, projectiles
+// and fissures (plus pool ordering and the few visuals a viewer needs), a couple of
+// KB for a full board instead of the whole CombatArena. Unpacking restores a state
+// CombatTick continues from exactly. The arena's rng is left as it was.
+//------------------------------------------------------------------------------------
+#define COMBAT_PACK_MAX_SIZE (32 * 1024)   // upper bound for a full board
+// Returns bytes written, or -1 if bufSize is too small
+int PackCombatState(const CombatArena *arena, uint8_t *buf, int bufSize);
+bool UnpackCombatState(CombatArena *arena, const uint8_t *buf, int size);
@@ -0,0 +1,684 @@
+#include "combat_stream.h"
+#include <math.h>
+#include <string.h>
+
+#define STREAM_EVENT_BYTES 17
+#define STREAM_INTERP_DELAY 2.0f    // render this many snapshot intervals behind the newest
+
+#define UNIT_POS        0x01
+#define UNIT_POS_SMALL  0x02        // int8 step from the baseline position
+#define UNIT_FACING     0x04
+#define UNIT_HEALTH     0x08
+#define UNIT_STATE      0x10
+#define UNIT_GAZE       0x20
+#define UNIT_COOLDOWN   0x40
+
+//------------------------------------------------------------------------------------
+// Quantization
+//------------------------------------------------------------------------------------
+static uint16_t ClampU16(float q) { return q <= 0.0f ? 0 : q >= 65535.0f ? 65535 : (uint16_t)q; }
+static uint8_t ClampU8(float q) { return q <= 0.0f ? 0 : q >= 255.0f ? 255 : (uint8_t)q; }
+
+static int16_t QuantPos(float v)
+{
+    float q = roundf(v * STREAM_POS_SCALE);
+    return (int16_t)(q > 32767.0f ? 32767 : q < -32767.0f ? -32767 : q);
+}
+
+static uint8_t QuantAngle(float deg)
+{
+    float t = fmodf(deg, 360.0f);
+    if (t < 0.0f) t += 360.0f;
+    return (uint8_t)((int)roundf(t * (256.0f / 360.0f)) & 255);
+}
+
+// Absolute sim time something runs out; never 0 so 0 can mean "nothing pending"
+static uint16_t QuantExpiry(float now, float remaining)
+{
+    uint16_t q = ClampU16(roundf((now + remaining) * STREAM_TIME_SCALE));
+    return q ? q : 1;
+}
+
+static float DequantPos(int16_t q) { return (float)q / STREAM_POS_SCALE; }
+static float DequantAngle(uint8_t q) { return (float)q * (360.0f / 256.0f); }
+static float DequantTime(uint16_t q) { return (float)q / STREAM_TIME_SCALE; }
+
+static uint8_t ViewIndex(const StreamView *view, int index, int count)
+{
+    return (index >= 0 && index < count) ? view->remap[index] : 0xFF;
+}
+
+void StreamViewInit(StreamView *view, int unitCount, int swapAt, bool mirror)
+{
+    for (int i = 0; i < MAX_UNITS; i++) view->remap[i] = (uint8_t)i;
+    if (swapAt > 0 && swapAt < unitCount) {
+        for (int i = 0; i < unitCount; i++)
+            view->remap[i] = (uint8_t)(i < swapAt ? unitCount - swapAt + i : i - swapAt);
+    }
+    view->mirror = mirror;
+}
+
+void StreamCapture(const CombatArena *arena, const StreamView *view, StreamSnapshot *out)
+{
+    memset(out, 0, sizeof(*out));
+    float now = arena->simTime;
+    float zSign = view->mirror ? -1.0f : 1.0f;
+    int count = arena->unitCount;
+    out->simTime = now;
+    out->unitCount = (uint8_t)count;
+
+    for (int i = 0; i < count; i++) {
+        const Unit *u = &arena->units[i];
+        StreamUnit *su = &out->units[view->remap[i]];
+        su->x = QuantPos(u->position.x);
+        su->z = QuantPos(u->position.z * zSign);
+        su->facing = QuantAngle(view->mirror ? 180.0f - u->facingAngle : u->facingAngle);
+        su->flags = (u->active ? STREAM_UNIT_ACTIVE : 0) | (u->castPause > 0.0f ? STREAM_UNIT_CASTING : 0);
+        su->target = ViewIndex(view, u->targetIndex, count);
+        su->gaze = ClampU8(roundf(u->gazeAccum * 50.0f));
+        su->health = ClampU16(ceilf(u->currentHealth * STREAM_HP_SCALE));
+        su->shield = ClampU16(ceilf(u->shieldHP * STREAM_HP_SCALE));
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
+            float cd = u->abilities[a].cooldownRemaining;
+            su->readyAt[a] = cd > 0.0f ? QuantExpiry(now, cd) : 0;
+        }
+    }
+    for (int m = 0; m < MAX_MODIFIERS; m++) {
+        const Modifier *mod = &arena->modifiers[m];
+        if (!mod->active || mod->unitIndex < 0 || mod->unitIndex >= count) continue;
+        out->modifiers[m] = (StreamModifier){
+            .active = 1, .type = (uint8_t)mod->type, .unit = view->remap[mod->unitIndex],
+            .expireAt = QuantExpiry(now, mod->duration),
+            .maxDuration = ClampU16(roundf(mod->maxDuration * STREAM_TIME_SCALE)),
+        };
+    }
+    const ProjectilePool *pool = &arena->projectiles;
+    for (int l = 0; l < pool->liveCount; l++) {
+        int slot = pool->live[l];
+        const Projectile *p = &pool->items[slot];
+        out->projectiles[slot] = (StreamProjectile){
+            .active = 1, .type = (uint8_t)p->type,
+            .source = ViewIndex(view, p->sourceIndex, count),
+            .target = ViewIndex(view, p->targetIndex, count),
+            .x = QuantPos(p->position.x), .y = QuantPos(p->position.y),
+            .z = QuantPos(p->position.z * zSign),
+            .speed = ClampU16(roundf(p->speed * 16.0f)),
+            .r = p->color.r, .g = p->color.g, .b = p->color.b,
+            .chargeMax = ClampU8(roundf(p->chargeMax * 50.0f)),
+            .launchAt = p->chargeTimer > 0.0f ? QuantExpiry(now, p->chargeTimer) : 0,
+        };
+    }
+    for (int f = 0; f < MAX_FISSURES; f++) {
+        const Fissure *fi = &arena->fissures[f];
+        if (!fi->active) continue;
+        out->fissures[f] = (StreamFissure){
+            .active = 1,
+            .rotation = QuantAngle(view->mirror ? 180.0f - fi->rotation : fi->rotation),
+            .length = ClampU8(roundf(fi->length * 4.0f)),
+            .width = ClampU8(roundf(fi->width * 4.0f)),
+            .x = QuantPos(fi->position.x), .z = QuantPos(fi->position.z * zSign),
+            .expireAt = QuantExpiry(now, fi->duration),
+        };
+    }
+}
+
+// Same projectile as far as the client cares; position is flown client-side
+static bool SameProjectile(const StreamProjectile *a, const StreamProjectile *b)
+{
+    return a->active == b->active && a->type == b->type && a->source == b->source &&
+           a->target == b->target && a->speed == b->speed && a->r == b->r && a->g == b->g &&
+           a->b == b->b && a->chargeMax == b->chargeMax && a->launchAt == b->launchAt;
+}
+
+static bool SameModifier(const StreamModifier *a, const StreamModifier *b)
+{
+    return a->active == b->active && a->type == b->type && a->unit == b->unit &&
+           a->expireAt == b->expireAt && a->maxDuration == b->maxDuration;
+}
+
+static bool SameFissure(const StreamFissure *a, const StreamFissure *b)
+{
+    return a->active == b->active && a->rotation == b->rotation && a->length == b->length &&
+           a->width == b->width && a->x == b->x && a->z == b->z && a->expireAt == b->expireAt;
+}
+
+//------------------------------------------------------------------------------------
+// Wire format (little-endian)
+//
+//   [seq:2][baseSeq:2][flags:1][unitCount:1][simTime:4]
+//   [n:1]  units        [index:1][mask:1][fields in mask bit order]
+//   [n:1]  modifiers    [slot:1][active:1]{type, unit, expireAt:2, maxDuration:2}
+//   [n:2]  projectiles  [slot:1][active:1]{type, source, target, x, y, z, speed, rgb,
+//                                          chargeMax, launchAt}
+//   [n:1]  fissures     [slot:1][active:1]{rotation, length, width, x, z, expireAt}
+//   [n:1]  events       [type, unit, source, ability, x, y, z, value1, value2, rgb]
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint8_t *data;
+    int size, cap;
+    bool overflow;
+} StreamWriter;
+
+static void Put8(StreamWriter *w, uint8_t v)
+{
+    if (w->size + 1 > w->cap) { w->overflow = true; return; }
+    w->data[w->size++] = v;
+}
+
+static void Put16(StreamWriter *w, uint16_t v) { Put8(w, (uint8_t)v); Put8(w, (uint8_t)(v >> 8)); }
+
+static void PutFloat(StreamWriter *w, float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    Put16(w, (uint16_t)bits);
+    Put16(w, (uint16_t)(bits >> 16));
+}
+
+typedef struct {
+    const uint8_t *data;
+    int pos, size;
+    bool bad;
+} StreamReader;
+
+static uint8_t Get8(StreamReader *r)
+{
+    if (r->pos + 1 > r->size) { r->bad = true; return 0; }
+    return r->data[r->pos++];
+}
+
+static uint16_t Get16(StreamReader *r) { uint16_t lo = Get8(r); return (uint16_t)(lo | (Get8(r) << 8)); }
+
+static float GetFloat(StreamReader *r)
+{
+    uint32_t lo = Get16(r);
+    uint32_t bits = lo | ((uint32_t)Get16(r) << 16);
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+static void PutUnit(StreamWriter *w, int index, const StreamUnit *b, const StreamUnit *c)
+{
+    uint8_t mask = 0;
+    int dx = c->x - b->x, dz = c->z - b->z;
+    if (dx || dz) mask |= (dx >= -127 && dx <= 127 && dz >= -127 && dz <= 127) ? UNIT_POS_SMALL : UNIT_POS;
+    if (c->facing != b->facing) mask |= UNIT_FACING;
+    if (c->health != b->health || c->shield != b->shield) mask |= UNIT_HEALTH;
+    if (c->flags != b->flags || c->target != b->target) mask |= UNIT_STATE;
+    if (c->gaze != b->gaze) mask |= UNIT_GAZE;
+    uint8_t cdMask = 0;
+    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++)
+        if (c->readyAt[a] != b->readyAt[a]) cdMask |= (uint8_t)(1 << a);
+    if (cdMask) mask |= UNIT_COOLDOWN;
+    if (!mask) return;
+
+    Put8(w, (uint8_t)index);
+    Put8(w, mask);
+    if (mask & UNIT_POS) { Put16(w, (uint16_t)c->x); Put16(w, (uint16_t)c->z); }
+    if (mask & UNIT_POS_SMALL) { Put8(w, (uint8_t)(int8_t)dx); Put8(w, (uint8_t)(int8_t)dz); }
+    if (mask & UNIT_FACING) Put8(w, c->facing);
+    if (mask & UNIT_HEALTH) { Put16(w, c->health); Put16(w, c->shield); }
+    if (mask & UNIT_STATE) { Put8(w, c->flags); Put8(w, c->target); }
+    if (mask & UNIT_GAZE) Put8(w, c->gaze);
+    if (mask & UNIT_COOLDOWN) {
+        Put8(w, cdMask);
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++)
+            if (cdMask & (1 << a)) Put16(w, c->readyAt[a]);
+    }
+}
+
+static void GetUnit(StreamReader *r, StreamUnit *u)
+{
+    uint8_t mask = Get8(r);
+    if (mask & UNIT_POS) { u->x = (int16_t)Get16(r); u->z = (int16_t)Get16(r); }
+    if (mask & UNIT_POS_SMALL) { u->x += (int8_t)Get8(r); u->z += (int8_t)Get8(r); }
+    if (mask & UNIT_FACING) u->facing = Get8(r);
+    if (mask & UNIT_HEALTH) { u->health = Get16(r); u->shield = Get16(r); }
+    if (mask & UNIT_STATE) { u->flags = Get8(r); u->target = Get8(r); }
+    if (mask & UNIT_GAZE) u->gaze = Get8(r);
+    if (mask & UNIT_COOLDOWN) {
+        uint8_t cdMask = Get8(r);
+        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++)
+            if (cdMask & (1 << a)) u->readyAt[a] = Get16(r);
+    }
+}
+
+static void PutEvent(StreamWriter *w, const CombatEvent *ev, const StreamView *view, int unitCount)
+{
+    Put8(w, (uint8_t)ev->type);
+    Put8(w, ViewIndex(view, ev->unitIndex, unitCount));
+    Put8(w, ViewIndex(view, ev->sourceIndex, unitCount));
+    Put8(w, (uint8_t)(int8_t)ev->abilityId);
+    Put16(w, (uint16_t)QuantPos(ev->position.x));
+    Put16(w, (uint16_t)QuantPos(ev->position.y));
+    Put16(w, (uint16_t)QuantPos(view->mirror ? -ev->position.z : ev->position.z));
+    Put16(w, ClampU16(roundf(ev->value1 * 16.0f)));
+    Put16(w, ClampU16(roundf(ev->value2 * 16.0f)));
+    Put8(w, ev->color.r);
+    Put8(w, ev->color.g);
+    Put8(w, ev->color.b);
+}
+
+static void GetEvent(StreamReader *r, CombatEvent *ev)
+{
+    ev->type = (CombatEventType)Get8(r);
+    uint8_t unit = Get8(r), source = Get8(r);
+    ev->unitIndex = unit == 0xFF ? -1 : unit;
+    ev->sourceIndex = source == 0xFF ? -1 : source;
+    ev->abilityId = (int8_t)Get8(r);
+    ev->position.x = DequantPos((int16_t)Get16(r));
+    ev->position.y = DequantPos((int16_t)Get16(r));
+    ev->position.z = DequantPos((int16_t)Get16(r));
+    ev->value1 = (float)Get16(r) / 16.0f;
+    ev->value2 = (float)Get16(r) / 16.0f;
+    ev->color.r = Get8(r);
+    ev->color.g = Get8(r);
+    ev->color.b = Get8(r);
+    ev->color.a = 255;
+}
+
+int StreamEncode(const StreamSnapshot *base, const StreamSnapshot *cur,
+                 const CombatEvent events[], int eventCount, const StreamView *view,
+                 uint8_t *buf, int bufSize)
+{
+    static const StreamUnit noUnit = { 0 };
+    static const StreamModifier noModifier = { 0 };
+    static const StreamProjectile noProjectile = { 0 };
+    static const StreamFissure noFissure = { 0 };
+    StreamWriter w = { buf, 0, bufSize, false };
+
+    Put16(&w, cur->seq);
+    Put16(&w, base ? base->seq : STREAM_NO_BASE);
+    Put8(&w, cur->flags);
+    Put8(&w, cur->unitCount);
+    PutFloat(&w, cur->simTime);
+
+    int countAt = w.size, n = 0;
+    Put8(&w, 0);
+    for (int i = 0; i < cur->unitCount; i++) {
+        int before = w.size;
+        PutUnit(&w, i, base ? &base->units[i] : &noUnit, &cur->units[i]);
+        if (w.size != before) n++;
+    }
+    if (!w.overflow) buf[countAt] = (uint8_t)n;
+
+    countAt = w.size; n = 0;
+    Put8(&w, 0);
+    for (int m = 0; m < MAX_MODIFIERS; m++) {
+        const StreamModifier *b = base ? &base->modifiers[m] : &noModifier, *c = &cur->modifiers[m];
+        if (SameModifier(b, c)) continue;
+        Put8(&w, (uint8_t)m);
+        Put8(&w, c->active);
+        if (c->active) { Put8(&w, c->type); Put8(&w, c->unit); Put16(&w, c->expireAt); Put16(&w, c->maxDuration); }
+        n++;
+    }
+    if (!w.overflow) buf[countAt] = (uint8_t)n;
+
+    countAt = w.size; n = 0;
+    Put16(&w, 0);
+    for (int p = 0; p < MAX_PROJECTILES; p++) {
+        const StreamProjectile *b = base ? &base->projectiles[p] : &noProjectile, *c = &cur->projectiles[p];
+        if (SameProjectile(b, c)) continue;
+        Put8(&w, (uint8_t)p);
+        Put8(&w, c->active);
+        if (c->active) {
+            Put8(&w, c->type); Put8(&w, c->source); Put8(&w, c->target);
+            Put16(&w, (uint16_t)c->x); Put16(&w, (uint16_t)c->y); Put16(&w, (uint16_t)c->z);
+            Put16(&w, c->speed);
+            Put8(&w, c->r); Put8(&w, c->g); Put8(&w, c->b);
+            Put8(&w, c->chargeMax);
+            Put16(&w, c->launchAt);
+        }
+        n++;
+    }
+    if (!w.overflow) { buf[countAt] = (uint8_t)n; buf[countAt + 1] = (uint8_t)(n >> 8); }
+
+    countAt = w.size; n = 0;
+    Put8(&w, 0);
+    for (int f = 0; f < MAX_FISSURES; f++) {
+        const StreamFissure *b = base ? &base->fissures[f] : &noFissure, *c = &cur->fissures[f];
+        if (SameFissure(b, c)) continue;
+        Put8(&w, (uint8_t)f);
+        Put8(&w, c->active);
+        if (c->active) {
+            Put8(&w, c->rotation); Put8(&w, c->length); Put8(&w, c->width);
+            Put16(&w, (uint16_t)c->x); Put16(&w, (uint16_t)c->z);
+            Put16(&w, c->expireAt);
+        }
+        n++;
+    }
+    if (!w.overflow) buf[countAt] = (uint8_t)n;
+    if (w.overflow) return -1;
+
+    // Events last, as many as fit
+    countAt = w.size; n = 0;
+    Put8(&w, 0);
+    for (int e = 0; e < eventCount && n < STREAM_MAX_EVENTS; e++) {
+        if (w.size + STREAM_EVENT_BYTES > w.cap) break;
+        PutEvent(&w, &events[e], view, cur->unitCount);
+        n++;
+    }
+    if (w.overflow) return -1;
+    buf[countAt] = (uint8_t)n;
+    return w.size;
+}
+
+bool StreamMessageBase(const uint8_t *buf, int size, uint16_t *seq, uint16_t *baseSeq)
+{
+    StreamReader r = { buf, 0, size, false };
+    *seq = Get16(&r);
+    *baseSeq = Get16(&r);
+    return !r.bad;
+}
+
+bool StreamDecode(const StreamSnapshot *base, const uint8_t *buf, int size, StreamSnapshot *out,
+                  CombatEvent events[], int maxEvents, int *eventCount)
+{
+    StreamReader r = { buf, 0, size, false };
+    uint16_t seq = Get16(&r), baseSeq = Get16(&r);
+    if (r.bad) return false;
+    if (baseSeq != STREAM_NO_BASE && (!base || base->seq != baseSeq)) return false;
+    if (baseSeq == STREAM_NO_BASE) memset(out, 0, sizeof(*out));
+    else if (base != out) *out = *base;
+    out->seq = seq;
+    out->flags = Get8(&r);
+    out->unitCount = Get8(&r);
+    out->simTime = GetFloat(&r);
+    if (out->unitCount > MAX_UNITS) return false;
+
+    int n = Get8(&r);
+    for (int k = 0; k < n && !r.bad; k++) {
+        int i = Get8(&r);
+        if (i >= out->unitCount) return false;
+        GetUnit(&r, &out->units[i]);
+    }
+    n = Get8(&r);
+    for (int k = 0; k < n && !r.bad; k++) {
+        int m = Get8(&r);
+        if (m >= MAX_MODIFIERS) return false;
+        StreamModifier *mod = &out->modifiers[m];
+        memset(mod, 0, sizeof(*mod));
+        mod->active = Get8(&r);
+        if (mod->active) {
+            mod->type = Get8(&r); mod->unit = Get8(&r);
+            mod->expireAt = Get16(&r); mod->maxDuration = Get16(&r);
+        }
+    }
+    n = Get16(&r);
+    for (int k = 0; k < n && !r.bad; k++) {
+        StreamProjectile *p = &out->projectiles[Get8(&r)];
+        memset(p, 0, sizeof(*p));
+        p->active = Get8(&r);
+        if (p->active) {
+            p->type = Get8(&r); p->source = Get8(&r); p->target = Get8(&r);
+            p->x = (int16_t)Get16(&r); p->y = (int16_t)Get16(&r); p->z = (int16_t)Get16(&r);
+            p->speed = Get16(&r);
+            p->r = Get8(&r); p->g = Get8(&r); p->b = Get8(&r);
+            p->chargeMax = Get8(&r);
+            p->launchAt = Get16(&r);
+        }
+    }
+    n = Get8(&r);
+    for (int k = 0; k < n && !r.bad; k++) {
+        int f = Get8(&r);
+        if (f >= MAX_FISSURES) return false;
+        StreamFissure *fi = &out->fissures[f];
+        memset(fi, 0, sizeof(*fi));
+        fi->active = Get8(&r);
+        if (fi->active) {
+            fi->rotation = Get8(&r); fi->length = Get8(&r); fi->width = Get8(&r);
+            fi->x = (int16_t)Get16(&r); fi->z = (int16_t)Get16(&r);
+            fi->expireAt = Get16(&r);
+        }
+    }
+    n = Get8(&r);
+    int kept = 0;
+    for (int k = 0; k < n && !r.bad; k++) {
+        CombatEvent ev;
+        GetEvent(&r, &ev);
+        if (events && kept < maxEvents) events[kept++] = ev;
+    }
+    if (eventCount) *eventCount = kept;
+    return !r.bad;
+}
+
+//------------------------------------------------------------------------------------
+// Server side
+//------------------------------------------------------------------------------------
+void CombatStreamerBegin(CombatStreamer *st, int hz, const StreamView *view)
+{
+    memset(st, 0, sizeof(*st));
+    if (hz < STREAM_MIN_HZ) hz = STREAM_MIN_HZ;
+    if (hz > STREAM_MAX_HZ) hz = STREAM_MAX_HZ;
+    st->hz = hz;
+    st->view = *view;
+    st->ackedSeq = -1;
+}
+
+bool CombatStreamerDue(const CombatStreamer *st, float simTime)
+{
+    return st->hz > 0 && simTime >= st->nextSendTime;
+}
+
+int CombatStreamerEncode(CombatStreamer *st, const CombatArena *arena, bool final,
+                         const CombatEvent events[], int eventCount,
+                         uint8_t *buf, int bufSize)
+{
+    uint16_t seq = st->nextSeq;
+    // A baseline is usable while its history slot hasn't been reused
+    const StreamSnapshot *base = NULL;
+    if (st->ackedSeq >= 0 && seq - st->ackedSeq < STREAM_HISTORY)
+        base = &st->history[st->ackedSeq % STREAM_HISTORY];
+    StreamSnapshot *cur = &st->history[seq % STREAM_HISTORY];
+    StreamCapture(arena, &st->view, cur);
+    cur->seq = seq;
+    cur->flags = final ? STREAM_FLAG_FINAL : 0;
+    // Keep what the client will decode: unchanged projectiles keep the baseline record
+    if (base) {
+        for (int p = 0; p < MAX_PROJECTILES; p++)
+            if (SameProjectile(&base->projectiles[p], &cur->projectiles[p]))
+                cur->projectiles[p] = base->projectiles[p];
+    }
+    int size = StreamEncode(base, cur, events, eventCount, &st->view, buf, bufSize);
+    if (size < 0) return -1;
+    st->nextSeq++;
+    float period = 1.0f / (float)st->hz;
+    st->nextSendTime += period;
+    if (st->nextSendTime <= arena->simTime) st->nextSendTime = arena->simTime + period;
+    st->bytesSent += (uint64_t)size;
+    return size;
+}
+
+void CombatStreamerAck(CombatStreamer *st, uint16_t seq)
+{
+    if (seq < st->nextSeq && (int)seq > st->ackedSeq) st->ackedSeq = seq;
+}
+
+//------------------------------------------------------------------------------------
+// Client side
+//------------------------------------------------------------------------------------
+void StreamClientBegin(StreamClient *sc, CombatEventQueue *events)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->active = true;
+    sc->latestSeq = -1;
+    sc->shownSeq = -1;
+    sc->interval = 1.0f / STREAM_DEFAULT_HZ;
+    sc->events = events;
+}
+
+static const StreamSnapshot *ClientFrame(const StreamClient *sc, int seq)
+{
+    if (seq < 0 || seq > sc->latestSeq || sc->latestSeq - seq >= STREAM_HISTORY) return NULL;
+    const StreamSnapshot *f = &sc->frames[seq % STREAM_HISTORY];
+    return f->seq == (uint16_t)seq ? f : NULL;
+}
+
+bool StreamClientReceive(StreamClient *sc, const uint8_t *buf, int size, uint16_t *ackSeq)
+{
+    uint16_t seq, baseSeq;
+    if (!sc->active || !StreamMessageBase(buf, size, &seq, &baseSeq)) return false;
+    if ((int)seq <= sc->latestSeq) return false;
+    const StreamSnapshot *base = NULL;
+    if (baseSeq != STREAM_NO_BASE && !(base = ClientFrame(sc, baseSeq))) return false;
+
+    static CombatEvent events[STREAM_MAX_EVENTS];
+    int eventCount = 0;
+    StreamSnapshot *out = &sc->frames[seq % STREAM_HISTORY];
+    if (!StreamDecode(base, buf, size, out, events, STREAM_MAX_EVENTS, &eventCount)) {
+        out->seq = STREAM_NO_BASE;     // slot no longer holds a valid frame
+        return false;
+    }
+    const StreamSnapshot *prev = ClientFrame(sc, sc->latestSeq);
+    if (prev && out->simTime > prev->simTime)
+        sc->interval += (out->simTime - prev->simTime - sc->interval) * 0.1f;
+    sc->latestSeq = seq;
+    if (out->flags & STREAM_FLAG_FINAL) {
+        sc->finalSeen = true;
+        sc->finalTime = out->simTime;
+    }
+    // Events surface when render time reaches the snapshot that carried them
+    for (int e = 0; e < eventCount && sc->pendingCount < STREAM_MAX_PENDING; e++) {
+        StreamPendingEvent *pe = &sc->pending[(sc->pendingHead + sc->pendingCount++) % STREAM_MAX_PENDING];
+        pe->event = events[e];
+        pe->time = out->simTime;
+    }
+    sc->bytesReceived += (uint64_t)size;
+    *ackSeq = seq;
+    return true;
+}
+
+static void InitClientProjectile(Projectile *p, const StreamProjectile *sp)
+{
+    *p = (Projectile){
+        .type = (ProjectileType)sp->type,
+        .position = { DequantPos(sp->x), DequantPos(sp->y), DequantPos(sp->z) },
+        .targetIndex = sp->target == 0xFF ? -1 : sp->target,
+        .sourceIndex = sp->source == 0xFF ? -1 : sp->source,
+        .speed = (float)sp->speed / 16.0f,
+        .color = { sp->r, sp->g, sp->b, 255 },
+        .chargeMax = (float)sp->chargeMax / 50.0f,
+        .active = true,
+    };
+}
+
+void StreamClientApply(StreamClient *sc, double now,
+                       Unit units[], Modifier modifiers[],
+                       ProjectilePool *pool, Fissure fissures[])
+{
+    const StreamSnapshot *latest = ClientFrame(sc, sc->latestSeq);
+    if (!latest) return;
+
+    // Render time follows wall time, nudged toward a fixed delay behind the newest
+    // snapshot; after the final one it just runs out to the end
+    float dt = sc->lastNow > 0.0 ? (float)(now - sc->lastNow) : 0.0f;
+    double target = latest->simTime - sc->interval * STREAM_INTERP_DELAY;
+    if (sc->lastNow <= 0.0) sc->renderTime = target;
+    else {
+        sc->renderTime += dt;
+        double error = target - sc->renderTime;
+        if (!sc->finalSeen) sc->renderTime += fabs(error) > 0.5 ? error : error * 0.05;
+    }
+    sc->lastNow = now;
+    if (sc->renderTime > latest->simTime) sc->renderTime = latest->simTime;
+    float rt = (float)sc->renderTime;
+
+    // a = newest frame at or before render time, b = the one after it
+    int seqA = sc->latestSeq;
+    while (ClientFrame(sc, seqA - 1) && ClientFrame(sc, seqA)->simTime > rt) seqA--;
+    const StreamSnapshot *a = ClientFrame(sc, seqA);
+    const StreamSnapshot *b = ClientFrame(sc, seqA + 1);
+    if (!b) b = a;
+    float alpha = 0.0f;
+    if (b->simTime > a->simTime) alpha = (rt - a->simTime) / (b->simTime - a->simTime);
+    if (alpha < 0.0f) alpha = 0.0f;
+    if (alpha > 1.0f) alpha = 1.0f;
+
+    for (int i = 0; i < a->unitCount; i++) {
+        const StreamUnit *ua = &a->units[i], *ub = &b->units[i];
+        Unit *u = &units[i];
+        u->position.x = DequantPos(ua->x) + (DequantPos(ub->x) - DequantPos(ua->x)) * alpha;
+        u->position.z = DequantPos(ua->z) + (DequantPos(ub->z) - DequantPos(ua->z)) * alpha;
+        float fa = DequantAngle(ua->facing);
+        float dFacing = fmodf(DequantAngle(ub->facing) - fa + 540.0f, 360.0f) - 180.0f;
+        u->facingAngle = fa + dFacing * alpha;
+        u->active = (ua->flags & STREAM_UNIT_ACTIVE) != 0;
+        u->castPause = (ua->flags & STREAM_UNIT_CASTING) ? 0.1f : 0.0f;
+        u->targetIndex = ua->target == 0xFF ? -1 : ua->target;
+        u->currentHealth = (float)ua->health / STREAM_HP_SCALE;
+        u->shieldHP = (float)ua->shield / STREAM_HP_SCALE;
+        u->gazeAccum = (float)ua->gaze / 50.0f;
+        for (int s = 0; s < MAX_ABILITIES_PER_UNIT; s++) {
+            float cd = ua->readyAt[s] ? DequantTime(ua->readyAt[s]) - rt : 0.0f;
+            u->abilities[s].cooldownRemaining = cd > 0.0f ? cd : 0.0f;
+        }
+    }
+
+    while (sc->pendingCount > 0 && sc->pending[sc->pendingHead].time <= rt) {
+        if (sc->events) CombatEventPush(sc->events, &sc->pending[sc->pendingHead].event);
+        sc->pendingHead = (sc->pendingHead + 1) % STREAM_MAX_PENDING;
+        sc->pendingCount--;
+    }
+
+    for (int m = 0; m < MAX_MODIFIERS; m++) {
+        const StreamModifier *sm = &a->modifiers[m];
+        if (!sm->active) { modifiers[m].active = false; continue; }
+        float remaining = DequantTime(sm->expireAt) - rt;
+        modifiers[m] = (Modifier){
+            .type = (ModifierType)sm->type, .unitIndex = sm->unit,
+            .duration = remaining > 0.0f ? remaining : 0.0f,
+            .maxDuration = DequantTime(sm->maxDuration), .active = true,
+        };
+    }
+    for (int f = 0; f < MAX_FISSURES; f++) {
+        const StreamFissure *sf = &a->fissures[f];
+        float remaining = DequantTime(sf->expireAt) - rt;
+        fissures[f] = (Fissure){
+            .position = { DequantPos(sf->x), 0.0f, DequantPos(sf->z) },
+            .rotation = DequantAngle(sf->rotation),
+            .length = (float)sf->length / 4.0f, .width = (float)sf->width / 4.0f,
+            .duration = remaining > 0.0f ? remaining : 0.0f,
+            .active = sf->active != 0, .sourceIndex = -1,
+        };
+    }
+
+    // Projectiles start from their spawn record and home in on the target locally
+    if (seqA != sc->shownSeq) {
+        for (int p = 0; p < MAX_PROJECTILES; p++) {
+            const StreamProjectile *sp = &a->projectiles[p];
+            if (!sp->active) sc->projectiles[p].active = false;
+            else if (!SameProjectile(sp, &sc->projectileKeys[p])) InitClientProjectile(&sc->projectiles[p], sp);
+            sc->projectileKeys[p] = *sp;
+        }
+        sc->shownSeq = seqA;
+    }
+    InitProjectilePool(pool, MAX_PROJECTILES);
+    for (int p = 0; p < MAX_PROJECTILES; p++) {
+        Projectile *pr = &sc->projectiles[p];
+        if (!pr->active) continue;
+        uint16_t launchAt = sc->projectileKeys[p].launchAt;
+        float charge = launchAt ? DequantTime(launchAt) - rt : 0.0f;
+        pr->chargeTimer = charge > 0.0f ? charge : 0.0f;
+        int t = pr->targetIndex;
+        if (pr->chargeTimer <= 0.0f && t >= 0 && t < a->unitCount) {
+            Vector3 tgt = { units[t].position.x, units[t].position.y + 3.0f, units[t].position.z };
+            float dx = tgt.x - pr->position.x, dy = tgt.y - pr->position.y, dz = tgt.z - pr->position.z;
+            float dist = sqrtf(dx*dx + dy*dy + dz*dz);
+            float step = pr->speed * dt;
+            if (dist <= step || dist < 0.001f) pr->position = tgt;
+            else {
+                pr->position.x += dx / dist * step;
+                pr->position.y += dy / dist * step;
+                pr->position.z += dz / dist * step;
+            }
+        }
+        Projectile *slot = AllocProjectile(pool);
+        if (slot) *slot = *pr;
+    }
+}
+
+bool StreamClientFinished(const StreamClient *sc)
+{
+    return !sc->active || (sc->finalSeen && sc->renderTime >= sc->finalTime && sc->pendingCount == 0);
+}
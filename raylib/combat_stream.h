@@ -0,0 +1,162 @@
+#pragma once
+#include "combat_sim.h"
+#include <stdint.h>
+
+//------------------------------------------------------------------------------------
+// Authoritative combat stream — instead of every client running its own CombatTick,
+// the server samples the battle at a few Hz and sends each player a snapshot
+// delta-encoded against the last one that player acknowledged:
+//
+//   units        only those with a changed field; positions in 1/32 units (a small
+//                int8 step when it fits), facing in 256ths of a turn, HP and shield
+//                in 1/8 HP rounded up
+//   modifiers,   only slots that appeared, disappeared or were refreshed. Durations
+//   projectiles, and cooldowns travel as the sim time they run out, so they don't
+//   fissures     change while they tick down; the client counts them itself
+//   events       everything CombatTick emitted since the last snapshot, for sound,
+//                particles and UI exactly as a local sim would push them
+//
+// The client keeps the same history ring to decode against, renders a couple of
+// snapshot intervals behind the newest one and interpolates between the two that
+// bracket render time. Projectiles are sent once and flown client-side. A 16-unit
+// battle at 15 Hz is ~1–2 KB/s.
+//------------------------------------------------------------------------------------
+#define STREAM_DEFAULT_HZ     15
+#define STREAM_MIN_HZ         5
+#define STREAM_MAX_HZ         30
+#define STREAM_HISTORY        16        // snapshots kept as delta baselines (power of two)
+#define STREAM_NO_BASE        0xFFFF    // baseSeq of a full snapshot
+#define STREAM_MAX_EVENTS     128       // events carried by one snapshot
+#define STREAM_POS_SCALE      32.0f     // position units per world unit
+#define STREAM_HP_SCALE       8.0f
+#define STREAM_TIME_SCALE     20.0f     // expiry/cooldown times, ticks per second
+#define STREAM_FLAG_FINAL     0x1       // last snapshot of the battle
+
+#define STREAM_UNIT_ACTIVE    0x1
+#define STREAM_UNIT_CASTING   0x2       // castPause > 0 (cast animation)
+
+typedef struct {
+    int16_t x, z;
+    uint8_t facing;
+    uint8_t flags;                      // STREAM_UNIT_*
+    uint8_t target;                     // 0xFF = none
+    uint8_t gaze;                       // gazeAccum in 1/50 s
+    uint16_t health, shield;
+    uint16_t readyAt[MAX_ABILITIES_PER_UNIT];   // cooldown end, 0 = ready
+} StreamUnit;
+
+typedef struct {
+    uint8_t active, type, unit;
+    uint16_t expireAt, maxDuration;
+} StreamModifier;
+
+typedef struct {
+    uint8_t active, type, source, target;
+    int16_t x, y, z;
+    uint16_t speed;                     // 1/16 units per second
+    uint8_t r, g, b;
+    uint8_t chargeMax;                  // 1/50 s
+    uint16_t launchAt;                  // sim time charging ends
+} StreamProjectile;
+
+typedef struct {
+    uint8_t active, rotation, length, width;    // rotation in 256ths, sizes in 1/4 units
+    int16_t x, z;
+    uint16_t expireAt;
+} StreamFissure;
+
+typedef struct {
+    uint16_t seq;
+    uint8_t flags;                      // STREAM_FLAG_*
+    uint8_t unitCount;
+    float simTime;
+    StreamUnit units[MAX_UNITS];
+    StreamModifier modifiers[MAX_MODIFIERS];
+    StreamProjectile projectiles[MAX_PROJECTILES];
+    StreamFissure fissures[MAX_FISSURES];
+} StreamSnapshot;
+
+// How one player sees the battle: the server runs player 0 as blue, so player 1's
+// copy is mirrored about z = 0 with their own army first (as MSG_COMBAT_START sent it)
+typedef struct {
+    uint8_t remap[MAX_UNITS];           // server unit index -> view index
+    bool mirror;
+} StreamView;
+
+// swapAt > 0: units [swapAt, count) come first in the view, then [0, swapAt)
+void StreamViewInit(StreamView *view, int unitCount, int swapAt, bool mirror);
+// Quantize the arena into a snapshot from view's perspective
+void StreamCapture(const CombatArena *arena, const StreamView *view, StreamSnapshot *out);
+
+// Encode cur against base (NULL = full snapshot) plus events; returns bytes written
+// or -1 if the state alone doesn't fit. Events that don't fit are dropped.
+int StreamEncode(const StreamSnapshot *base, const StreamSnapshot *cur,
+                 const CombatEvent events[], int eventCount, const StreamView *view,
+                 uint8_t *buf, int bufSize);
+// Peek the baseline a message was encoded against (STREAM_NO_BASE = none)
+bool StreamMessageBase(const uint8_t *buf, int size, uint16_t *seq, uint16_t *baseSeq);
+// Decode onto base (NULL for a full snapshot); events may be NULL to skip them
+bool StreamDecode(const StreamSnapshot *base, const uint8_t *buf, int size, StreamSnapshot *out,
+                  CombatEvent events[], int maxEvents, int *eventCount);
+
+//------------------------------------------------------------------------------------
+// Server side — one per streaming player per battle
+//------------------------------------------------------------------------------------
+typedef struct {
+    int hz;                             // 0 = not streaming
+    StreamView view;
+    StreamSnapshot history[STREAM_HISTORY];
+    uint16_t nextSeq;
+    int ackedSeq;                       // -1 = nothing acknowledged yet
+    float nextSendTime;
+    uint64_t bytesSent;
+} CombatStreamer;
+
+void CombatStreamerBegin(CombatStreamer *st, int hz, const StreamView *view);
+bool CombatStreamerDue(const CombatStreamer *st, float simTime);
+// Capture and encode the next snapshot; returns payload size or -1
+int CombatStreamerEncode(CombatStreamer *st, const CombatArena *arena, bool final,
+                         const CombatEvent events[], int eventCount,
+                         uint8_t *buf, int bufSize);
+void CombatStreamerAck(CombatStreamer *st, uint16_t seq);
+
+//------------------------------------------------------------------------------------
+// Client side — decodes, buffers and interpolates; feeds events to the same queue
+// the local sim would
+//------------------------------------------------------------------------------------
+#define STREAM_MAX_PENDING 512
+
+typedef struct {
+    CombatEvent event;
+    float time;                         // released once render time reaches this
+} StreamPendingEvent;
+
+typedef struct {
+    bool active;
+    StreamSnapshot frames[STREAM_HISTORY];  // decoded, indexed by seq % STREAM_HISTORY
+    int latestSeq;                      // -1 = none yet
+    int shownSeq;                       // older of the two frames last applied
+    float interval;                     // smoothed spacing between snapshots
+    double renderTime;                  // sim time being shown
+    double lastNow;
+    bool finalSeen;
+    float finalTime;
+    Projectile projectiles[MAX_PROJECTILES];    // flown locally from spawn records
+    StreamProjectile projectileKeys[MAX_PROJECTILES];
+    StreamPendingEvent pending[STREAM_MAX_PENDING];
+    int pendingHead, pendingCount;
+    CombatEventQueue *events;
+    uint64_t bytesReceived;
+} StreamClient;
+
+void StreamClientBegin(StreamClient *sc, CombatEventQueue *events);
+// Decode one MSG_COMBAT_SNAPSHOT payload; returns false if it can't be decoded
+// (unknown baseline). *ackSeq receives the sequence number to acknowledge.
+bool StreamClientReceive(StreamClient *sc, const uint8_t *buf, int size, uint16_t *ackSeq);
+// Advance render time to now and write the interpolated state into the render
+// thread's copies, the same fields ClientSimApply fills
+void StreamClientApply(StreamClient *sc, double now,
+                       Unit units[], Modifier modifiers[],
+                       ProjectilePool *pool, Fissure fissures[]);
+// True once the final snapshot has been received and shown
+bool StreamClientFinished(const StreamClient *sc);
@@ -0,0 +1,141 @@
+#include "env_batch.h"
+#include "raymath.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool SameMaterial(const EnvBatchGroup *g, Material mat, Texture2D normal)
+{
+    Color a = g->material.maps[MATERIAL_MAP_DIFFUSE].color;
+    Color b = mat.maps[MATERIAL_MAP_DIFFUSE].color;
+    return g->material.shader.id == mat.shader.id &&
+           g->material.maps[MATERIAL_MAP_DIFFUSE].texture.id == mat.maps[MATERIAL_MAP_DIFFUSE].texture.id &&
+           g->material.maps[MATERIAL_MAP_METALNESS].texture.id == mat.maps[MATERIAL_MAP_METALNESS].texture.id &&
+           g->normalTexture.id == normal.id &&
+           a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static bool SamePiece(const EnvPiece *a, const EnvPiece *b)
+{
+    return a->modelIndex == b->modelIndex && a->active == b->active &&
+           a->position.x == b->position.x && a->position.y == b->position.y &&
+           a->position.z == b->position.z && a->rotationY == b->rotationY && a->scale == b->scale;
+}
+
+// The matrix DrawModelEx would build for this piece
+static Matrix PieceTransform(const EnvModelDef *emd, const EnvPiece *piece)
+{
+    Matrix m = MatrixMultiply(MatrixMultiply(MatrixScale(piece->scale, piece->scale, piece->scale),
+                                             MatrixRotateY(piece->rotationY * DEG2RAD)),
+                              MatrixTranslate(piece->position.x, piece->position.y, piece->position.z));
+    return MatrixMultiply(emd->model.transform, m);
+}
+
+static Vector3 TransformDir(Matrix m, float x, float y, float z)
+{
+    Vector3 v = { m.m0 * x + m.m4 * y + m.m8 * z,
+                  m.m1 * x + m.m5 * y + m.m9 * z,
+                  m.m2 * x + m.m6 * y + m.m10 * z };
+    return Vector3Normalize(v);
+}
+
+// Group index for a piece mesh, creating the group if needed; -1 when out of groups
+static int FindGroup(EnvBatch *batch, const EnvModelDef *emd, int meshIndex)
+{
+    Material mat = emd->model.materials[emd->model.meshMaterial[meshIndex]];
+    for (int g = 0; g < batch->groupCount; g++)
+        if (SameMaterial(&batch->groups[g], mat, emd->normalTexture)) return g;
+    if (batch->groupCount >= ENV_BATCH_MAX_GROUPS) return -1;
+    EnvBatchGroup *group = &batch->groups[batch->groupCount];
+    *group = (EnvBatchGroup){ .material = mat, .normalTexture = emd->normalTexture };
+    return batch->groupCount++;
+}
+
+void EnvBatchBuild(EnvBatch *batch, const EnvModelDef models[], const EnvPiece pieces[], int pieceCount)
+{
+    EnvBatchUnload(batch);
+    batch->sourceDraws = 0;
+
+    // Pass 1: group piece meshes by material and size the merged buffers
+    int vertexCounts[ENV_BATCH_MAX_GROUPS] = { 0 };
+    bool hasColors[ENV_BATCH_MAX_GROUPS] = { 0 };
+    for (int p = 0; p < pieceCount; p++) {
+        if (!pieces[p].active || !models[pieces[p].modelIndex].loaded) continue;
+        const EnvModelDef *emd = &models[pieces[p].modelIndex];
+        for (int m = 0; m < emd->model.meshCount; m++) {
+            int g = FindGroup(batch, emd, m);
+            if (g < 0) {
+                printf("[ENV] Out of batch groups, %s mesh %d not drawn\n", emd->name, m);
+                continue;
+            }
+            vertexCounts[g] += emd->model.meshes[m].triangleCount * 3;
+            if (emd->model.meshes[m].colors) hasColors[g] = true;
+            batch->sourceDraws++;
+        }
+    }
+    for (int g = 0; g < batch->groupCount; g++) {
+        Mesh *out = &batch->groups[g].mesh;
+        out->vertexCount = vertexCounts[g];
+        out->triangleCount = vertexCounts[g] / 3;
+        out->vertices = MemAlloc(vertexCounts[g] * 3 * sizeof(float));
+        out->normals = MemAlloc(vertexCounts[g] * 3 * sizeof(float));
+        out->texcoords = MemAlloc(vertexCounts[g] * 2 * sizeof(float));
+        out->tangents = MemAlloc(vertexCounts[g] * 4 * sizeof(float));
+        if (hasColors[g]) out->colors = MemAlloc(vertexCounts[g] * 4);
+    }
+
+    // Pass 2: bake each piece mesh into world space, expanding indices
+    int written[ENV_BATCH_MAX_GROUPS] = { 0 };
+    for (int p = 0; p < pieceCount; p++) {
+        if (!pieces[p].active || !models[pieces[p].modelIndex].loaded) continue;
+        const EnvModelDef *emd = &models[pieces[p].modelIndex];
+        Matrix xf = PieceTransform(emd, &pieces[p]);
+        Matrix nxf = MatrixTranspose(MatrixInvert(xf));
+        for (int m = 0; m < emd->model.meshCount; m++) {
+            int g = FindGroup(batch, emd, m);
+            if (g < 0) continue;
+            const Mesh *src = &emd->model.meshes[m];
+            Mesh *out = &batch->groups[g].mesh;
+            for (int k = 0; k < src->triangleCount * 3; k++) {
+                int v = src->indices ? src->indices[k] : k;
+                int o = written[g]++;
+                Vector3 pos = Vector3Transform((Vector3){ src->vertices[v*3], src->vertices[v*3 + 1],
+                                                          src->vertices[v*3 + 2] }, xf);
+                out->vertices[o*3] = pos.x; out->vertices[o*3 + 1] = pos.y; out->vertices[o*3 + 2] = pos.z;
+                Vector3 n = src->normals ? TransformDir(nxf, src->normals[v*3], src->normals[v*3 + 1],
+                                                        src->normals[v*3 + 2])
+                                         : (Vector3){ 0.0f, 1.0f, 0.0f };
+                out->normals[o*3] = n.x; out->normals[o*3 + 1] = n.y; out->normals[o*3 + 2] = n.z;
+                out->texcoords[o*2] = src->texcoords ? src->texcoords[v*2] : 0.0f;
+                out->texcoords[o*2 + 1] = src->texcoords ? src->texcoords[v*2 + 1] : 0.0f;
+                Vector3 t = src->tangents ? TransformDir(xf, src->tangents[v*4], src->tangents[v*4 + 1],
+                                                         src->tangents[v*4 + 2])
+                                          : (Vector3){ 1.0f, 0.0f, 0.0f };
+                out->tangents[o*4] = t.x; out->tangents[o*4 + 1] = t.y; out->tangents[o*4 + 2] = t.z;
+                out->tangents[o*4 + 3] = src->tangents ? src->tangents[v*4 + 3] : 1.0f;
+                if (out->colors) {
+                    for (int c = 0; c < 4; c++)
+                        out->colors[o*4 + c] = src->colors ? src->colors[v*4 + c] : 255;
+                }
+            }
+        }
+    }
+    for (int g = 0; g < batch->groupCount; g++) UploadMesh(&batch->groups[g].mesh, false);
+
+    batch->builtCount = pieceCount;
+    memcpy(batch->built, pieces, pieceCount * sizeof(EnvPiece));
+    printf("[ENV] Batched %d piece meshes into %d draws\n", batch->sourceDraws, batch->groupCount);
+}
+
+bool EnvBatchStale(const EnvBatch *batch, const EnvPiece pieces[], int pieceCount)
+{
+    if (pieceCount != batch->builtCount) return true;
+    for (int p = 0; p < pieceCount; p++)
+        if (!SamePiece(&batch->built[p], &pieces[p])) return true;
+    return false;
+}
+
+void EnvBatchUnload(EnvBatch *batch)
+{
+    for (int g = 0; g < batch->groupCount; g++) UnloadMesh(batch->groups[g].mesh);
+    batch->groupCount = 0;
+}
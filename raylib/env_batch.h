@@ -0,0 +1,30 @@
+#pragma once
+#include "game.h"
+
+//------------------------------------------------------------------------------------
+// Static environment batching — env pieces never move outside the layout editor, so
+// every mesh of every active piece is baked into world space once and merged with
+// the others that share its material (same diffuse, ORM and normal map). The scene
+// then draws one mesh per material instead of one DrawModelEx per piece and mesh.
+//------------------------------------------------------------------------------------
+#define ENV_BATCH_MAX_GROUPS 16
+
+typedef struct {
+    Mesh mesh;                  // world-space, non-indexed, uploaded once
+    Material material;          // source model's material (maps not owned)
+    Texture2D normalTexture;    // from the piece's EnvModelDef (id=0 if none)
+} EnvBatchGroup;
+
+typedef struct {
+    EnvBatchGroup groups[ENV_BATCH_MAX_GROUPS];
+    int groupCount;
+    int sourceDraws;            // per-piece mesh draws the groups replace
+    EnvPiece built[MAX_ENV_PIECES];     // layout the batch was built from
+    int builtCount;
+} EnvBatch;
+
+// (Re)build from the current layout; safe to call on a built batch
+void EnvBatchBuild(EnvBatch *batch, const EnvModelDef models[], const EnvPiece pieces[], int pieceCount);
+// True if the layout differs from the one last built
+bool EnvBatchStale(const EnvBatch *batch, const EnvPiece pieces[], int pieceCount);
+void EnvBatchUnload(EnvBatch *batch);
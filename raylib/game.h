@@ -20,11 +20,20 @@
 #define DEVIL_RANGED_RANGE 45.0f // devils stop and shoot from this distance
 #define DEVIL_TYPE_INDEX 2       // unit type index for the Devil
 #define UNIT_COLLISION_RADIUS 3.0f  // circle-circle push radius for unit separation
+#define CAST_PAUSE_TIME 0.25f    // caster freezes this long after firing a projectile
 #define BLUE_TEAM_MAX_SIZE 4   // player team cap (change this to rebalance)
 #define ARENA_BOUNDARY_Z   5.0f // blue units can't be placed below this Z (into red territory)
 #define ARENA_GRID_HALF  100.0f // half the visible grid (grid goes -100 to +100)
 #define MAX_WAVE_ENEMIES 8
 
+//------------------------------------------------------------------------------------
+// Random (xoshiro128**) — explicit state so sessions and batch sims never share
+// hidden global state and reproduce bit-for-bit from a seed
+//------------------------------------------------------------------------------------
+typedef struct {
+    uint32_t s[4];
+} Rng;
+
 //------------------------------------------------------------------------------------
 // Team
 //------------------------------------------------------------------------------------
@@ -47,8 +56,8 @@ typedef enum { ANIM_IDLE = 0, ANIM_WALK, ANIM_SCARED, ANIM_ATTACK, ANIM_CAST, AN
 
 #define MAX_SHOP_SLOTS 3
 #define MAX_MODIFIERS 128
-#define MAX_PROJECTILES 32
-#define MAX_PARTICLES 1024
+#define MAX_PROJECTILES 256      // projectile pool storage (capacity grows lazily up to this)
+#define MAX_PARTICLES 65536     // drawn instanced, see particle_render.h; keep a multiple of 4
 #define MAX_FLOATING_TEXTS 32
 #define MAX_INVENTORY_SLOTS 6
 #define MAX_FISSURES 8
@@ -97,18 +106,44 @@ typedef struct {
     float chargeMax;    // total charge time (for size lerp)
 } Projectile;
 
+// Pool with O(1) alloc/free: free slots live on a stack, live slots in a dense
+// list so per-tick work scales with projectiles in flight, not storage size.
+typedef struct {
+    Projectile items[MAX_PROJECTILES];
+    int freeList[MAX_PROJECTILES];   // stack of free slot indices
+    int freeCount;
+    int live[MAX_PROJECTILES];       // dense list of active slot indices
+    int livePos[MAX_PROJECTILES];    // slot -> index in live[] (-1 = free)
+    int liveCount;
+    int capacity;                    // slots handed out this battle (high-water mark)
+} ProjectilePool;
+
 //------------------------------------------------------------------------------------
-// Particle (simple visual effect)
+// Particles (simple visual effects) — structure of arrays, live ones packed densely in
+// [0, count): spawning appends, expiring moves the last live particle into the hole,
+// so neither ever looks at free capacity
 //------------------------------------------------------------------------------------
+typedef struct {
+    int count;
+    float posX[MAX_PARTICLES], posY[MAX_PARTICLES], posZ[MAX_PARTICLES];
+    float velX[MAX_PARTICLES], velY[MAX_PARTICLES], velZ[MAX_PARTICLES];
+    float life[MAX_PARTICLES];      // seconds remaining
+    float maxLife[MAX_PARTICLES];
+    float size[MAX_PARTICLES];
+    Color color[MAX_PARTICLES];
+} ParticleSystem;
+
+// One emitter call: count particles fanning out in random horizontal directions
 typedef struct {
     Vector3 position;
-    Vector3 velocity;
-    float life;       // seconds remaining
-    float maxLife;
-    Color color;
-    float size;
-    bool active;
-} Particle;
+    float spread;                   // spawn up to this far out along the direction
+    float speedMin, speedMax;       // outward speed
+    float upMin, upMax;             // initial upward speed
+    float lifeMin, lifeMax;
+    float sizeMin, sizeMax;
+    Color color;                    // scaled per particle by a shade in [shadeMin, 1]
+    float shadeMin;
+} ParticleBurst;
 
 //------------------------------------------------------------------------------------
 // Shop & Inventory
@@ -151,6 +186,8 @@ typedef struct {
 //------------------------------------------------------------------------------------
 // Unit type (visual info — model, scale, name)
 //------------------------------------------------------------------------------------
+#define SKIN_MAX_BONES 128      // MAX_BONE_NUM in lighting.vs / shadow_depth.vs
+
 typedef struct {
     const char *name;
     const char *modelPath;
@@ -171,8 +208,51 @@ typedef struct {
     int animIndex[ANIM_COUNT];      // index into respective anim array (-1 = not found)
     bool hasAnimations;
     float yOffset;          // vertical draw offset (raise/lower model)
+    Material *depthMaterials;       // shadow pass material set (client, NULL until built)
 } UnitType;
 
+//------------------------------------------------------------------------------------
+// Pose cache — bone palettes keyed by (unit type, anim state, frame). A palette only
+// depends on its key, so every unit, pass and portrait showing the same frame shares
+// one UpdateModelAnimationBones() per frame; entries also survive into later frames.
+//------------------------------------------------------------------------------------
+#define POSE_CACHE_SIZE 32
+
+typedef struct {
+    const UnitType *type;           // NULL = empty slot
+    AnimState state;
+    int frame;
+    unsigned int lastUsed;          // PoseCache.tick of the last hit
+    int boneCount;
+    Matrix palette[SKIN_MAX_BONES];
+} PoseCacheEntry;
+
+typedef struct {
+    PoseCacheEntry entries[POSE_CACHE_SIZE];
+    unsigned int tick;              // bumped once per rendered frame
+    const PoseCacheEntry *applied;  // entry whose palette the meshes last received
+} PoseCache;
+
+//------------------------------------------------------------------------------------
+// Portrait cache — HUD/menu portraits are still images of a unit type in its idle pose,
+// so each (type, tint) is rendered once into a cell of one shared atlas on first use and
+// only sampled after that
+//------------------------------------------------------------------------------------
+#define PORTRAIT_ATLAS_COLS 4
+#define PORTRAIT_ATLAS_CELLS (PORTRAIT_ATLAS_COLS * PORTRAIT_ATLAS_COLS)   // square atlas
+
+typedef struct {
+    int typeIndex;
+    Color tint;
+} PortraitKey;
+
+typedef struct {
+    RenderTexture2D atlas;
+    int cellSize;
+    PortraitKey keys[PORTRAIT_ATLAS_CELLS];
+    int count;
+} PortraitCache;
+
 //------------------------------------------------------------------------------------
 // Runtime unit instance
 //------------------------------------------------------------------------------------
@@ -316,24 +396,6 @@ typedef struct {
     int     sourceIndex;
 } Fissure;
 
-//------------------------------------------------------------------------------------
-// Combat State (bundled game state for ability handlers)
-//------------------------------------------------------------------------------------
-typedef struct {
-    Unit *units;
-    int unitCount;
-    Modifier *modifiers;
-    Projectile *projectiles;
-    Particle *particles;
-    Fissure *fissures;
-    FloatingText *floatingTexts;
-    ScreenShake *shake;
-#ifndef SERVER_BUILD
-    void *battleLog;    // BattleLog* (void* to avoid pulling BattleLog into server)
-    float combatTime;
-#endif
-} CombatState;
-
 //------------------------------------------------------------------------------------
 // Wave System
 //------------------------------------------------------------------------------------
@@ -354,19 +416,28 @@ typedef struct {
 //------------------------------------------------------------------------------------
 // Combat Event (for deterministic combat simulation feedback)
 //------------------------------------------------------------------------------------
-#define MAX_COMBAT_EVENTS 64
 typedef enum {
-    COMBAT_EVT_ABILITY_CAST,   // unit cast an ability
-    COMBAT_EVT_SHAKE,          // screen shake trigger
+    COMBAT_EVT_ABILITY_CAST,       // unit cast an ability (value1 = slot level)
+    COMBAT_EVT_SHAKE,              // screen shake trigger (value1 = intensity, value2 = duration)
+    COMBAT_EVT_DAMAGE,             // unit took damage (value1 = amount after armor/shield)
+    COMBAT_EVT_KILL,               // unit died (sourceIndex = killer)
+    COMBAT_EVT_STUN,               // unit stunned by an ability (value1 = duration)
+    COMBAT_EVT_ATTACK,             // unit started a basic attack swing
+    COMBAT_EVT_MELEE_HIT,          // melee swing connected with its target
+    COMBAT_EVT_PROJECTILE_SPAWN,   // projectile created, still charging
+    COMBAT_EVT_PROJECTILE_LAUNCH,  // projectile finished charging and started moving
+    COMBAT_EVT_PROJECTILE_IMPACT,  // projectile reached its target
 } CombatEventType;
 
 typedef struct {
     CombatEventType type;
-    int unitIndex;
-    int abilityId;             // for ABILITY_CAST
+    int unitIndex;             // affected unit (projectile events: the target)
+    int sourceIndex;           // caster/attacker, -1 if none
+    int abilityId;             // -1 = basic attack or no ability
     Vector3 position;
-    float value1;              // intensity for SHAKE
-    float value2;              // duration for SHAKE
+    Color color;               // projectile color for PROJECTILE_* events
+    float value1;
+    float value2;
 } CombatEvent;
 
 //------------------------------------------------------------------------------------
@@ -407,6 +478,7 @@ typedef struct {
     Texture2D ormTexture;       // ORM texture (id=0 if none)
     Texture2D normalTexture;    // Normal map texture (id=0 if none)
     bool loaded;
+    Material *depthMaterials;   // shadow pass material set (client, NULL until built)
 } EnvModelDef;
 
 typedef struct {
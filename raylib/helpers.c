@@ -1,6 +1,11 @@
 #include "game.h"
 #include "helpers.h"
 #include "synergies.h"
+#include "combat_prof.h"
+#include "combat_math.h"
+#ifndef SERVER_BUILD
+#include "rlgl.h"
+#endif
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
@@ -18,6 +23,115 @@ ModelAnimation *GetAnimArray(UnitType *type, AnimState state) {
     }
 }
 
+#ifndef SERVER_BUILD
+// Copy a palette into every mesh that skins (UpdateModelAnimationBones keeps them identical)
+static void SetModelPalette(Model model, const Matrix *palette, int boneCount)
+{
+    for (int m = 0; m < model.meshCount; m++)
+        if (model.meshes[m].boneMatrices)
+            memcpy(model.meshes[m].boneMatrices, palette, boneCount * sizeof(Matrix));
+}
+
+static const Matrix *GetModelPalette(Model model)
+{
+    for (int m = 0; m < model.meshCount; m++)
+        if (model.meshes[m].boneMatrices) return model.meshes[m].boneMatrices;
+    return NULL;
+}
+
+// Only the bone matrices are computed here — vertices stay in the bind pose in the
+// VBO and DrawMesh hands mesh.boneMatrices to the shader, so nothing is re-uploaded
+void PoseUnitModel(PoseCache *cache, UnitType *type, AnimState state, int frame)
+{
+    if (!type->hasAnimations) return;
+    int idx = type->animIndex[state];
+    ModelAnimation *arr = GetAnimArray(type, state);
+    if (idx < 0 || !arr) return;
+    ModelAnimation anim = arr[idx];
+    if (anim.frameCount > 0) frame %= anim.frameCount;
+    int boneCount = type->model.boneCount < SKIN_MAX_BONES ? type->model.boneCount : SKIN_MAX_BONES;
+    if (!cache || boneCount <= 0) {
+        UpdateModelAnimationBones(type->model, anim, frame);
+        if (cache) cache->applied = NULL;
+        return;
+    }
+
+    PoseCacheEntry *victim = &cache->entries[0];
+    for (int e = 0; e < POSE_CACHE_SIZE; e++) {
+        PoseCacheEntry *entry = &cache->entries[e];
+        if (entry->type == type && entry->state == state && entry->frame == frame) {
+            entry->lastUsed = cache->tick;
+            // Sorted draws put same-pose units back to back; the meshes already hold it
+            if (cache->applied != entry) SetModelPalette(type->model, entry->palette, entry->boneCount);
+            cache->applied = entry;
+            return;
+        }
+        if (!entry->type || entry->lastUsed < victim->lastUsed) victim = entry;
+        if (!victim->type) break;
+    }
+
+    UpdateModelAnimationBones(type->model, anim, frame);
+    const Matrix *palette = GetModelPalette(type->model);
+    if (!palette) return;
+    *victim = (PoseCacheEntry){ .type = type, .state = state, .frame = frame,
+                                .lastUsed = cache->tick, .boneCount = boneCount };
+    memcpy(victim->palette, palette, boneCount * sizeof(Matrix));
+    cache->applied = victim;
+}
+
+void PoseCacheNewFrame(PoseCache *cache)
+{
+    cache->tick++;
+}
+#endif
+
+//------------------------------------------------------------------------------------
+// Random (xoshiro128**)
+//------------------------------------------------------------------------------------
+static uint64_t SplitMix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint32_t Rotl32(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+void RngSeed(Rng *rng, uint64_t seed)
+{
+    // Expand the seed with splitmix64 so nearby seeds give unrelated streams
+    uint64_t a = SplitMix64(&seed), b = SplitMix64(&seed);
+    rng->s[0] = (uint32_t)a; rng->s[1] = (uint32_t)(a >> 32);
+    rng->s[2] = (uint32_t)b; rng->s[3] = (uint32_t)(b >> 32);
+    if (!(rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3])) rng->s[0] = 1; // all-zero state is a fixed point
+}
+
+uint32_t RngNext(Rng *rng)
+{
+    uint32_t *s = rng->s;
+    uint32_t result = Rotl32(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = Rotl32(s[3], 11);
+    return result;
+}
+
+int RngRange(Rng *rng, int min, int max)
+{
+    if (min > max) { int t = min; min = max; max = t; }
+    uint32_t span = (uint32_t)(max - min) + 1;
+    // Multiply-shift maps onto [0, span) without modulo bias worth caring about here
+    return min + (int)(((uint64_t)RngNext(rng) * span) >> 32);
+}
+
 //------------------------------------------------------------------------------------
 // Unit Utilities
 //------------------------------------------------------------------------------------
@@ -90,12 +204,13 @@ float DistXZ(Vector3 a, Vector3 b)
 {
     float dx = a.x - b.x;
     float dz = a.z - b.z;
-    return sqrtf(dx * dx + dz * dz);
+    return CombatSqrt(dx * dx + dz * dz);
 }
 
 // Find index of closest active enemy (-1 if none)
 int FindClosestEnemy(Unit units[], int unitCount, int selfIndex)
 {
+    PROF_COUNT(PROF_CNT_QUERIES, 1);
     Team myTeam = units[selfIndex].team;
     float bestDist = 1e30f;
     int bestIdx = -1;
@@ -186,14 +301,18 @@ void RestoreSnapshot(Unit units[], int *unitCount, UnitSnapshot snaps[], int sna
 bool UnitHasModifier(Modifier modifiers[], int unitIndex, ModifierType type)
 {
     for (int m = 0; m < MAX_MODIFIERS; m++)
-        if (modifiers[m].active && modifiers[m].unitIndex == unitIndex && modifiers[m].type == type)
+        if (modifiers[m].active && modifiers[m].unitIndex == unitIndex && modifiers[m].type == type) {
+            PROF_COUNT(PROF_CNT_MODIFIER_SCANS, m + 1);
             return true;
+        }
+    PROF_COUNT(PROF_CNT_MODIFIER_SCANS, MAX_MODIFIERS);
     return false;
 }
 
 float GetModifierValue(Modifier modifiers[], int unitIndex, ModifierType type)
 {
     float best = 0.0f;
+    PROF_COUNT(PROF_CNT_MODIFIER_SCANS, MAX_MODIFIERS);
     for (int m = 0; m < MAX_MODIFIERS; m++)
         if (modifiers[m].active && modifiers[m].unitIndex == unitIndex && modifiers[m].type == type)
             if (modifiers[m].value > best) best = modifiers[m].value;
@@ -236,77 +355,171 @@ void ClearAllModifiers(Modifier modifiers[])
 //------------------------------------------------------------------------------------
 // Projectile Helpers
 //------------------------------------------------------------------------------------
-void SpawnProjectile(Projectile projectiles[], ProjectileType type,
-    Vector3 startPos, int targetIndex, int sourceIndex, Team sourceTeam, int level,
-    float speed, float damage, float stunDur, Color color)
+// capacity = slots handed out up front; 0 lets the pool grow on demand
+void InitProjectilePool(ProjectilePool *pool, int capacity)
 {
+    if (capacity < 0) capacity = 0;
+    if (capacity > MAX_PROJECTILES) capacity = MAX_PROJECTILES;
+    pool->capacity = capacity;
+    pool->liveCount = 0;
+    pool->freeCount = 0;
+    // Push in reverse so low slots are handed out first
+    for (int p = capacity - 1; p >= 0; p--) pool->freeList[pool->freeCount++] = p;
     for (int p = 0; p < MAX_PROJECTILES; p++) {
-        if (!projectiles[p].active) {
-            projectiles[p] = (Projectile){
-                .type = type, .position = (Vector3){ startPos.x, startPos.y + 3.0f, startPos.z },
-                .targetIndex = targetIndex, .sourceIndex = sourceIndex, .sourceTeam = sourceTeam,
-                .speed = speed, .damage = damage, .stunDuration = stunDur,
-                .bouncesRemaining = 0, .bounceRange = 0, .lastHitUnit = -1,
-                .level = level, .color = color, .active = true,
-                .chargeTimer = 0.2f, .chargeMax = 0.2f,
-            };
-            return;
-        }
+        pool->items[p].active = false;
+        pool->livePos[p] = -1;
+    }
+}
+
+// Returns a zeroed slot marked active, or NULL once all MAX_PROJECTILES are in flight.
+// Capacity is a high-water mark: a new slot is handed out only when none are free.
+Projectile *AllocProjectile(ProjectilePool *pool)
+{
+    if (pool->freeCount == 0) {
+        if (pool->capacity >= MAX_PROJECTILES) return NULL;
+        pool->freeList[pool->freeCount++] = pool->capacity++;
     }
+    int slot = pool->freeList[--pool->freeCount];
+    pool->livePos[slot] = pool->liveCount;
+    pool->live[pool->liveCount++] = slot;
+    pool->items[slot] = (Projectile){ .active = true };
+    return &pool->items[slot];
 }
 
-void ClearAllProjectiles(Projectile projectiles[])
+void FreeProjectile(ProjectilePool *pool, int slot)
 {
-    for (int p = 0; p < MAX_PROJECTILES; p++) projectiles[p].active = false;
+    int pos = pool->livePos[slot];
+    if (pos < 0) return;
+    // Swap-remove from the live list
+    int last = pool->live[--pool->liveCount];
+    pool->live[pos] = last;
+    pool->livePos[last] = pos;
+    pool->livePos[slot] = -1;
+    pool->items[slot].active = false;
+    pool->freeList[pool->freeCount++] = slot;
+}
+
+void SpawnProjectile(ProjectilePool *projectiles, ProjectileType type,
+    Vector3 startPos, int targetIndex, int sourceIndex, Team sourceTeam, int level,
+    float speed, float damage, float stunDur, Color color)
+{
+    Projectile *proj = AllocProjectile(projectiles);
+    if (!proj) return;
+    *proj = (Projectile){
+        .type = type, .position = (Vector3){ startPos.x, startPos.y + 3.0f, startPos.z },
+        .targetIndex = targetIndex, .sourceIndex = sourceIndex, .sourceTeam = sourceTeam,
+        .speed = speed, .damage = damage, .stunDuration = stunDur,
+        .bouncesRemaining = 0, .bounceRange = 0, .lastHitUnit = -1,
+        .level = level, .color = color, .active = true,
+        .chargeTimer = 0.2f, .chargeMax = 0.2f,
+    };
+}
+
+void ClearAllProjectiles(ProjectilePool *projectiles)
+{
+    while (projectiles->liveCount > 0)
+        FreeProjectile(projectiles, projectiles->live[projectiles->liveCount - 1]);
 }
 
 //------------------------------------------------------------------------------------
 // Particle Helpers
 //------------------------------------------------------------------------------------
-void ClearAllParticles(Particle particles[])
+void ClearAllParticles(ParticleSystem *particles)
 {
-    for (int i = 0; i < MAX_PARTICLES; i++) particles[i].active = false;
+    particles->count = 0;
 }
 
-void SpawnParticle(Particle particles[], Vector3 pos, Vector3 vel, float life, float size, Color color)
+void SpawnParticle(ParticleSystem *particles, Vector3 pos, Vector3 vel, float life, float size, Color color)
 {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (particles[i].active) continue;
-        particles[i] = (Particle){
-            .position = pos, .velocity = vel,
-            .life = life, .maxLife = life,
-            .color = color, .size = size, .active = true
-        };
-        return;
+    if (particles->count >= MAX_PARTICLES) return;
+    int i = particles->count++;
+    particles->posX[i] = pos.x; particles->posY[i] = pos.y; particles->posZ[i] = pos.z;
+    particles->velX[i] = vel.x; particles->velY[i] = vel.y; particles->velZ[i] = vel.z;
+    particles->life[i] = life;
+    particles->maxLife[i] = life;
+    particles->size[i] = size;
+    particles->color[i] = color;
+}
+
+static float RandomRange(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)GetRandomValue(0, 1000) / 1000.0f;
+}
+
+int SpawnParticleBurst(ParticleSystem *particles, const ParticleBurst *burst, int count)
+{
+    if (count > MAX_PARTICLES - particles->count) count = MAX_PARTICLES - particles->count;
+    for (int k = 0; k < count; k++) {
+        float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
+        float dirX = cosf(angle), dirZ = sinf(angle);
+        float r = burst->spread > 0.0f ? RandomRange(0.0f, burst->spread) : 0.0f;
+        float speed = RandomRange(burst->speedMin, burst->speedMax);
+        float shade = RandomRange(burst->shadeMin, 1.0f);
+        Color c = burst->color;
+        c.r = (unsigned char)(c.r * shade);
+        c.g = (unsigned char)(c.g * shade);
+        c.b = (unsigned char)(c.b * shade);
+        SpawnParticle(particles,
+            (Vector3){ burst->position.x + dirX * r, burst->position.y, burst->position.z + dirZ * r },
+            (Vector3){ dirX * speed, RandomRange(burst->upMin, burst->upMax), dirZ * speed },
+            RandomRange(burst->lifeMin, burst->lifeMax), RandomRange(burst->sizeMin, burst->sizeMax), c);
     }
+    return count;
 }
 
-void UpdateParticles(Particle particles[], float dt)
+// Remove particle i by moving the last live one into its slot
+static void RemoveParticle(ParticleSystem *particles, int i)
 {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!particles[i].active) continue;
-        particles[i].life -= dt;
-        if (particles[i].life <= 0) { particles[i].active = false; continue; }
-        particles[i].position.x += particles[i].velocity.x * dt;
-        particles[i].position.y += particles[i].velocity.y * dt;
-        particles[i].position.z += particles[i].velocity.z * dt;
+    int last = --particles->count;
+    particles->posX[i] = particles->posX[last];
+    particles->posY[i] = particles->posY[last];
+    particles->posZ[i] = particles->posZ[last];
+    particles->velX[i] = particles->velX[last];
+    particles->velY[i] = particles->velY[last];
+    particles->velZ[i] = particles->velZ[last];
+    particles->life[i] = particles->life[last];
+    particles->maxLife[i] = particles->maxLife[last];
+    particles->size[i] = particles->size[last];
+    particles->color[i] = particles->color[last];
+}
+
+void UpdateParticles(ParticleSystem *particles, float dt)
+{
+    // The integration loops run over the live range rounded up to a multiple of 4 so
+    // -O2 vectorizes them without a scalar tail; the few slots past count are dead and
+    // MAX_PARTICLES is a multiple of 4, so that stays in bounds
+    int padded = (particles->count + 3) & ~3;
+    float *life = particles->life;
+    for (int i = 0; i < padded; i++) life[i] -= dt;
+
+    // Retire the expired; walking down means whatever moves into slot i was already checked
+    for (int i = particles->count - 1; i >= 0; i--)
+        if (life[i] <= 0) RemoveParticle(particles, i);
+
+    padded = (particles->count + 3) & ~3;
+    float *px = particles->posX, *py = particles->posY, *pz = particles->posZ;
+    float *vx = particles->velX, *vy = particles->velY, *vz = particles->velZ;
+    for (int i = 0; i < padded; i++) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        pz[i] += vz[i] * dt;
         // Gravity
-        particles[i].velocity.y -= 15.0f * dt;
-        // Fade out
-        float alpha = particles[i].life / particles[i].maxLife;
-        particles[i].color.a = (unsigned char)(255.0f * alpha);
+        vy[i] -= 15.0f * dt;
     }
+    // Fade out
+    for (int i = 0; i < particles->count; i++)
+        particles->color[i].a = (unsigned char)(255.0f * life[i] / particles->maxLife[i]);
 }
 
 //------------------------------------------------------------------------------------
 // Shop & Inventory Helpers
 //------------------------------------------------------------------------------------
-void RollShop(ShopSlot shopSlots[], int *gold, int cost)
+void RollShop(Rng *rng, ShopSlot shopSlots[], int *gold, int cost)
 {
     if (*gold < cost) return;
     *gold -= cost;
     for (int i = 0; i < MAX_SHOP_SLOTS; i++) {
-        shopSlots[i].abilityId = GetRandomValue(0, ABILITY_COUNT - 1);
+        shopSlots[i].abilityId = RngRange(rng, 0, ABILITY_COUNT - 1);
         shopSlots[i].level = 0;
     }
 }
@@ -354,11 +567,11 @@ void BuyAbility(ShopSlot *slot, InventorySlot inventory[], Unit units[], int uni
     // Inventory full — do nothing
 }
 
-void AssignRandomAbilities(Unit *unit, int numAbilities)
+void AssignRandomAbilities(Rng *rng, Unit *unit, int numAbilities)
 {
     for (int a = 0; a < numAbilities && a < MAX_ABILITIES_PER_UNIT; a++) {
-        unit->abilities[a].abilityId = GetRandomValue(0, ABILITY_COUNT - 1);
-        unit->abilities[a].level = GetRandomValue(0, 1);
+        unit->abilities[a].abilityId = RngRange(rng, 0, ABILITY_COUNT - 1);
+        unit->abilities[a].level = RngRange(rng, 0, 1);
         unit->abilities[a].cooldownRemaining = 0;
         unit->abilities[a].triggered = false;
     }
@@ -457,7 +670,7 @@ void StartStatueSpawn(StatueSpawn *spawn, int unitIndex)
     spawn->driftZ = sinf(driftAngle) * driftDist;
 }
 
-void UpdateStatueSpawn(StatueSpawn *spawn, Particle particles[], ScreenShake *shake, Vector3 unitWorldPos, float dt)
+void UpdateStatueSpawn(StatueSpawn *spawn, ParticleSystem *particles, ScreenShake *shake, Vector3 unitWorldPos, float dt)
 {
     if (spawn->phase == SSPAWN_INACTIVE || spawn->phase == SSPAWN_DONE) return;
 
@@ -481,28 +694,16 @@ void UpdateStatueSpawn(StatueSpawn *spawn, Particle particles[], ScreenShake *sh
             spawn->phase = SSPAWN_DONE;
 
             // Impact particles — stone chunks burst outward
-            Vector3 impactPos = { unitWorldPos.x, spawn->targetY, unitWorldPos.z };
-            for (int i = 0; i < SPAWN_ANIM_IMPACT_PARTICLES; i++) {
-                float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-                float speed = (float)GetRandomValue(20, 80) / 10.0f;
-                Vector3 vel = {
-                    cosf(angle) * speed,
-                    (float)GetRandomValue(30, 100) / 10.0f,  // upward burst
-                    sinf(angle) * speed
-                };
-                int shade = GetRandomValue(100, 180);
-                int r = GetRandomValue(0, 1);
-                Color stoneColor;
-                if (r) {
-                    // Gray stone
-                    stoneColor = (Color){ (unsigned char)shade, (unsigned char)shade, (unsigned char)(shade - 10), 255 };
-                } else {
-                    // Brown stone
-                    stoneColor = (Color){ (unsigned char)shade, (unsigned char)(shade * 3 / 5), (unsigned char)(shade / 3), 255 };
-                }
-                float sz = (float)GetRandomValue(4, 12) / 10.0f;
-                SpawnParticle(particles, impactPos, vel, 0.6f + (float)GetRandomValue(0, 4) / 10.0f, sz, stoneColor);
-            }
+            // Half gray stone, half brown stone
+            ParticleBurst stone = {
+                .position = { unitWorldPos.x, spawn->targetY, unitWorldPos.z },
+                .speedMin = 2.0f, .speedMax = 8.0f, .upMin = 3.0f, .upMax = 10.0f,  // upward burst
+                .lifeMin = 0.6f, .lifeMax = 1.0f, .sizeMin = 0.4f, .sizeMax = 1.2f,
+                .color = { 180, 180, 170, 255 }, .shadeMin = 0.55f,
+            };
+            SpawnParticleBurst(particles, &stone, SPAWN_ANIM_IMPACT_PARTICLES / 2);
+            stone.color = (Color){ 180, 108, 60, 255 };
+            SpawnParticleBurst(particles, &stone, SPAWN_ANIM_IMPACT_PARTICLES - SPAWN_ANIM_IMPACT_PARTICLES / 2);
 
             // Screen shake on impact
             TriggerShake(shake, SPAWN_ANIM_SHAKE_INTENSITY, SPAWN_ANIM_SHAKE_DURATION);
@@ -518,22 +719,14 @@ bool IsUnitInStatueSpawn(const StatueSpawn *spawn, int unitIndex)
 //------------------------------------------------------------------------------------
 // Plaza Smoke Poof
 //------------------------------------------------------------------------------------
-void SpawnPoofBurst(Particle particles[], Vector3 pos, int count)
+void SpawnPoofBurst(ParticleSystem *particles, Vector3 pos, int count)
 {
-    for (int i = 0; i < count; i++) {
-        float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-        float speed = (float)GetRandomValue(20, 60) / 10.0f;
-        Vector3 vel = {
-            cosf(angle) * speed,
-            (float)GetRandomValue(10, 40) / 10.0f,
-            sinf(angle) * speed
-        };
-        int shade = GetRandomValue(160, 230);
-        Color smokeColor = { (unsigned char)shade, (unsigned char)shade, (unsigned char)shade, 255 };
-        float sz = (float)GetRandomValue(5, 15) / 10.0f;
-        SpawnParticle(particles, pos, vel,
-            0.6f + (float)GetRandomValue(0, 4) / 10.0f, sz, smokeColor);
-    }
+    ParticleBurst smoke = {
+        .position = pos, .speedMin = 2.0f, .speedMax = 6.0f, .upMin = 1.0f, .upMax = 4.0f,
+        .lifeMin = 0.6f, .lifeMax = 1.0f, .sizeMin = 0.5f, .sizeMax = 1.5f,
+        .color = { 230, 230, 230, 255 }, .shadeMin = 0.7f,
+    };
+    SpawnParticleBurst(particles, &smoke, count);
 }
 
 //------------------------------------------------------------------------------------
@@ -554,6 +747,127 @@ void DrawArc3D(Vector3 center, float radius, float fraction, Color color)
     }
 }
 
+#ifndef SERVER_BUILD
+// One DrawMeshInstanced per mesh; shader must map SHADER_LOC_MATRIX_MODEL to its
+// per-instance transform attribute
+void DrawModelInstanced(Model model, Shader shader, const Matrix *transforms, int count)
+{
+    if (count <= 0) return;
+    for (int m = 0; m < model.meshCount; m++) {
+        Material mat = model.materials[model.meshMaterial[m]];
+        mat.shader = shader;
+        DrawMeshInstanced(model.meshes[m], mat, transforms, count);
+    }
+}
+
+Material *LoadPassMaterials(Model model, Shader shader)
+{
+    Material *set = MemAlloc(model.materialCount * sizeof(Material));
+    for (int m = 0; m < model.materialCount; m++) {
+        set[m] = model.materials[m];
+        set[m].shader = shader;
+    }
+    return set;
+}
+
+// DrawModelEx without the tint, rotating about Y only
+void DrawModelPass(Model model, const Material *materials, Vector3 position, float rotationY, float scale)
+{
+    Matrix xf = MatrixMultiply(MatrixMultiply(MatrixScale(scale, scale, scale),
+                                              MatrixRotateY(rotationY * DEG2RAD)),
+                               MatrixTranslate(position.x, position.y, position.z));
+    xf = MatrixMultiply(model.transform, xf);
+    for (int m = 0; m < model.meshCount; m++)
+        DrawMesh(model.meshes[m], materials[model.meshMaterial[m]], xf);
+}
+
+static int UnitDrawCompare(const Unit *a, const Unit *b, const UnitType types[])
+{
+    // Keyed on the first mesh's material; unit models are one skinned mesh or close to it
+    const Model *ma = &types[a->typeIndex].model, *mb = &types[b->typeIndex].model;
+    const Material *ka = &ma->materials[ma->meshMaterial[0]], *kb = &mb->materials[mb->meshMaterial[0]];
+    if (ka->shader.id != kb->shader.id) return ka->shader.id < kb->shader.id ? -1 : 1;
+    unsigned int ta = ka->maps[MATERIAL_MAP_DIFFUSE].texture.id;
+    unsigned int tb = kb->maps[MATERIAL_MAP_DIFFUSE].texture.id;
+    if (ta != tb) return ta < tb ? -1 : 1;
+    if (a->typeIndex != b->typeIndex) return a->typeIndex - b->typeIndex;
+    if (a->currentAnim != b->currentAnim) return (int)a->currentAnim - (int)b->currentAnim;
+    return a->animFrame - b->animFrame;
+}
+
+int SortUnitDraws(const Unit units[], int unitCount, const UnitType types[], int order[])
+{
+    int count = 0;
+    for (int i = 0; i < unitCount; i++) {
+        if (!units[i].active || !types[units[i].typeIndex].loaded) continue;
+        // Insertion sort — a board holds a few dozen units at most
+        int j = count++;
+        while (j > 0 && UnitDrawCompare(&units[order[j - 1]], &units[i], types) > 0) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------------
+// Portrait Cache
+//------------------------------------------------------------------------------------
+void PortraitCacheInit(PortraitCache *cache, int cellSize)
+{
+    *cache = (PortraitCache){ .cellSize = cellSize };
+    cache->atlas = LoadRenderTexture(cellSize * PORTRAIT_ATLAS_COLS, cellSize * PORTRAIT_ATLAS_COLS);
+}
+
+void PortraitCacheUnload(PortraitCache *cache)
+{
+    UnloadRenderTexture(cache->atlas);
+    cache->count = 0;
+}
+
+int PortraitCacheFind(const PortraitCache *cache, int typeIndex, Color tint)
+{
+    for (int c = 0; c < cache->count; c++) {
+        const PortraitKey *k = &cache->keys[c];
+        if (k->typeIndex == typeIndex && k->tint.r == tint.r && k->tint.g == tint.g &&
+            k->tint.b == tint.b && k->tint.a == tint.a) return c;
+    }
+    return -1;
+}
+
+// Cell origin in framebuffer coordinates (also the texture's pixel rows, bottom-up)
+static void PortraitCellOrigin(const PortraitCache *cache, int cell, int *x, int *y)
+{
+    *x = (cell % PORTRAIT_ATLAS_COLS) * cache->cellSize;
+    *y = (cell / PORTRAIT_ATLAS_COLS) * cache->cellSize;
+}
+
+int PortraitCacheBegin(PortraitCache *cache, int typeIndex, Color tint, Color background)
+{
+    if (cache->count >= PORTRAIT_ATLAS_CELLS) return -1;
+    int cell = cache->count++;
+    cache->keys[cell] = (PortraitKey){ typeIndex, tint };
+    int x, y;
+    PortraitCellOrigin(cache, cell, &x, &y);
+    BeginTextureMode(cache->atlas);
+    // The atlas is square, so BeginMode3D's aspect matches the cell's
+    rlViewport(x, y, cache->cellSize, cache->cellSize);
+    rlEnableScissorTest();
+    rlScissor(x, y, cache->cellSize, cache->cellSize);
+    ClearBackground(background);
+    rlDisableScissorTest();
+    return cell;
+}
+
+Rectangle PortraitCacheRect(const PortraitCache *cache, int cell)
+{
+    int x, y;
+    PortraitCellOrigin(cache, cell, &x, &y);
+    return (Rectangle){ (float)x, (float)y, (float)cache->cellSize, -(float)cache->cellSize };
+}
+#endif
+
 //------------------------------------------------------------------------------------
 // Fissure Helpers
 //------------------------------------------------------------------------------------
@@ -562,8 +876,8 @@ void SpawnFissure(Fissure fissures[], Vector3 casterPos, Vector3 targetPos,
 {
     float dx = targetPos.x - casterPos.x;
     float dz = targetPos.z - casterPos.z;
-    float angle = atan2f(dx, dz) * (180.0f / PI);
-    float dist = sqrtf(dx * dx + dz * dz);
+    float angle = CombatAtan2Deg(dx, dz);
+    float dist = CombatSqrt(dx * dx + dz * dz);
     // Place fissure center halfway along the direction
     float halfLen = length / 2.0f;
     float norm = (dist > 0.001f) ? 1.0f / dist : 0.0f;
@@ -607,8 +921,7 @@ bool CheckFissureCollision(Fissure fissures[], Vector3 pos, float unitRadius)
         // Transform pos into fissure-local space
         float dx = pos.x - fissures[i].position.x;
         float dz = pos.z - fissures[i].position.z;
-        float rad = fissures[i].rotation * (PI / 180.0f);
-        float cosA = cosf(-rad), sinA = sinf(-rad);
+        float cosA = CombatCosDeg(-fissures[i].rotation), sinA = CombatSinDeg(-fissures[i].rotation);
         float localX = dx * cosA - dz * sinA;
         float localZ = dx * sinA + dz * cosA;
         float halfL = fissures[i].length / 2.0f + unitRadius;
@@ -627,8 +940,7 @@ Vector3 ResolveFissureCollision(Fissure fissures[], Vector3 pos, Vector3 oldPos,
         if (!fissures[i].active) continue;
         float dx = pos.x - fissures[i].position.x;
         float dz = pos.z - fissures[i].position.z;
-        float rad = fissures[i].rotation * (PI / 180.0f);
-        float cosA = cosf(-rad), sinA = sinf(-rad);
+        float cosA = CombatCosDeg(-fissures[i].rotation), sinA = CombatSinDeg(-fissures[i].rotation);
         float localX = dx * cosA - dz * sinA;
         float localZ = dx * sinA + dz * cosA;
         float halfL = fissures[i].length / 2.0f + unitRadius;
@@ -642,7 +954,7 @@ Vector3 ResolveFissureCollision(Fissure fissures[], Vector3 pos, Vector3 oldPos,
             else
                 localZ += (localZ >= 0 ? overlapZ : -overlapZ);
             // Transform back to world space
-            float cosB = cosf(rad), sinB = sinf(rad);
+            float cosB = CombatCosDeg(fissures[i].rotation), sinB = CombatSinDeg(fissures[i].rotation);
             pos.x = fissures[i].position.x + localX * cosB - localZ * sinB;
             pos.z = fissures[i].position.z + localX * sinB + localZ * cosB;
         }
@@ -658,14 +970,14 @@ Vector3 ResolveFissureCollision(Fissure fissures[], Vector3 pos, Vector3 oldPos,
 //------------------------------------------------------------------------------------
 
 // Assign N random non-duplicate abilities at a specific level
-static void AssignAbilitiesAtLevel(Unit *unit, int numAbilities, int level)
+static void AssignAbilitiesAtLevel(Rng *rng, Unit *unit, int numAbilities, int level)
 {
     int used[ABILITY_COUNT] = {0};
     for (int a = 0; a < numAbilities && a < MAX_ABILITIES_PER_UNIT; a++) {
         int id;
         int attempts = 0;
         do {
-            id = GetRandomValue(0, ABILITY_COUNT - 1);
+            id = RngRange(rng, 0, ABILITY_COUNT - 1);
             attempts++;
         } while (used[id] && attempts < 50);
         used[id] = 1;
@@ -677,11 +989,11 @@ static void AssignAbilitiesAtLevel(Unit *unit, int numAbilities, int level)
 }
 
 // Find a valid spawn position on the red half (Z < 0), not overlapping others
-Vector3 FindValidSpawnPos(Unit units[], int unitCount, float minDist)
+Vector3 FindValidSpawnPos(Rng *rng, Unit units[], int unitCount, float minDist)
 {
     for (int attempt = 0; attempt < 30; attempt++) {
-        float x = (float)GetRandomValue(-80, 80);
-        float z = (float)GetRandomValue(-90, -20);
+        float x = (float)RngRange(rng, -80, 80);
+        float z = (float)RngRange(rng, -90, -20);
         bool valid = true;
         for (int i = 0; i < unitCount; i++) {
             if (!units[i].active) continue;
@@ -692,7 +1004,7 @@ Vector3 FindValidSpawnPos(Unit units[], int unitCount, float minDist)
         if (valid) return (Vector3){ x, 0.0f, z };
     }
     // Fallback: just pick a random spot
-    return (Vector3){ (float)GetRandomValue(-80, 80), 0.0f, (float)GetRandomValue(-90, -20) };
+    return (Vector3){ (float)RngRange(rng, -80, 80), 0.0f, (float)RngRange(rng, -90, -20) };
 }
 
 // Remove all red (enemy) units
@@ -749,7 +1061,7 @@ static const WaveDef WAVE_DEFS[TOTAL_ROUNDS] = {
 };
 
 // Spawn a wave of enemies for the given round (0-indexed)
-void SpawnWave(Unit units[], int *unitCount, int round, int unitTypeCount)
+void SpawnWave(Rng *rng, Unit units[], int *unitCount, int round, int unitTypeCount)
 {
     (void)unitTypeCount; // use VALID_UNIT_TYPES instead
     if (round < TOTAL_ROUNDS) {
@@ -757,16 +1069,16 @@ void SpawnWave(Unit units[], int *unitCount, int round, int unitTypeCount)
         const WaveDef *wave = &WAVE_DEFS[round];
         for (int e = 0; e < wave->count; e++) {
             int type = wave->entries[e].unitType;
-            if (type < 0) type = VALID_UNIT_TYPES[GetRandomValue(0, VALID_UNIT_TYPE_COUNT - 1)];
+            if (type < 0) type = VALID_UNIT_TYPES[RngRange(rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
             if (SpawnUnit(units, unitCount, type, TEAM_RED)) {
                 Unit *u = &units[*unitCount - 1];
-                u->position = FindValidSpawnPos(units, *unitCount, 10.0f);
+                u->position = FindValidSpawnPos(rng, units, *unitCount, 10.0f);
                 u->scaleOverride = wave->entries[e].scaleMult;
                 u->hpMultiplier = wave->entries[e].hpMult;
                 u->dmgMultiplier = wave->entries[e].dmgMult;
                 u->currentHealth = UNIT_STATS[type].health * wave->entries[e].hpMult;
                 if (wave->entries[e].numAbilities > 0) {
-                    AssignAbilitiesAtLevel(u, wave->entries[e].numAbilities, wave->entries[e].abilityLevel);
+                    AssignAbilitiesAtLevel(rng, u, wave->entries[e].numAbilities, wave->entries[e].abilityLevel);
                 }
             }
         }
@@ -795,20 +1107,20 @@ void SpawnWave(Unit units[], int *unitCount, int round, int unitTypeCount)
         float hpScale = 2.0f + 0.3f * (float)(extraRounds + 1);
         float dmgScale = 1.3f + 0.15f * (float)(extraRounds + 1);
         for (int e = 0; e < enemyCount; e++) {
-            int type = VALID_UNIT_TYPES[GetRandomValue(0, VALID_UNIT_TYPE_COUNT - 1)];
+            int type = VALID_UNIT_TYPES[RngRange(rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
             if (SpawnUnit(units, unitCount, type, TEAM_RED)) {
                 Unit *u = &units[*unitCount - 1];
-                u->position = FindValidSpawnPos(units, *unitCount, 10.0f);
+                u->position = FindValidSpawnPos(rng, units, *unitCount, 10.0f);
                 u->scaleOverride = 1.0f;
                 u->hpMultiplier = hpScale;
                 u->dmgMultiplier = dmgScale;
                 u->currentHealth = UNIT_STATS[type].health * hpScale;
                 // Slight per-unit randomness: some get +1 ability or +1 level
-                int unitAb = numAb + (GetRandomValue(0, 1) ? 1 : 0);
+                int unitAb = numAb + (RngRange(rng, 0, 1) ? 1 : 0);
                 if (unitAb > MAX_ABILITIES_PER_UNIT) unitAb = MAX_ABILITIES_PER_UNIT;
-                int unitLvl = abLevel + (GetRandomValue(0, 2) == 0 ? 1 : 0);
+                int unitLvl = abLevel + (RngRange(rng, 0, 2) == 0 ? 1 : 0);
                 if (unitLvl > ABILITY_MAX_LEVELS - 1) unitLvl = ABILITY_MAX_LEVELS - 1;
-                AssignAbilitiesAtLevel(u, unitAb, unitLvl);
+                AssignAbilitiesAtLevel(rng, u, unitAb, unitLvl);
             }
         }
     }
@@ -917,7 +1229,7 @@ void ApplySynergies(Unit units[], int unitCount)
 //------------------------------------------------------------------------------------
 // Visual Juice Helpers
 //------------------------------------------------------------------------------------
-void SpawnDeathExplosion(Particle particles[], Vector3 pos, Team team)
+void SpawnDeathExplosion(ParticleSystem *particles, Vector3 pos, Team team)
 {
     Color baseColor = (team == TEAM_BLUE) ? (Color){100, 150, 255, 255} : (Color){255, 100, 100, 255};
     for (int i = 0; i < 20; i++) {
@@ -962,21 +1274,14 @@ void SpawnDamageNumber(FloatingText texts[], Vector3 pos, float damage, bool isA
     SpawnFloatingTextEx(texts, pos, buf, c, 0.8f, fontSize, driftX);
 }
 
-void SpawnMeleeImpact(Particle particles[], Vector3 pos)
+void SpawnMeleeImpact(ParticleSystem *particles, Vector3 pos)
 {
-    for (int i = 0; i < 5; i++) {
-        float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-        float speed = (float)GetRandomValue(10, 40) / 10.0f;
-        Vector3 vel = {
-            cosf(angle) * speed,
-            (float)GetRandomValue(10, 30) / 10.0f,
-            sinf(angle) * speed
-        };
-        int shade = GetRandomValue(140, 200);
-        Color c = { (unsigned char)shade, (unsigned char)(shade * 4/5), (unsigned char)(shade * 3/5), 255 };
-        float sz = (float)GetRandomValue(3, 7) / 10.0f;
-        SpawnParticle(particles, pos, vel, 0.3f, sz, c);
-    }
+    ParticleBurst sparks = {
+        .position = pos, .speedMin = 1.0f, .speedMax = 4.0f, .upMin = 1.0f, .upMax = 3.0f,
+        .lifeMin = 0.3f, .lifeMax = 0.3f, .sizeMin = 0.3f, .sizeMax = 0.7f,
+        .color = { 200, 160, 120, 255 }, .shadeMin = 0.7f,
+    };
+    SpawnParticleBurst(particles, &sparks, 5);
 }
 
 //------------------------------------------------------------------------------------
@@ -1,6 +1,11 @@
 #pragma once
 #include "game.h"
 
+// Random
+void RngSeed(Rng *rng, uint64_t seed);
+uint32_t RngNext(Rng *rng);
+int RngRange(Rng *rng, int min, int max);   // inclusive, like GetRandomValue
+
 // Unit utilities
 int CountTeamUnits(Unit units[], int unitCount, Team team);
 bool SpawnUnit(Unit units[], int *unitCount, int typeIndex, Team team);
@@ -19,29 +24,34 @@ void AddModifier(Modifier modifiers[], int unitIndex, ModifierType type, float d
 void ClearAllModifiers(Modifier modifiers[]);
 
 // Projectile helpers
-void SpawnProjectile(Projectile projectiles[], ProjectileType type,
+void InitProjectilePool(ProjectilePool *pool, int capacity);
+Projectile *AllocProjectile(ProjectilePool *pool);
+void FreeProjectile(ProjectilePool *pool, int slot);
+void SpawnProjectile(ProjectilePool *projectiles, ProjectileType type,
     Vector3 startPos, int targetIndex, int sourceIndex, Team sourceTeam, int level,
     float speed, float damage, float stunDur, Color color);
-void SpawnChainFrostProjectile(Projectile projectiles[],
+void SpawnChainFrostProjectile(ProjectilePool *projectiles,
     Vector3 startPos, int targetIndex, int sourceIndex, Team sourceTeam, int level,
     float speed, float damage, int bounces, float bounceRange);
-void SpawnHookProjectile(Projectile projectiles[], Vector3 startPos, int targetIndex,
+void SpawnHookProjectile(ProjectilePool *projectiles, Vector3 startPos, int targetIndex,
     int sourceIndex, Team sourceTeam, int level, float speed, float dmgPerDist, float range);
-void SpawnMaelstromProjectile(Projectile projectiles[], Vector3 startPos, int targetIndex,
+void SpawnMaelstromProjectile(ProjectilePool *projectiles, Vector3 startPos, int targetIndex,
     int sourceIndex, Team sourceTeam, int level, float speed, float damage, int bounces, float bounceRange);
 int FindChainFrostTarget(Unit units[], int unitCount, Vector3 fromPos,
     Team sourceTeam, int excludeIndex, float range);
-void ClearAllProjectiles(Projectile projectiles[]);
+void ClearAllProjectiles(ProjectilePool *projectiles);
 
 // Particle helpers
-void ClearAllParticles(Particle particles[]);
-void SpawnParticle(Particle particles[], Vector3 pos, Vector3 vel, float life, float size, Color color);
-void UpdateParticles(Particle particles[], float dt);
+void ClearAllParticles(ParticleSystem *particles);
+void SpawnParticle(ParticleSystem *particles, Vector3 pos, Vector3 vel, float life, float size, Color color);
+// Returns how many fit
+int SpawnParticleBurst(ParticleSystem *particles, const ParticleBurst *burst, int count);
+void UpdateParticles(ParticleSystem *particles, float dt);
 
 // Shop & inventory helpers
-void RollShop(ShopSlot shopSlots[], int *gold, int cost);
+void RollShop(Rng *rng, ShopSlot shopSlots[], int *gold, int cost);
 void BuyAbility(ShopSlot *slot, InventorySlot inventory[], Unit units[], int unitCount, int *gold);
-void AssignRandomAbilities(Unit *unit, int numAbilities);
+void AssignRandomAbilities(Rng *rng, Unit *unit, int numAbilities);
 
 // Floating text helpers
 void SpawnFloatingText(FloatingText texts[], Vector3 pos, const char *str, Color color, float life);
@@ -50,9 +60,9 @@ void UpdateFloatingTexts(FloatingText texts[], float dt);
 void ClearAllFloatingTexts(FloatingText texts[]);
 
 // Visual juice helpers
-void SpawnDeathExplosion(Particle particles[], Vector3 pos, Team team);
+void SpawnDeathExplosion(ParticleSystem *particles, Vector3 pos, Team team);
 void SpawnDamageNumber(FloatingText texts[], Vector3 pos, float damage, bool isAbility);
-void SpawnMeleeImpact(Particle particles[], Vector3 pos);
+void SpawnMeleeImpact(ParticleSystem *particles, Vector3 pos);
 
 // Screen shake helpers
 void TriggerShake(ScreenShake *shake, float intensity, float duration);
@@ -68,40 +78,43 @@ Vector3 ResolveFissureCollision(Fissure fissures[], Vector3 pos, Vector3 oldPos,
 
 // Statue spawn helpers
 void StartStatueSpawn(StatueSpawn *spawn, int unitIndex);
-void UpdateStatueSpawn(StatueSpawn *spawn, Particle particles[], ScreenShake *shake, Vector3 unitWorldPos, float dt);
+void UpdateStatueSpawn(StatueSpawn *spawn, ParticleSystem *particles, ScreenShake *shake, Vector3 unitWorldPos, float dt);
 bool IsUnitInStatueSpawn(const StatueSpawn *spawn, int unitIndex);
 
 // Plaza smoke poof
-void SpawnPoofBurst(Particle particles[], Vector3 pos, int count);
+void SpawnPoofBurst(ParticleSystem *particles, Vector3 pos, int count);
 
 // Animation helpers
 ModelAnimation *GetAnimArray(UnitType *type, AnimState state);
+#ifndef SERVER_BUILD
+// Pose the model's bone palette for the next draw; lighting.vs/shadow_depth.vs skin on the GPU.
+// cache may be NULL to always recompute.
+void PoseUnitModel(PoseCache *cache, UnitType *type, AnimState state, int frame);
+void PoseCacheNewFrame(PoseCache *cache);
+#endif
 
 // Drawing helpers
 void DrawArc3D(Vector3 center, float radius, float fraction, Color color);
-
-// Ability casting handlers (return true if cast succeeded)
-bool CastMagicMissile(CombatState *state, int caster, AbilitySlot *slot, int target);
-bool CastVacuum(CombatState *state, int caster, AbilitySlot *slot);
-bool CastChainFrost(CombatState *state, int caster, AbilitySlot *slot, int target);
-bool CastBloodRage(CombatState *state, int caster, AbilitySlot *slot);
-bool CastEarthquake(CombatState *state, int caster, AbilitySlot *slot);
-bool CastSpellProtect(CombatState *state, int caster, AbilitySlot *slot);
-bool CastCraggyArmor(CombatState *state, int caster, AbilitySlot *slot);
-bool CastStoneGaze(CombatState *state, int caster, AbilitySlot *slot);
-bool CastFissure(CombatState *state, int caster, AbilitySlot *slot, int target);
-bool CastVladAura(CombatState *state, int caster, AbilitySlot *slot);
-bool CastMaelstrom(CombatState *state, int caster, AbilitySlot *slot);
-bool CastSwap(CombatState *state, int caster, AbilitySlot *slot);
-bool CastAphoticShield(CombatState *state, int caster, AbilitySlot *slot);
-bool CastHook(CombatState *state, int caster, AbilitySlot *slot);
-bool CastPrimalCharge(CombatState *state, int caster, AbilitySlot *slot);
-
-// Passive ability checks
-void CheckPassiveSunder(CombatState *state, int unitIndex);
-
-// On-hit checks
-void CheckCraggyArmorRetaliation(CombatState *state, int attacker, int defender);
+#ifndef SERVER_BUILD
+void DrawModelInstanced(Model model, Shader shader, const Matrix *transforms, int count);
+// Per-pass material sets: a copy of model.materials with the pass shader (maps shared,
+// free with MemFree), drawn in place of the model's own
+Material *LoadPassMaterials(Model model, Shader shader);
+void DrawModelPass(Model model, const Material *materials, Vector3 position, float rotationY, float scale);
+// Fill order[] with the active unit indices sorted by material (shader, diffuse texture),
+// then type and pose; returns the count
+int SortUnitDraws(const Unit units[], int unitCount, const UnitType types[], int order[]);
+
+// Portrait atlas
+void PortraitCacheInit(PortraitCache *cache, int cellSize);
+void PortraitCacheUnload(PortraitCache *cache);
+int PortraitCacheFind(const PortraitCache *cache, int typeIndex, Color tint);   // cell or -1
+// Claim a cell and start drawing into it (texture mode, viewport and a cleared cell);
+// returns -1 if the atlas is full. Finish with EndTextureMode().
+int PortraitCacheBegin(PortraitCache *cache, int typeIndex, Color tint, Color background);
+// Source rectangle of a cell for DrawTexturePro (flipped, as render textures are)
+Rectangle PortraitCacheRect(const PortraitCache *cache, int cell);
+#endif
 
 // Shared combat helpers
 int FindHighestHPAlly(Unit units[], int unitCount, int selfIndex);
@@ -116,8 +129,8 @@ void ApplyRarityBuffs(Unit units[], int unitCount);
 void ApplySynergies(Unit units[], int unitCount);
 
 // Wave spawning helpers
-Vector3 FindValidSpawnPos(Unit units[], int unitCount, float minDist);
-void SpawnWave(Unit units[], int *unitCount, int round, int unitTypeCount);
+Vector3 FindValidSpawnPos(Rng *rng, Unit units[], int unitCount, float minDist);
+void SpawnWave(Rng *rng, Unit units[], int *unitCount, int round, int unitTypeCount);
 void ClearRedUnits(Unit units[], int *unitCount);
 void CompactBlueUnits(Unit units[], int *unitCount);
 
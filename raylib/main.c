@@ -12,10 +12,13 @@
 #include "raymath.h"
 #include "rlgl.h"
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #define RLIGHTS_IMPLEMENTATION
 #include "rlights.h"
@@ -36,8 +39,13 @@ static bool  cgDebugOverlay  = false;
 #include "game.h"
 #include "synergies.h"
 #include "helpers.h"
+#include "combat_sim.h"
+#include "client_sim.h"
+#include "combat_prof.h"
 #include "leaderboard.h"
 #include "net_client.h"
+#include "env_batch.h"
+#include "particle_render.h"
 
 // Global font — loaded in main(), used by GameDrawText/GameMeasureText
 static Font g_gameFont = { 0 };
@@ -83,12 +91,64 @@ static inline void GameDrawTextOnColor(const char *text, int x, int y, int fontS
 static float uiScale = 1.0f;
 #define S(x) ((int)((x) * uiScale))
 
+// --- Frame-rate independence (tuned at the old 60 FPS cap) ---
+#define ANIM_FRAME_RATE 60.0f   // skeletal anim frames advanced per second
+
+// Per-frame smoothing factor k (tuned at 60 FPS) converted to a frame of length dt
+static inline float FrameLerp(float k, float dt)
+{
+    return 1.0f - powf(1.0f - k, dt * 60.0f);
+}
+
+// --- Shadow map ---
+#define SHADOW_MAP_DEFAULT_SIZE 2048
+#define SHADOW_MAP_MIN_SIZE     512
+#define SHADOW_MAP_MAX_SIZE     8192
+#define SHADOW_TILE_SETTLE      3.0f   // seconds a tile must rest before rejoining the static cache
+
+// Depth-only-ish target for the light pass: RGBA color (debug preview) + sampleable depth
+static RenderTexture2D LoadShadowTarget(int size)
+{
+    RenderTexture2D rt = { 0 };
+    rt.id = rlLoadFramebuffer();
+    rt.texture.id = rlLoadTexture(NULL, size, size, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+    rt.texture.width = size;
+    rt.texture.height = size;
+    rt.texture.format = RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    rt.texture.mipmaps = 1;
+    rt.depth.id = rlLoadTextureDepth(size, size, false);
+    rt.depth.width = size;
+    rt.depth.height = size;
+    rlFramebufferAttach(rt.id, rt.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(rt.id, rt.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+    if (!rlFramebufferComplete(rt.id)) TraceLog(LOG_ERROR, "Shadow map FBO is not complete!");
+    return rt;
+}
+
+static void UnloadShadowTarget(RenderTexture2D rt)
+{
+    rlUnloadFramebuffer(rt.id);
+    rlUnloadTexture(rt.texture.id);
+    rlUnloadTexture(rt.depth.id);
+}
+
+// --- SSAO quality presets (F8 cycles, --ssao NAME picks at launch) ---
+// AO is computed at scene size / divisor and upsampled with a depth-aware filter;
+// temporal presets rotate the sample pattern each frame and accumulate it
+typedef enum { SSAO_OFF = 0, SSAO_QUARTER, SSAO_HALF, SSAO_HALF_TEMPORAL, SSAO_FULL, SSAO_PRESET_COUNT } SsaoPreset;
+static const struct { const char *name; int divisor; bool temporal; } SSAO_PRESETS[SSAO_PRESET_COUNT] = {
+    [SSAO_OFF]           = { "off",      0, false },
+    [SSAO_QUARTER]       = { "quarter",  4, false },
+    [SSAO_HALF]          = { "half",     2, false },
+    [SSAO_HALF_TEMPORAL] = { "temporal", 2, true },
+    [SSAO_FULL]          = { "full",     1, false },
+};
+
 // --- Hit flash ---
 #define HIT_FLASH_DURATION 0.12f
 
 // --- Projectile polish ---
 #define PROJ_CHARGE_TIME    0.2f
-#define CAST_PAUSE_TIME     0.25f
 #define PROJ_TRAIL_LIFE     0.4f
 #define PROJ_TRAIL_SIZE     1.0f
 #define PROJ_EXPLODE_COUNT  30
@@ -104,9 +164,39 @@ static float uiScale = 1.0f;
 //------------------------------------------------------------------------------------
 // Main
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char *argv[])
 {
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    // --fps N caps the render rate (0 = uncapped, vsync permitting); combat always
+    // simulates at the fixed CLIENT_SIM_DT regardless. --no-sim-thread ticks combat
+    // on the render thread instead. --record-replays saves every battle to replays/.
+    // --stream-combat [hz] has the server stream multiplayer battles as snapshots
+    // instead of simulating them here. --shadow-size N sets the shadow map resolution.
+    // --ssao off|quarter|half|temporal|full picks the SSAO preset.
+    int targetFps = 0;
+    bool simThreaded = true;
+    bool recordReplays = false;
+    int streamHz = 0;
+    int shadowMapSize = SHADOW_MAP_DEFAULT_SIZE;
+    SsaoPreset ssaoPreset = SSAO_HALF;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) targetFps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-sim-thread") == 0) simThreaded = false;
+        else if (strcmp(argv[i], "--record-replays") == 0) recordReplays = true;
+        else if (strcmp(argv[i], "--stream-combat") == 0) {
+            streamHz = STREAM_DEFAULT_HZ;
+            if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') streamHz = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--shadow-size") == 0 && i + 1 < argc) shadowMapSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ssao") == 0 && i + 1 < argc) {
+            i++;
+            for (int p = 0; p < SSAO_PRESET_COUNT; p++)
+                if (strcmp(argv[i], SSAO_PRESETS[p].name) == 0) ssaoPreset = (SsaoPreset)p;
+        }
+    }
+    if (shadowMapSize < SHADOW_MAP_MIN_SIZE) shadowMapSize = SHADOW_MAP_MIN_SIZE;
+    if (shadowMapSize > SHADOW_MAP_MAX_SIZE) shadowMapSize = SHADOW_MAP_MAX_SIZE;
+
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
     InitWindow(1280, 720, "Relic Rivals");
     SetWindowMinSize(640, 360);
     InitAudioDevice();
@@ -188,6 +278,11 @@ int main(void)
         particleTex = LoadTextureFromImage(img);
         UnloadImage(img);
     }
+    Shader particleShader = LoadShader(
+        TextFormat("resources/shaders/glsl%i/particle.vs", GLSL_VERSION),
+        TextFormat("resources/shaders/glsl%i/particle.fs", GLSL_VERSION));
+    static ParticleRenderer particleRenderer;
+    ParticleRendererInit(&particleRenderer, particleShader, MAX_PARTICLES);
 
     // Default 1x1 ORM texture for models without ORM files.
     // (R=255,G=128,B=0) = AO=1.0, Roughness~0.5, Metallic=0.0 — preserves current look.
@@ -252,6 +347,10 @@ int main(void)
         }
         else unitTypes[i].loaded = false;
 
+        if (unitTypes[i].model.boneCount > SKIN_MAX_BONES)
+            printf("[MODEL] %s has %d bones, the skinning shaders take %d\n",
+                   unitTypes[i].name, unitTypes[i].model.boneCount, SKIN_MAX_BONES);
+
         // Fix GLB alpha: force all material diffuse maps to full opacity
         for (int m = 0; m < unitTypes[i].model.materialCount; m++) {
             unitTypes[i].model.materials[m].maps[MATERIAL_MAP_DIFFUSE].color = WHITE;
@@ -259,6 +358,9 @@ int main(void)
         }
     }
 
+    static PoseCache poseCache;     // bone palettes shared by every pass that draws units
+    static int unitDrawOrder[MAX_UNITS];    // SortUnitDraws output, per pass
+
     // Load goblin animations from separate GLBs
     int walkAnimCount = 0, idleAnimCount = 0;
     ModelAnimation *walkAnims = LoadModelAnimations("assets/goblin/animations/PluginGoblinWalk.glb", &walkAnimCount);
@@ -335,10 +437,9 @@ int main(void)
         unitTypes[2].hasAnimations = true;
     }
 
-    // Portrait render textures for HUD (one per max blue unit)
-    RenderTexture2D portraits[BLUE_TEAM_MAX_SIZE];
-    for (int i = 0; i < BLUE_TEAM_MAX_SIZE; i++)
-        portraits[i] = LoadRenderTexture(HUD_PORTRAIT_SIZE_BASE, HUD_PORTRAIT_SIZE_BASE);
+    // Unit portraits for the HUD and menus, rendered on first use into one atlas
+    static PortraitCache portraitCache;
+    PortraitCacheInit(&portraitCache, HUD_PORTRAIT_SIZE_BASE);
 
     // Intro screen render texture (larger for cinematic model display)
     RenderTexture2D introModelRT = LoadRenderTexture(512, 512);
@@ -354,6 +455,9 @@ int main(void)
         TextFormat("resources/shaders/glsl%i/lighting.vs", GLSL_VERSION),
         TextFormat("resources/shaders/glsl%i/lighting.fs", GLSL_VERSION));
     lightShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(lightShader, "viewPos");
+    lightShader.locs[SHADER_LOC_BONE_MATRICES] = GetShaderLocation(lightShader, "boneMatrices");
+    lightShader.locs[SHADER_LOC_VERTEX_BONEIDS] = GetShaderLocationAttrib(lightShader, "vertexBoneIds");
+    lightShader.locs[SHADER_LOC_VERTEX_BONEWEIGHTS] = GetShaderLocationAttrib(lightShader, "vertexBoneWeights");
 
     int ambientLoc = GetShaderLocation(lightShader, "ambient");
     SetShaderValue(lightShader, ambientLoc, (float[4]){ 0.25f, 0.22f, 0.18f, 1.0f }, SHADER_UNIFORM_VEC4);
@@ -369,12 +473,33 @@ int main(void)
     lights[1] = CreateLight(LIGHT_POINT, (Vector3){ 0, 40, 0 }, Vector3Zero(), (Color){220, 200, 170, 255}, lightShader);
 
     // --- SSAO post-process ---
+    // ssao_ao.fs writes AO into aoRT at the preset's resolution; ssao.fs upsamples it
+    // while compositing (and tonemaps)
     Shader ssaoShader = LoadShader(NULL,
         TextFormat("resources/shaders/glsl%i/ssao.fs", GLSL_VERSION));
-    int ssaoResLoc  = GetShaderLocation(ssaoShader, "resolution");
     int ssaoNearLoc = GetShaderLocation(ssaoShader, "near");
     int ssaoFarLoc  = GetShaderLocation(ssaoShader, "far");
     int ssaoDepthLoc = GetShaderLocation(ssaoShader, "texture1");
+    int ssaoAoTexLoc = GetShaderLocation(ssaoShader, "texture2");
+    int ssaoAoResLoc = GetShaderLocation(ssaoShader, "aoResolution");
+    int ssaoAoEnabledLoc = GetShaderLocation(ssaoShader, "aoEnabled");
+    Shader aoShader = LoadShader(NULL,
+        TextFormat("resources/shaders/glsl%i/ssao_ao.fs", GLSL_VERSION));
+    int aoResLoc      = GetShaderLocation(aoShader, "resolution");
+    int aoAoResLoc    = GetShaderLocation(aoShader, "aoResolution");
+    int aoNearLoc     = GetShaderLocation(aoShader, "near");
+    int aoFarLoc      = GetShaderLocation(aoShader, "far");
+    int aoJitterLoc   = GetShaderLocation(aoShader, "jitter");
+    int aoTemporalLoc = GetShaderLocation(aoShader, "temporal");
+    int aoInvVPLoc    = GetShaderLocation(aoShader, "invViewProj");
+    int aoPrevVPLoc   = GetShaderLocation(aoShader, "prevViewProj");
+    int aoHistoryLoc  = GetShaderLocation(aoShader, "texture1");
+    RenderTexture2D aoRT[2] = { 0 };    // ping-pong: current + history for temporal presets
+    int aoRTWidth = 0, aoRTHeight = 0, aoCurrent = 0;
+    bool aoHistoryValid = false;
+    unsigned int aoFrame = 0;
+    Matrix sceneViewProj = MatrixIdentity(), prevSceneViewProj = MatrixIdentity();
+    printf("[SSAO] preset %s\n", SSAO_PRESETS[ssaoPreset].name);
 
     // --- FXAA post-process ---
     Shader fxaaShader = LoadShader(NULL,
@@ -415,24 +540,37 @@ int main(void)
     RenderTexture2D colorGradeRT = LoadRenderTexture(fxaaRTWidth, fxaaRTHeight);
 
     // --- Shadow map setup (color+depth FBO for guaranteed completeness) ---
-    #define SHADOW_MAP_SIZE 2048
-    RenderTexture2D shadowRT = { 0 };
-    shadowRT.id = rlLoadFramebuffer();
-    shadowRT.texture.id = rlLoadTexture(NULL, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
-    shadowRT.texture.width = SHADOW_MAP_SIZE;
-    shadowRT.texture.height = SHADOW_MAP_SIZE;
-    shadowRT.texture.format = RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
-    shadowRT.texture.mipmaps = 1;
-    shadowRT.depth.id = rlLoadTextureDepth(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, false);
-    shadowRT.depth.width = SHADOW_MAP_SIZE;
-    shadowRT.depth.height = SHADOW_MAP_SIZE;
-    rlFramebufferAttach(shadowRT.id, shadowRT.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
-    rlFramebufferAttach(shadowRT.id, shadowRT.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
-    if (!rlFramebufferComplete(shadowRT.id)) TraceLog(LOG_ERROR, "Shadow map FBO is not complete!");
+    // Static casters (floor tiles at rest, env pieces) only change with the layout, so
+    // they're rendered into shadowStaticRT when invalidated; each frame copies that into
+    // shadowRT and draws only the units and wobbling tiles on top
+    RenderTexture2D shadowRT = LoadShadowTarget(shadowMapSize);
+    RenderTexture2D shadowStaticRT = LoadShadowTarget(shadowMapSize);
+    bool shadowStaticDirty = true;
+    printf("[SHADOW] %dx%d shadow map\n", shadowMapSize, shadowMapSize);
 
     Shader shadowDepthShader = LoadShader(
         TextFormat("resources/shaders/glsl%i/shadow_depth.vs", GLSL_VERSION),
         TextFormat("resources/shaders/glsl%i/shadow_depth.fs", GLSL_VERSION));
+    shadowDepthShader.locs[SHADER_LOC_BONE_MATRICES] = GetShaderLocation(shadowDepthShader, "boneMatrices");
+    shadowDepthShader.locs[SHADER_LOC_VERTEX_BONEIDS] = GetShaderLocationAttrib(shadowDepthShader, "vertexBoneIds");
+    shadowDepthShader.locs[SHADER_LOC_VERTEX_BONEWEIGHTS] = GetShaderLocationAttrib(shadowDepthShader, "vertexBoneWeights");
+    // Instanced variants: same programs, so they share every uniform, but the model-matrix
+    // slot names the per-instance attribute DrawMeshInstanced feeds. The "instanced"
+    // uniform tells the vertex shader which of the two to use.
+    static int lightInstLocs[RL_MAX_SHADER_LOCATIONS], shadowInstLocs[RL_MAX_SHADER_LOCATIONS];
+    Shader lightShaderInst = lightShader, shadowDepthShaderInst = shadowDepthShader;
+    memcpy(lightInstLocs, lightShader.locs, sizeof(lightInstLocs));
+    memcpy(shadowInstLocs, shadowDepthShader.locs, sizeof(shadowInstLocs));
+    lightShaderInst.locs = lightInstLocs;
+    shadowDepthShaderInst.locs = shadowInstLocs;
+    lightInstLocs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(lightShader, "instanceTransform");
+    shadowInstLocs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shadowDepthShader, "instanceTransform");
+    int lightInstancedLoc = GetShaderLocation(lightShader, "instanced");
+    int shadowInstancedLoc = GetShaderLocation(shadowDepthShader, "instanced");
+    // Set around each posed unit draw; everything else draws with skinning off, whatever
+    // the (disabled) bone attributes of a static mesh happen to hold
+    int lightSkinnedLoc = GetShaderLocation(lightShader, "skinned");
+    int shadowSkinnedLoc = GetShaderLocation(shadowDepthShader, "skinned");
 
     // Light-space matrix (static directional light)
     Vector3 shadowLightPos = { 40.0f, 60.0f, -30.0f };
@@ -558,6 +696,20 @@ int main(void)
     } while(0)
     GENERATE_TILE_GRID();
     const float tileScale = TILE_WORLD_SIZE / 156.0f * 0.9f;
+    // Per-variant instance transforms, rebuilt each frame and drawn with one
+    // DrawMeshInstanced per variant mesh in both the shadow and main passes
+    static Matrix tileInstances[TILE_VARIANTS][TILE_GRID_SIZE * TILE_GRID_SIZE];
+    int tileInstanceCount[TILE_VARIANTS];
+    // The shadow pass splits them: tiles baked into the static shadow cache, and the
+    // ones wobbling or recently wobbled when it was last built, redrawn each frame
+    static Matrix tileStaticInstances[TILE_VARIANTS][TILE_GRID_SIZE * TILE_GRID_SIZE];
+    static Matrix tileDynamicInstances[TILE_VARIANTS][TILE_GRID_SIZE * TILE_GRID_SIZE];
+    int tileStaticCount[TILE_VARIANTS], tileDynamicCount[TILE_VARIANTS];
+    bool tileInShadowCache[TILE_GRID_SIZE][TILE_GRID_SIZE] = { 0 };
+    float tileStillTime[TILE_GRID_SIZE][TILE_GRID_SIZE];    // seconds since the tile last wobbled
+    for (int r = 0; r < TILE_GRID_SIZE; r++)
+        for (int c = 0; c < TILE_GRID_SIZE; c++) tileStillTime[r][c] = SHADOW_TILE_SETTLE;
+    float shadowStaticAge = 0.0f;   // seconds since the static cache was rebuilt
 
     // Border barrier shader + mesh
     Shader borderShader = LoadShader("resources/shaders/glsl330/border.vs",
@@ -600,10 +752,30 @@ int main(void)
     UnitSnapshot snapshots[MAX_UNITS] = { 0 };
     int snapshotCount = 0;
 
+    // Shop/wave/plaza randomness (combat itself is deterministic)
+    Rng gameRng;
+    RngSeed(&gameRng, (uint64_t)time(NULL));
+
+#ifdef COMBAT_PROFILE
+    // Combat profiling overlay (F7) — current battle + everything since launch
+    CombatProfile combatProf = { 0 };
+    CombatProfile sessionProf = { 0 };
+    bool combatProfOverlay = false;
+#endif
+
     // Modifiers, projectiles, economy
     Modifier modifiers[MAX_MODIFIERS] = { 0 };
-    Projectile projectiles[MAX_PROJECTILES] = { 0 };
-    Particle particles[MAX_PARTICLES] = { 0 };
+    ProjectilePool projectilePool;
+    InitProjectilePool(&projectilePool, 0);
+    Projectile *projectiles = projectilePool.items;
+    CombatEventQueue combatEvents;
+    CombatEventQueueInit(&combatEvents);
+    static ClientSim clientSim;     // combat sim thread (started on the first combat frame)
+    if (recordReplays) {
+        mkdir("replays", 0755);
+        clientSim.replayDir = "replays";
+    }
+    static ParticleSystem particles;
     int playerGold = 25;
     int goldPerRound = 15;
     int rollCost = 1;
@@ -638,6 +810,7 @@ int main(void)
     float fightBannerTimer = -1.0f;  // <0 = inactive
     float slowmoTimer = 0.0f;        // >0 = slow motion active
     float slowmoScale = 1.0f;
+    float animFrameAccum = 0.0f;     // fractional anim frames carried between render frames
     // Kill feed
     int killCount = 0;               // total kills this round
     int multiKillCount = 0;          // rapid consecutive kills by same team
@@ -969,6 +1142,12 @@ int main(void)
         envModelCount++;
     }
 
+    // Depth-only material sets, so the shadow pass never rewrites model materials
+    for (int i = 0; i < unitTypeCount; i++)
+        if (unitTypes[i].loaded) unitTypes[i].depthMaterials = LoadPassMaterials(unitTypes[i].model, shadowDepthShader);
+    for (int i = 0; i < envModelCount; i++)
+        if (envModels[i].loaded) envModels[i].depthMaterials = LoadPassMaterials(envModels[i].model, shadowDepthShader);
+
     // --- Env pieces array (populated from save file) ---
     EnvPiece envPieces[MAX_ENV_PIECES] = {0};
     int envPieceCount = 0;
@@ -1016,6 +1195,10 @@ int main(void)
         envPieces[envPieceCount++] = (EnvPiece){ .modelIndex = 3, .position = {0, 0, -140},
             .rotationY = 0, .scale = 1.0f, .active = true };
     }
+    // Scenery is drawn from static batches; the editor (debug mode) draws pieces one
+    // by one so they can move, and the batch is rebuilt once the layout settles
+    static EnvBatch envBatch;
+    EnvBatchBuild(&envBatch, envModels, envPieces, envPieceCount);
     int plazaHoverObject = 0;  // 0=none, 1=trophy, 2=door
     float plazaSparkleTimer = 0.0f;  // for sparkle effect on objects
 
@@ -1051,6 +1234,12 @@ int main(void)
     // --- Multiplayer state ---
     NetClient netClient;
     net_client_init(&netClient);
+    static StreamClient combatStream;   // authoritative snapshots, if --stream-combat
+    if (streamHz > 0) {
+        StreamClientBegin(&combatStream, &combatEvents);
+        combatStream.active = false;    // until the first MSG_COMBAT_START
+        netClient.stream = &combatStream;
+    }
     bool isMultiplayer = false;
     bool playerReady = false;
     bool mpNameFieldFocused = true;
@@ -1069,9 +1258,9 @@ int main(void)
     int playBtnH = 40;
 
     // Spawn initial plaza enemies
-    PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+    PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
 
-    SetTargetFPS(60);
+    SetTargetFPS(targetFps);
 
     // --- NFC Bridge Subprocess ---
     FILE *nfcPipe = popen("../nfc/build/bridge", "r");
@@ -1139,10 +1328,17 @@ int main(void)
             multiKillTimer -= rawDt;
             if (multiKillTimer <= 0.0f) multiKillCount = 0;
         }
+        // Whole animation frames due this render frame
+        animFrameAccum += dt * ANIM_FRAME_RATE;
+        int animSteps = (int)animFrameAccum;
+        animFrameAccum -= (float)animSteps;
         GamePhase prevPhase = phase;
         UpdateShake(&shake, dt);
         if (IsKeyPressed(KEY_F1)) debugMode = !debugMode;
         if (IsKeyPressed(KEY_F6)) cgDebugOverlay = !cgDebugOverlay;
+#ifdef COMBAT_PROFILE
+        if (IsKeyPressed(KEY_F7)) combatProfOverlay = !combatProfOverlay;
+#endif
         if (cgDebugOverlay) {
             float step = 0.01f;
             if (IsKeyDown(KEY_ONE))   cgExposure    += step;
@@ -1158,6 +1354,10 @@ int main(void)
             if (IsKeyDown(KEY_MINUS)) cgVignetteSoft += step;
             if (IsKeyDown(KEY_EQUAL)) cgVignetteSoft -= step;
         }
+        if (IsKeyPressed(KEY_F8)) {
+            ssaoPreset = (SsaoPreset)((ssaoPreset + 1) % SSAO_PRESET_COUNT);
+            printf("[SSAO] preset %s\n", SSAO_PRESETS[ssaoPreset].name);
+        }
         if (IsKeyPressed(KEY_F10)) {
             shadowDebugMode = (shadowDebugMode + 1) % 5;
             SetShaderValue(lightShader, shadowDebugLoc, &shadowDebugMode, SHADER_UNIFORM_INT);
@@ -1222,7 +1422,7 @@ int main(void)
             UnitType *itype = &unitTypes[intro.typeIndex];
             if (itype->hasAnimations && itype->animIndex[ANIM_IDLE] >= 0) {
                 int fc = itype->idleAnims[itype->animIndex[ANIM_IDLE]].frameCount;
-                if (fc > 0) intro.animFrame = (intro.animFrame + 1) % fc;
+                if (fc > 0) intro.animFrame = (intro.animFrame + animSteps) % fc;
             }
             if (intro.timer >= INTRO_DURATION) {
                 intro.active = false;
@@ -1255,7 +1455,7 @@ int main(void)
                 statueSpawn.phase = SSPAWN_INACTIVE;
             } else {
                 int phaseBefore = statueSpawn.phase;
-                UpdateStatueSpawn(&statueSpawn, particles, &shake, units[si].position, dt);
+                UpdateStatueSpawn(&statueSpawn, &particles, &shake, units[si].position, dt);
                 if (phaseBefore != SSPAWN_FALLING && statueSpawn.phase == SSPAWN_FALLING)
                     PlaySound(sfxCharacterFall);
                 if (statueSpawn.phase == SSPAWN_DONE) {
@@ -1510,7 +1710,7 @@ int main(void)
                     plazaState = PLAZA_FLEEING;
                 }
             } else if (plazaState == PLAZA_FLEEING) {
-                bool allGone = PlazaUpdateFlee(units, unitCount, plazaData, particles, dt);
+                bool allGone = PlazaUpdateFlee(units, unitCount, plazaData, &particles, dt);
                 if (allGone) {
                     // All enemies fled — initialize game state and transition to prep
                     ClearRedUnits(units, &unitCount);
@@ -1523,16 +1723,16 @@ int main(void)
                     deathPenalty = false;
                     roundResultText = "";
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
+                    ClearAllProjectiles(&projectilePool);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     statueSpawn.phase = SSPAWN_INACTIVE;
                     playerGold = 25;
                     for (int i = 0; i < MAX_INVENTORY_SLOTS; i++) inventory[i].abilityId = -1;
-                    RollShop(shopSlots, &playerGold, 0);
+                    RollShop(&gameRng, shopSlots, &playerGold, 0);
                     rollCost = rollCostBase;
                     dragState.dragging = false;
-                    SpawnWave(units, &unitCount, 0, unitTypeCount);
+                    SpawnWave(&gameRng, units, &unitCount, 0, unitTypeCount);
                     waveUpgradeText[0] = '\0';
                     phase = PHASE_PREP;
                 }
@@ -1788,6 +1988,7 @@ int main(void)
                                 }
                                 fclose(fp);
                                 envSaveFlashTimer = 2.0f;
+                                EnvBatchBuild(&envBatch, envModels, envPieces, envPieceCount);
                             }
                         }
                     }
@@ -1856,7 +2057,7 @@ int main(void)
                 isMultiplayer = false;
                 unitCount = 0;
                 memset(plazaData, 0, sizeof(plazaData));
-                PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                 plazaState = PLAZA_ROAMING;
                 phase = PHASE_PLAZA;
             }
@@ -1864,6 +2065,7 @@ int main(void)
             if (netClient.gameStarted) {
                 netClient.gameStarted = false;
                 playerGold = netClient.currentGold;
+                if (netClient.stream) net_client_send_stream_request(&netClient, streamHz);
             }
 
             if (netClient.prepStarted) {
@@ -1880,8 +2082,8 @@ int main(void)
                 redWins = 0;
                 roundResultText = "";
                 ClearAllModifiers(modifiers);
-                ClearAllProjectiles(projectiles);
-                ClearAllParticles(particles);
+                ClearAllProjectiles(&projectilePool);
+                ClearAllParticles(&particles);
                 ClearAllFloatingTexts(floatingTexts);
                 ClearAllFissures(fissures);
                 dragState.dragging = false;
@@ -1895,7 +2097,7 @@ int main(void)
                 isMultiplayer = false;
                 unitCount = 0;
                 memset(plazaData, 0, sizeof(plazaData));
-                PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                 plazaState = PLAZA_ROAMING;
                 phase = PHASE_PLAZA;
             }
@@ -1913,7 +2115,7 @@ int main(void)
                     isMultiplayer = false;
                     unitCount = 0;
                     memset(plazaData, 0, sizeof(plazaData));
-                    PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                    PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                     plazaState = PLAZA_ROAMING;
                     phase = PHASE_PLAZA;
                 }
@@ -1980,8 +2182,11 @@ int main(void)
                     slowmoTimer = 0.0f; slowmoScale = 1.0f;
                     BattleLogClear(&battleLog); combatElapsedTime = 0.0f;
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
-                    ClearAllParticles(particles);
+                    InitProjectilePool(&projectilePool, 0);
+#ifdef COMBAT_PROFILE
+                    CombatProfileReset(&combatProf);
+#endif
+                    ClearAllParticles(&particles);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     dragState.dragging = false;
@@ -2004,11 +2209,11 @@ int main(void)
                 if (!units[i].active) continue;
                 if (IsUnitInStatueSpawn(&statueSpawn, i)) continue;
                 float targetY = units[i].dragging ? 5.0f : 0.0f;
-                units[i].position.y += (targetY - units[i].position.y) * 0.1f;
+                units[i].position.y += (targetY - units[i].position.y) * FrameLerp(0.1f, dt);
             }
 
             // Update particles during prep (so impact particles decay)
-            UpdateParticles(particles, dt);
+            UpdateParticles(&particles, dt);
 
             // Dragging
             for (int i = 0; i < unitCount; i++)
@@ -2113,7 +2318,7 @@ int main(void)
                     if (isMultiplayer) {
                         net_client_send_roll(&netClient);
                     } else {
-                        RollShop(shopSlots, &playerGold, rollCost);
+                        RollShop(&gameRng, shopSlots, &playerGold, rollCost);
                     }
                     rollCost += rollCostIncrement;
                     TriggerShake(&shake, 2.0f, 0.15f);
@@ -2179,7 +2384,7 @@ int main(void)
                             ClearRedUnits(units, &unitCount);
                             CompactBlueUnits(units, &unitCount);
                             memset(plazaData, 0, sizeof(plazaData));
-                            PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                            PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                             plazaState = PLAZA_ROAMING;
                             phase = PHASE_PLAZA;
                         }
@@ -2231,8 +2436,11 @@ int main(void)
                             slowmoTimer = 0.0f; slowmoScale = 1.0f;
                             BattleLogClear(&battleLog); combatElapsedTime = 0.0f;
                             ClearAllModifiers(modifiers);
-                            ClearAllProjectiles(projectiles);
-                            ClearAllParticles(particles);
+                            InitProjectilePool(&projectilePool, 0);
+#ifdef COMBAT_PROFILE
+                            CombatProfileReset(&combatProf);
+#endif
+                            ClearAllParticles(&particles);
                             ClearAllFloatingTexts(floatingTexts);
                             ClearAllFissures(fissures);
                             // Snap any mid-fall statue to ground before combat
@@ -2317,7 +2525,7 @@ int main(void)
                         ci++;
                         if (CheckCollisionPointRec(mouse, r) && unitTypes[i].loaded) {
                             if (SpawnUnit(units, &unitCount, i, TEAM_RED))
-                                AssignRandomAbilities(&units[unitCount-1], GetRandomValue(1, 2));
+                                AssignRandomAbilities(&gameRng, &units[unitCount-1], RngRange(&gameRng, 1, 2));
                             clickedButton = true; break;
                         }
                     }
@@ -2360,6 +2568,7 @@ int main(void)
                                 }
                                 fclose(fp);
                                 envSaveFlashTimer = 2.0f;
+                                EnvBatchBuild(&envBatch, envModels, envPieces, envPieceCount);
                             }
                             clickedButton = true;
                         }
@@ -2374,7 +2583,7 @@ int main(void)
                         if (isMultiplayer) {
                             net_client_send_roll(&netClient);
                         } else {
-                            RollShop(shopSlots, &playerGold, rollCost);
+                            RollShop(&gameRng, shopSlots, &playerGold, rollCost);
                         }
                         rollCost += rollCostIncrement;
                         TriggerShake(&shake, 2.0f, 0.15f);
@@ -2671,31 +2880,178 @@ int main(void)
         //------------------------------------------------------------------------------
         else if (phase == PHASE_COMBAT)
         {
-            combatElapsedTime += dt;
+            // === Simulate: the sim thread runs the same deterministic tick the server
+            // runs; take its newest snapshot and interpolate toward it. A streamed
+            // battle shows the server's snapshots instead ===
+            if (isMultiplayer && combatStream.active) {
+                StreamClientApply(&combatStream, ClientSimNow(), units, modifiers, &projectilePool, fissures);
+                combatElapsedTime = (float)combatStream.renderTime;
+            } else {
+                if (!clientSim.running)
+                    ClientSimStart(&clientSim, units, unitCount, &combatEvents, simThreaded);
+                ClientSimSetTimeScale(&clientSim, slowmoScale);
+                ClientSimPump(&clientSim);
+                const ClientSimSnapshot *simSnap = ClientSimLatest(&clientSim);
+                ClientSimApply(simSnap, ClientSimAlpha(simSnap, ClientSimNow()),
+                               units, modifiers, &projectilePool, fissures);
+                combatElapsedTime = simSnap->arena.simTime;
+#ifdef COMBAT_PROFILE
+                // The sim thread keeps writing its own copy; take the published one
+                combatProf = simSnap->prof;
+#endif
+            }
 
-            // === STEP 1: Tick modifiers ===
-            for (int m = 0; m < MAX_MODIFIERS; m++) {
-                if (!modifiers[m].active) continue;
-                int ui = modifiers[m].unitIndex;
-                if (ui < 0 || ui >= unitCount || !units[ui].active) {
-                    modifiers[m].active = false; continue;
-                }
-                if (modifiers[m].duration > 0) {
-                    modifiers[m].duration -= dt;
-                    if (modifiers[m].duration <= 0) {
-                        if (modifiers[m].type == MOD_SHIELD) units[ui].shieldHP = 0;
-                        modifiers[m].active = false; continue;
+            // === Present: turn this tick's events into sound, particles, shake and UI ===
+            CombatEvent event;
+            while (CombatEventPop(&combatEvents, &event)) {
+                const CombatEvent *ev = &event;
+                switch (ev->type) {
+                case COMBAT_EVT_SHAKE:
+                    TriggerShake(&shake, ev->value1, ev->value2);
+                    break;
+                case COMBAT_EVT_ABILITY_CAST: {
+                    const AbilityDef *def = &ABILITY_DEFS[ev->abilityId];
+                    const Unit *caster = &units[ev->unitIndex];
+                    PlaySound(sfxMagicHit);
+                    PlaySound(caster->typeIndex == 0 ? sfxToadShout : sfxGoblinShout);
+                    SpawnFloatingText(floatingTexts, caster->position,
+                        def->name, def->color, 1.0f);
+                    BattleLogAddCast(&battleLog, combatElapsedTime, caster->team, caster->typeIndex, ev->abilityId);
+                    if (ev->abilityId == ABILITY_EARTHQUAKE) {
+                        float eqRadius = def->values[(int)ev->value1][AV_EQ_RADIUS];
+                        // Earth particles
+                        ParticleBurst earth = {
+                            .position = { ev->position.x, 0.5f, ev->position.z }, .spread = eqRadius,
+                            .speedMin = 5.0f, .speedMax = 5.0f, .upMin = 3.0f, .upMax = 8.0f,
+                            .lifeMin = 0.6f, .lifeMax = 0.6f, .sizeMin = 0.4f, .sizeMax = 1.0f,
+                            .color = { 160, 112, 48, 255 }, .shadeMin = 0.5f,
+                        };
+                        SpawnParticleBurst(&particles, &earth, 20);
+                        // Aggressive tile ripple from earthquake epicenter
+                        float gridOriginEq = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
+                        for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
+                            for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
+                                float cx = gridOriginEq + (tc + 0.5f) * TILE_WORLD_SIZE;
+                                float cz = gridOriginEq + (tr + 0.5f) * TILE_WORLD_SIZE;
+                                float dxw = cx - ev->position.x, dzw = cz - ev->position.z;
+                                float dist = sqrtf(dxw*dxw + dzw*dzw);
+                                float wobbleR = eqRadius * 3.0f;
+                                if (dist < wobbleR) {
+                                    float strength = expf(-1.5f * dist / wobbleR);
+                                    tileWobble[tr][tc] = TILE_WOBBLE_MAX * 1.5f * strength;
+                                    tileWobbleTime[tr][tc] = -(dist * 0.012f);
+                                    float len = dist > 0.1f ? dist : 1.0f;
+                                    tileWobbleDirX[tr][tc] = dzw / len;
+                                    tileWobbleDirZ[tr][tc] = -dxw / len;
+                                }
+                            }
+                        }
                     }
-                }
-                // Per-tick effects
-                if (modifiers[m].type == MOD_DIG_HEAL) {
-                    const UnitStats *s = &UNIT_STATS[units[ui].typeIndex];
-                    units[ui].currentHealth += modifiers[m].value * dt;
-                    if (units[ui].currentHealth > s->health) units[ui].currentHealth = s->health;
+                } break;
+                case COMBAT_EVT_DAMAGE:
+                    units[ev->unitIndex].hitFlash = HIT_FLASH_DURATION;
+                    SpawnDamageNumber(floatingTexts, ev->position, ev->value1, ev->abilityId >= 0);
+                    break;
+                case COMBAT_EVT_ATTACK:
+                    units[ev->unitIndex].attackAnimTimer = 0.4f;
+                    break;
+                case COMBAT_EVT_MELEE_HIT: {
+                    PlaySound(sfxMeleeHit);
+                    SpawnMeleeImpact(&particles, ev->position);
+                    // Minor tile wobble on melee hit
+                    float gridOriginMH = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
+                    for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
+                        for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
+                            float cx = gridOriginMH + (tc + 0.5f) * TILE_WORLD_SIZE;
+                            float cz = gridOriginMH + (tr + 0.5f) * TILE_WORLD_SIZE;
+                            float dxw = cx - ev->position.x, dzw = cz - ev->position.z;
+                            float dist = sqrtf(dxw*dxw + dzw*dzw);
+                            float wobbleR = 25.0f;
+                            if (dist < wobbleR) {
+                                float strength = expf(-2.0f * dist / wobbleR) * 0.2f;
+                                if (tileWobble[tr][tc] < TILE_WOBBLE_MAX * strength) {
+                                    tileWobble[tr][tc] = TILE_WOBBLE_MAX * strength;
+                                    tileWobbleTime[tr][tc] = -(dist * 0.008f);
+                                    float len = dist > 0.1f ? dist : 1.0f;
+                                    tileWobbleDirX[tr][tc] = dzw / len;
+                                    tileWobbleDirZ[tr][tc] = -dxw / len;
+                                }
+                            }
+                        }
+                    }
+                } break;
+                case COMBAT_EVT_KILL: {
+                    const Unit *victim = &units[ev->unitIndex];
+                    PlaySound(victim->typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
+                    SpawnDeathExplosion(&particles, ev->position, victim->team);
+                    TriggerShake(&shake, 6.0f, 0.3f);
+
+                    // Kill feed
+                    { Team killerTeam = (victim->team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
+                    if (killerTeam != lastKillTeam) multiKillCount = 0;
+                    lastKillTeam = killerTeam; }
+                    killCount++; multiKillCount++; multiKillTimer = 2.0f;
+                    if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
+                    else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
+                    else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
+                    else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
+                    // Slow-mo check: did this kill wipe a team?
+                    int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
+                    if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
+                    if (ev->sourceIndex >= 0) {
+                        const Unit *killer = &units[ev->sourceIndex];
+                        BattleLogAddKill(&battleLog, combatElapsedTime, killer->team, killer->typeIndex,
+                            victim->team, victim->typeIndex, ev->abilityId);
+                    }
+                } break;
+                case COMBAT_EVT_STUN:
+                    if (ev->abilityId == ABILITY_STONE_GAZE)
+                        SpawnFloatingText(floatingTexts, ev->position,
+                            "PETRIFIED!", (Color){160, 80, 200, 255}, 1.0f);
+                    break;
+                case COMBAT_EVT_PROJECTILE_SPAWN:
+                    // Devil bolts are basic attacks — whoosh on the shot as well as the launch
+                    if (ev->abilityId < 0) PlaySound(sfxProjectileWhoosh);
+                    break;
+                case COMBAT_EVT_PROJECTILE_LAUNCH:
+                    PlaySound(sfxProjectileWhoosh);
+                    break;
+                case COMBAT_EVT_PROJECTILE_IMPACT: {
+                    PlaySound(sfxProjectileHit);
+                    // Impact explosion particles + tile shake
+                    ParticleBurst explode = {
+                        .position = ev->position, .speedMin = 10.0f, .speedMax = 25.0f,
+                        .upMin = 4.0f, .upMax = 15.0f, .lifeMin = 0.7f, .lifeMax = 0.7f,
+                        .sizeMin = 7.0f, .sizeMax = 13.0f, .color = ev->color, .shadeMin = 1.0f,
+                    };
+                    SpawnParticleBurst(&particles, &explode, PROJ_EXPLODE_COUNT);
+                    TriggerShake(&shake, 4.0f, 0.2f);
+                    // Tile wobble ripple from impact
+                    float gridOriginImp = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
+                    for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
+                        for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
+                            float cx = gridOriginImp + (tc + 0.5f) * TILE_WORLD_SIZE;
+                            float cz = gridOriginImp + (tr + 0.5f) * TILE_WORLD_SIZE;
+                            float dxw = cx - ev->position.x, dzw = cz - ev->position.z;
+                            float dist = sqrtf(dxw*dxw + dzw*dzw);
+                            float wobbleR = 50.0f;
+                            if (dist < wobbleR) {
+                                float strength = expf(-2.0f * dist / wobbleR);
+                                if (tileWobble[tr][tc] < TILE_WOBBLE_MAX * 0.5f * strength) {
+                                    tileWobble[tr][tc] = TILE_WOBBLE_MAX * 0.5f * strength;
+                                    tileWobbleTime[tr][tc] = -(dist * 0.008f);
+                                    float len = dist > 0.1f ? dist : 1.0f;
+                                    tileWobbleDirX[tr][tc] = dzw / len;
+                                    tileWobbleDirZ[tr][tc] = -dxw / len;
+                                }
+                            }
+                        }
+                    }
+                } break;
                 }
             }
 
-            // === STEP 1b: Spawn dig particles + update all particles ===
+            // === Continuous effects: dig dirt and projectile trails ===
             for (int i = 0; i < unitCount; i++) {
                 if (!units[i].active) continue;
                 if (UnitHasModifier(modifiers, i, MOD_DIG_HEAL)) {
@@ -2720,761 +3076,40 @@ int main(void)
                         Color brown = { (unsigned char)shade, (unsigned char)(shade * 0.6f),
                                         (unsigned char)(shade * 0.3f), 255 };
                         float sz = (float)GetRandomValue(3, 8) / 10.0f;
-                        SpawnParticle(particles, pos, vel, 0.5f + (float)GetRandomValue(0, 3) / 10.0f, sz, brown);
-                    }
-                }
-            }
-            UpdateParticles(particles, dt);
-            UpdateFloatingTexts(floatingTexts, dt);
-
-            // === STEP 2: Update projectiles ===
-            for (int p = 0; p < MAX_PROJECTILES; p++) {
-                if (!projectiles[p].active) continue;
-                // Charge-up phase: stay in place and grow
-                if (projectiles[p].chargeTimer > 0) {
-                    projectiles[p].chargeTimer -= dt;
-                    if (projectiles[p].chargeTimer > 0) continue;
-                    PlaySound(sfxProjectileWhoosh);
-                }
-                int ti = projectiles[p].targetIndex;
-                // Target gone?
-                if (ti < 0 || ti >= unitCount || !units[ti].active) {
-                    if ((projectiles[p].type == PROJ_CHAIN_FROST || projectiles[p].type == PROJ_MAELSTROM) && projectiles[p].bouncesRemaining > 0) {
-                        int next = FindChainFrostTarget(units, unitCount, projectiles[p].position,
-                            projectiles[p].sourceTeam, projectiles[p].lastHitUnit, projectiles[p].bounceRange);
-                        if (next >= 0) { projectiles[p].targetIndex = next; continue; }
-                    }
-                    projectiles[p].active = false; continue;
-                }
-                // Move toward target
-                Vector3 tgt = { units[ti].position.x, units[ti].position.y + 3.0f, units[ti].position.z };
-                float pdx = tgt.x - projectiles[p].position.x;
-                float pdy = tgt.y - projectiles[p].position.y;
-                float pdz = tgt.z - projectiles[p].position.z;
-                float pdist = sqrtf(pdx*pdx + pdy*pdy + pdz*pdz);
-                float pstep = projectiles[p].speed * dt;
-
-                if (pdist <= pstep) {
-                    PlaySound(sfxProjectileHit);
-                    // Impact explosion particles + tile shake
-                    {
-                        Vector3 impactPos = projectiles[p].position;
-                        for (int ep = 0; ep < PROJ_EXPLODE_COUNT; ep++) {
-                            float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-                            float spd = (float)GetRandomValue(100, 250) / 10.0f;
-                            Vector3 ev = {
-                                cosf(angle) * spd,
-                                (float)GetRandomValue(40, 150) / 10.0f,
-                                sinf(angle) * spd,
-                            };
-                            SpawnParticle(particles, impactPos, ev, 0.7f,
-                                (float)GetRandomValue(70, 130) / 10.0f, projectiles[p].color);
-                        }
-                        TriggerShake(&shake, 4.0f, 0.2f);
-                        // Tile wobble ripple from impact
-                        float gridOriginImp = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
-                        for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
-                            for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
-                                float cx = gridOriginImp + (tc + 0.5f) * TILE_WORLD_SIZE;
-                                float cz = gridOriginImp + (tr + 0.5f) * TILE_WORLD_SIZE;
-                                float dxw = cx - impactPos.x, dzw = cz - impactPos.z;
-                                float dist = sqrtf(dxw*dxw + dzw*dzw);
-                                float wobbleR = 50.0f;
-                                if (dist < wobbleR) {
-                                    float strength = expf(-2.0f * dist / wobbleR);
-                                    if (tileWobble[tr][tc] < TILE_WOBBLE_MAX * 0.5f * strength) {
-                                        tileWobble[tr][tc] = TILE_WOBBLE_MAX * 0.5f * strength;
-                                        tileWobbleTime[tr][tc] = -(dist * 0.008f);
-                                        float len = dist > 0.1f ? dist : 1.0f;
-                                        tileWobbleDirX[tr][tc] = dzw / len;
-                                        tileWobbleDirZ[tr][tc] = -dxw / len;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // HIT — Hook: damage by distance, then pull target to caster
-                    if (projectiles[p].type == PROJ_HOOK) {
-                        if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                            float hookDist = DistXZ(units[ti].position, units[projectiles[p].sourceIndex].position);
-                            float hitDmg = hookDist * projectiles[p].damage;
-                            if (units[ti].shieldHP > 0) {
-                                if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                                else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                            }
-                            units[ti].currentHealth -= hitDmg;
-                            units[ti].hitFlash = HIT_FLASH_DURATION;
-                            SpawnDamageNumber(floatingTexts, units[ti].position, hitDmg, true);
-
-                            if (units[ti].currentHealth <= 0) {
-                                PlaySound(units[ti].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                                SpawnDeathExplosion(particles, units[ti].position, units[ti].team);
-                                TriggerShake(&shake, 6.0f, 0.3f);
-
-                                // Kill feed
-                                { Team killerTeam = (units[ti].team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
-                                if (killerTeam != lastKillTeam) multiKillCount = 0;
-                                lastKillTeam = killerTeam; }
-                                killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                                if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                                // Slow-mo check: is this the last unit on a team?
-                                int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                                if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                                BattleLogAddKill(&battleLog, combatElapsedTime, units[projectiles[p].sourceIndex].team, units[projectiles[p].sourceIndex].typeIndex, units[ti].team, units[ti].typeIndex, ABILITY_HOOK);
-                                units[ti].active = false;
-                            } else {
-                                // Start pulling target to caster
-                                units[ti].hookPullDest = units[projectiles[p].sourceIndex].position;
-                                units[ti].hookPullSpeed = projectiles[p].speed;
-                                AddModifier(modifiers, ti, MOD_STUN, 10.0f, 0); // stun during pull (cleared on arrival)
-                            }
-                        }
-                        projectiles[p].active = false;
-                    }
-                    // HIT — Maelstrom: bounce like chain frost
-                    else if (projectiles[p].type == PROJ_MAELSTROM) {
-                        if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                            float hitDmg = projectiles[p].damage;
-                            if (units[ti].shieldHP > 0) {
-                                if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                                else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                            }
-                            units[ti].currentHealth -= hitDmg;
-                            units[ti].hitFlash = HIT_FLASH_DURATION;
-                            SpawnDamageNumber(floatingTexts, units[ti].position, hitDmg, true);
-
-                            if (units[ti].currentHealth <= 0) {
-                                PlaySound(units[ti].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                                SpawnDeathExplosion(particles, units[ti].position, units[ti].team);
-                                TriggerShake(&shake, 6.0f, 0.3f);
-
-                                { Team killerTeam = (units[ti].team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
-                                if (killerTeam != lastKillTeam) multiKillCount = 0;
-                                lastKillTeam = killerTeam; }
-                                killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                                if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                                int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                                if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                                BattleLogAddKill(&battleLog, combatElapsedTime, units[projectiles[p].sourceIndex].team, units[projectiles[p].sourceIndex].typeIndex, units[ti].team, units[ti].typeIndex, ABILITY_MAELSTROM);
-                                units[ti].active = false;
-                            }
-                        }
-                        if (projectiles[p].bouncesRemaining > 0) {
-                            projectiles[p].bouncesRemaining--;
-                            projectiles[p].lastHitUnit = ti;
-                            projectiles[p].position = units[ti].position;
-                            projectiles[p].position.y += 3.0f;
-                            int next = FindChainFrostTarget(units, unitCount, units[ti].position,
-                                projectiles[p].sourceTeam, ti, projectiles[p].bounceRange);
-                            if (next >= 0) projectiles[p].targetIndex = next;
-                            else projectiles[p].active = false;
-                        } else {
-                            projectiles[p].active = false;
-                        }
-                    }
-                    // HIT — Devil Bolt: flat damage ranged auto-attack
-                    else if (projectiles[p].type == PROJ_DEVIL_BOLT) {
-                        int si = projectiles[p].sourceIndex;
-                        if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                            float hitDmg = projectiles[p].damage;
-                            float armor = GetModifierValue(modifiers, ti, MOD_ARMOR);
-                            hitDmg -= armor;
-                            if (hitDmg < 0) hitDmg = 0;
-                            if (units[ti].shieldHP > 0) {
-                                if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                                else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                            }
-                            units[ti].currentHealth -= hitDmg;
-                            PlaySound(sfxProjectileHit);
-                            units[ti].hitFlash = HIT_FLASH_DURATION;
-                            SpawnDamageNumber(floatingTexts, units[ti].position, hitDmg, false);
-                            // Lifesteal from devil bolt
-                            if (si >= 0 && si < unitCount && units[si].active) {
-                                float ls = GetModifierValue(modifiers, si, MOD_LIFESTEAL);
-                                if (ls > 0) {
-                                    float maxHP = UNIT_STATS[units[si].typeIndex].health * units[si].hpMultiplier;
-                                    units[si].currentHealth += hitDmg * ls;
-                                    if (units[si].currentHealth > maxHP) units[si].currentHealth = maxHP;
-                                }
-                            }
-                            if (units[ti].currentHealth <= 0) {
-                                PlaySound(units[ti].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                                SpawnDeathExplosion(particles, units[ti].position, units[ti].team);
-                                TriggerShake(&shake, 4.0f, 0.2f);
-                                { Team killerTeam = (units[ti].team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
-                                if (killerTeam != lastKillTeam) multiKillCount = 0;
-                                lastKillTeam = killerTeam; }
-                                killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                                if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                                int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                                if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                                BattleLogAddKill(&battleLog, combatElapsedTime, units[si].team, units[si].typeIndex, units[ti].team, units[ti].typeIndex, -1);
-                                units[ti].active = false;
-                            }
-                        }
-                        projectiles[p].active = false;
-                    }
-                    // HIT — normal (Magic Missile / Chain Frost)
-                    else {
-                    if (!UnitHasModifier(modifiers, ti, MOD_INVULNERABLE)) {
-                        float hitDmg = projectiles[p].damage;
-                        // Magic Missile: damage is a fraction of target max HP
-                        if (projectiles[p].type == PROJ_MAGIC_MISSILE)
-                            hitDmg *= UNIT_STATS[units[ti].typeIndex].health;
-                        // Shield absorption
-                        if (units[ti].shieldHP > 0) {
-                            if (hitDmg <= units[ti].shieldHP) { units[ti].shieldHP -= hitDmg; hitDmg = 0; }
-                            else { hitDmg -= units[ti].shieldHP; units[ti].shieldHP = 0; }
-                        }
-                        units[ti].currentHealth -= hitDmg;
-                        units[ti].hitFlash = HIT_FLASH_DURATION;
-                        SpawnDamageNumber(floatingTexts, units[ti].position, hitDmg, true);
-                        if (projectiles[p].stunDuration > 0) {
-                            AddModifier(modifiers, ti, MOD_STUN, projectiles[p].stunDuration, 0);
-                            TriggerShake(&shake, 5.0f, 0.25f);
-                        }
-                        if (units[ti].currentHealth <= 0) {
-                            PlaySound(units[ti].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                            SpawnDeathExplosion(particles, units[ti].position, units[ti].team);
-                            TriggerShake(&shake, 6.0f, 0.3f);
-                            killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                            if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                            else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                            else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                            else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                            int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                            if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                            { int abilId = (projectiles[p].type == PROJ_MAGIC_MISSILE) ? ABILITY_MAGIC_MISSILE : ABILITY_CHAIN_FROST;
-                            BattleLogAddKill(&battleLog, combatElapsedTime, units[projectiles[p].sourceIndex].team, units[projectiles[p].sourceIndex].typeIndex, units[ti].team, units[ti].typeIndex, abilId); }
-                            units[ti].active = false;
-                        }
-                    }
-                    // Chain Frost bounce
-                    if (projectiles[p].type == PROJ_CHAIN_FROST && projectiles[p].bouncesRemaining > 0) {
-                        projectiles[p].bouncesRemaining--;
-                        projectiles[p].lastHitUnit = ti;
-                        projectiles[p].position = units[ti].position;
-                        projectiles[p].position.y += 3.0f;
-                        int next = FindChainFrostTarget(units, unitCount, units[ti].position,
-                            projectiles[p].sourceTeam, ti, projectiles[p].bounceRange);
-                        if (next >= 0) projectiles[p].targetIndex = next;
-                        else projectiles[p].active = false;
-                    } else {
-                        projectiles[p].active = false;
-                    }
-                    } // end else (normal projectile hit)
-                } else {
-                    projectiles[p].position.x += (pdx / pdist) * pstep;
-                    projectiles[p].position.y += (pdy / pdist) * pstep;
-                    projectiles[p].position.z += (pdz / pdist) * pstep;
-                    // Particle trail
-                    Color tc = projectiles[p].color;
-                    Vector3 tv = {
-                        ((GetRandomValue(0, 200) - 100) / 100.0f) * 3.0f,
-                        ((GetRandomValue(0, 100)) / 100.0f) * 4.0f + 3.0f,  // upward bias to fight gravity
-                        ((GetRandomValue(0, 200) - 100) / 100.0f) * 3.0f,
-                    };
-                    SpawnParticle(particles, projectiles[p].position, tv,
-                        PROJ_TRAIL_LIFE, PROJ_TRAIL_SIZE, tc);
-                }
-            }
-
-            // Update fissure lifetimes
-            UpdateFissures(fissures, dt);
-
-            // Build shared combat state for ability handlers
-            CombatState combatState = {
-                .units = units, .unitCount = unitCount,
-                .modifiers = modifiers, .projectiles = projectiles,
-                .particles = particles, .fissures = fissures,
-                .floatingTexts = floatingTexts, .shake = &shake,
-                .battleLog = &battleLog, .combatTime = combatElapsedTime,
-            };
-
-            // === STEP 3: Process each unit ===
-            for (int i = 0; i < unitCount; i++)
-            {
-                if (!units[i].active) continue;
-                const UnitStats *stats = &UNIT_STATS[units[i].typeIndex];
-                bool stunned = UnitHasModifier(modifiers, i, MOD_STUN);
-
-                // Tick ability cooldowns
-                for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                    if (units[i].abilities[a].abilityId < 0) continue;
-                    if (units[i].abilities[a].cooldownRemaining > 0)
-                        units[i].abilities[a].cooldownRemaining -= dt;
-                }
-
-                // Passive triggers (Dig, Sunder) — blocked by stun
-                if (!stunned) {
-                    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                        AbilitySlot *slot = &units[i].abilities[a];
-                        if (slot->abilityId == ABILITY_DIG) {
-                            if (slot->triggered || slot->cooldownRemaining > 0) continue;
-                            const AbilityDef *def = &ABILITY_DEFS[ABILITY_DIG];
-                            float threshold = def->values[slot->level][AV_DIG_HP_THRESH];
-                            float unitMaxHP = stats->health * units[i].hpMultiplier;
-                            if (units[i].currentHealth > 0 && units[i].currentHealth <= unitMaxHP * threshold) {
-                                slot->triggered = true;
-                                slot->cooldownRemaining = def->cooldown[slot->level];
-                                float healDur = def->values[slot->level][AV_DIG_HEAL_DUR];
-                                float healPerSec = unitMaxHP / healDur;
-                                AddModifier(modifiers, i, MOD_INVULNERABLE, healDur, 0);
-                                AddModifier(modifiers, i, MOD_DIG_HEAL, healDur, healPerSec);
-                            }
-                        } else if (slot->abilityId == ABILITY_SUNDER) {
-                            CheckPassiveSunder(&combatState, i);
-                        }
-                    }
-                }
-
-                // Hook pull movement — drag unit toward hook destination
-                if (units[i].hookPullSpeed > 0) {
-                    float hdx = units[i].hookPullDest.x - units[i].position.x;
-                    float hdz = units[i].hookPullDest.z - units[i].position.z;
-                    float hlen = sqrtf(hdx*hdx + hdz*hdz);
-                    float hstep = units[i].hookPullSpeed * dt;
-                    if (hlen <= hstep) {
-                        // Arrived at destination
-                        units[i].position.x = units[i].hookPullDest.x;
-                        units[i].position.z = units[i].hookPullDest.z;
-                        units[i].hookPullSpeed = 0;
-                        TriggerShake(&shake, 6.0f, 0.3f);
-                        // Remove the pull stun
-                        for (int m = 0; m < MAX_MODIFIERS; m++) {
-                            if (modifiers[m].active && modifiers[m].unitIndex == i && modifiers[m].type == MOD_STUN)
-                                modifiers[m].active = false;
-                        }
-                    } else {
-                        units[i].position.x += (hdx/hlen) * hstep;
-                        units[i].position.z += (hdz/hlen) * hstep;
-                    }
-                    continue; // skip normal movement while being pulled
-                }
-
-                bool digging = UnitHasModifier(modifiers, i, MOD_DIG_HEAL);
-                if (stunned || digging) continue;
-
-                // Find target
-                int target = FindClosestEnemy(units, unitCount, i);
-                units[i].targetIndex = target;
-
-                // Smooth rotation towards target
-                if (target >= 0 && units[target].active) {
-                    float dx = units[target].position.x - units[i].position.x;
-                    float dz = units[target].position.z - units[i].position.z;
-                    float goalAngle = atan2f(dx, dz) * (180.0f / PI);
-                    float diff = goalAngle - units[i].facingAngle;
-                    // Normalize to [-180, 180]
-                    while (diff > 180.0f) diff -= 360.0f;
-                    while (diff < -180.0f) diff += 360.0f;
-                    float turnSpeed = 360.0f; // degrees per second
-                    if (fabsf(diff) < turnSpeed * dt)
-                        units[i].facingAngle = goalAngle;
-                    else
-                        units[i].facingAngle += (diff > 0 ? 1.0f : -1.0f) * turnSpeed * dt;
-                }
-
-                // Tick ability cast delay
-                if (units[i].abilityCastDelay > 0)
-                    units[i].abilityCastDelay -= dt;
-
-                // Active ability casting — one per frame, clockwise rotation
-                bool castThisFrame = false;
-                if (units[i].abilityCastDelay <= 0)
-                for (int attempt = 0; attempt < MAX_ABILITIES_PER_UNIT && !castThisFrame; attempt++) {
-                    int slotIdx = ACTIVATION_ORDER[units[i].nextAbilitySlot];
-                    units[i].nextAbilitySlot = (units[i].nextAbilitySlot + 1) % MAX_ABILITIES_PER_UNIT;
-
-                    AbilitySlot *slot = &units[i].abilities[slotIdx];
-                    if (slot->abilityId < 0 || slot->cooldownRemaining > 0) continue;
-                    const AbilityDef *def = &ABILITY_DEFS[slot->abilityId];
-                    if (def->isPassive) continue; // skip passives (Dig, Sunder)
-
-                    // Range gate: if ability has a cast range, check closest enemy is within it
-                    float castRange = def->range[slot->level];
-                    if (castRange > 0 && target >= 0) {
-                        float d = DistXZ(units[i].position, units[target].position);
-                        if (d > castRange) continue;
-                    } else if (castRange > 0 && target < 0) {
-                        continue; // need a target but none exists
-                    }
-
-                    switch (slot->abilityId) {
-                    case ABILITY_MAGIC_MISSILE: castThisFrame = CastMagicMissile(&combatState, i, slot, target); break;
-                    case ABILITY_VACUUM:        castThisFrame = CastVacuum(&combatState, i, slot); break;
-                    case ABILITY_CHAIN_FROST:   castThisFrame = CastChainFrost(&combatState, i, slot, target); break;
-                    case ABILITY_BLOOD_RAGE:    castThisFrame = CastBloodRage(&combatState, i, slot); break;
-                    case ABILITY_EARTHQUAKE:
-                        castThisFrame = CastEarthquake(&combatState, i, slot);
-                        if (castThisFrame) {
-                            // Aggressive tile ripple from earthquake epicenter
-                            float eqX = units[i].position.x;
-                            float eqZ = units[i].position.z;
-                            float eqRadius = ABILITY_DEFS[ABILITY_EARTHQUAKE].values[slot->level][AV_EQ_RADIUS];
-                            float gridOriginEq = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
-                            for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
-                                for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
-                                    float cx = gridOriginEq + (tc + 0.5f) * TILE_WORLD_SIZE;
-                                    float cz = gridOriginEq + (tr + 0.5f) * TILE_WORLD_SIZE;
-                                    float dxw = cx - eqX, dzw = cz - eqZ;
-                                    float dist = sqrtf(dxw*dxw + dzw*dzw);
-                                    float wobbleR = eqRadius * 3.0f;
-                                    if (dist < wobbleR) {
-                                        float strength = expf(-1.5f * dist / wobbleR);
-                                        tileWobble[tr][tc] = TILE_WOBBLE_MAX * 1.5f * strength;
-                                        tileWobbleTime[tr][tc] = -(dist * 0.012f);
-                                        float len = dist > 0.1f ? dist : 1.0f;
-                                        tileWobbleDirX[tr][tc] = dzw / len;
-                                        tileWobbleDirZ[tr][tc] = -dxw / len;
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    case ABILITY_SPELL_PROTECT: castThisFrame = CastSpellProtect(&combatState, i, slot); break;
-                    case ABILITY_CRAGGY_ARMOR:  castThisFrame = CastCraggyArmor(&combatState, i, slot); break;
-                    case ABILITY_STONE_GAZE:    castThisFrame = CastStoneGaze(&combatState, i, slot); break;
-                    case ABILITY_FISSURE:       castThisFrame = CastFissure(&combatState, i, slot, target); break;
-                    case ABILITY_VLAD_AURA:     castThisFrame = CastVladAura(&combatState, i, slot); break;
-                    case ABILITY_MAELSTROM:     castThisFrame = CastMaelstrom(&combatState, i, slot); break;
-                    case ABILITY_SWAP:          castThisFrame = CastSwap(&combatState, i, slot); break;
-                    case ABILITY_APHOTIC_SHIELD:castThisFrame = CastAphoticShield(&combatState, i, slot); break;
-                    case ABILITY_HOOK:          castThisFrame = CastHook(&combatState, i, slot); break;
-                    case ABILITY_PRIMAL_CHARGE: castThisFrame = CastPrimalCharge(&combatState, i, slot); break;
-                    default: break;
-                    }
-                    if (castThisFrame) {
-                        PlaySound(sfxMagicHit);
-                        PlaySound(units[i].typeIndex == 0 ? sfxToadShout : sfxGoblinShout);
-                        SpawnFloatingText(floatingTexts, units[i].position,
-                            def->name, def->color, 1.0f);
-                        BattleLogAddCast(&battleLog, combatElapsedTime, units[i].team, units[i].typeIndex, slot->abilityId);
-                        units[i].abilityCastDelay = 0.75f;
-                        // Pause caster briefly for projectile abilities
-                        if (slot->abilityId == ABILITY_MAGIC_MISSILE ||
-                            slot->abilityId == ABILITY_CHAIN_FROST ||
-                            slot->abilityId == ABILITY_HOOK)
-                            units[i].castPause = CAST_PAUSE_TIME;
-                    }
-                }
-
-                // Primal Charge movement — overrides normal movement
-                if (units[i].chargeTarget >= 0) {
-                    int ct = units[i].chargeTarget;
-                    if (ct >= unitCount || !units[ct].active) {
-                        units[i].chargeTarget = -1;
-                    } else {
-                        float chargeDist = DistXZ(units[i].position, units[ct].position);
-                        float chargeSpeed = GetModifierValue(modifiers, i, MOD_CHARGING);
-                        if (chargeSpeed <= 0) chargeSpeed = 80.0f;
-                        if (chargeDist <= ATTACK_RANGE) {
-                            // IMPACT — AoE damage + knockback
-                            int chargeLvl = 0;
-                            for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                                if (units[i].abilities[a].abilityId == ABILITY_PRIMAL_CHARGE) {
-                                    chargeLvl = units[i].abilities[a].level; break;
-                                }
-                            }
-                            const AbilityDef *pcDef = &ABILITY_DEFS[ABILITY_PRIMAL_CHARGE];
-                            float pcDmg = pcDef->values[chargeLvl][AV_PC_DAMAGE];
-                            float pcKnock = pcDef->values[chargeLvl][AV_PC_KNOCKBACK];
-                            float pcRadius = pcDef->values[chargeLvl][AV_PC_AOE_RADIUS];
-                            for (int j = 0; j < unitCount; j++) {
-                                if (!units[j].active || units[j].team == units[i].team) continue;
-                                if (UnitHasModifier(modifiers, j, MOD_INVULNERABLE)) continue;
-                                float dd = DistXZ(units[ct].position, units[j].position);
-                                if (dd <= pcRadius) {
-                                    float dmgHit = pcDmg;
-                                    if (units[j].shieldHP > 0) {
-                                        if (dmgHit <= units[j].shieldHP) { units[j].shieldHP -= dmgHit; dmgHit = 0; }
-                                        else { dmgHit -= units[j].shieldHP; units[j].shieldHP = 0; }
-                                    }
-                                    units[j].currentHealth -= dmgHit;
-                                    units[j].hitFlash = HIT_FLASH_DURATION;
-                                    SpawnDamageNumber(floatingTexts, units[j].position, dmgHit, true);
-        
-                                    if (units[j].currentHealth <= 0) {
-                                        PlaySound(units[j].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                                        SpawnDeathExplosion(particles, units[j].position, units[j].team);
-                                        TriggerShake(&shake, 6.0f, 0.3f);
-        
-                                        { Team killerTeam = (units[j].team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
-                                if (killerTeam != lastKillTeam) multiKillCount = 0;
-                                lastKillTeam = killerTeam; }
-                                killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                                        if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                        else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                        else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                        else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                                        int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                                        if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                                        BattleLogAddKill(&battleLog, combatElapsedTime, units[i].team, units[i].typeIndex, units[j].team, units[j].typeIndex, ABILITY_PRIMAL_CHARGE);
-                                        units[j].active = false;
-                                    }
-                                    // Knockback
-                                    float kx = units[j].position.x - units[ct].position.x;
-                                    float kz = units[j].position.z - units[ct].position.z;
-                                    float klen = sqrtf(kx*kx + kz*kz);
-                                    if (klen > 0.001f) {
-                                        units[j].position.x += (kx/klen) * pcKnock;
-                                        units[j].position.z += (kz/klen) * pcKnock;
-                                    }
-                                }
-                            }
-                            TriggerShake(&shake, 8.0f, 0.4f);
-                            units[i].chargeTarget = -1;
-                            // Remove charging modifier
-                            for (int m = 0; m < MAX_MODIFIERS; m++) {
-                                if (modifiers[m].active && modifiers[m].unitIndex == i && modifiers[m].type == MOD_CHARGING)
-                                    modifiers[m].active = false;
-                            }
-                        } else {
-                            float cdx = units[ct].position.x - units[i].position.x;
-                            float cdz = units[ct].position.z - units[i].position.z;
-                            float clen = sqrtf(cdx*cdx + cdz*cdz);
-                            units[i].position.x += (cdx/clen) * chargeSpeed * dt;
-                            units[i].position.z += (cdz/clen) * chargeSpeed * dt;
-                        }
-                        continue; // skip normal movement while charging
-                    }
-                }
-
-                // Cast pause — brief freeze after projectile cast
-                if (units[i].castPause > 0) {
-                    units[i].castPause -= dt;
-                    continue;
-                }
-
-                // Movement + basic attack
-                if (target < 0) continue;
-                float moveSpeed = stats->movementSpeed * units[i].speedMultiplier;
-                float speedMult = GetModifierValue(modifiers, i, MOD_SPEED_MULT);
-                if (speedMult > 0) moveSpeed *= speedMult;
-
-                bool isDevil = (units[i].typeIndex == DEVIL_TYPE_INDEX);
-                float unitAttackRange = isDevil ? DEVIL_RANGED_RANGE : ATTACK_RANGE;
-
-                float dist = DistXZ(units[i].position, units[target].position);
-                if (dist > unitAttackRange)
-                {
-                    Vector3 oldPos = units[i].position;
-                    float dx = units[target].position.x - units[i].position.x;
-                    float dz = units[target].position.z - units[i].position.z;
-                    float len = sqrtf(dx*dx + dz*dz);
-                    if (len > 0.001f) {
-                        units[i].position.x += (dx/len) * moveSpeed * dt;
-                        units[i].position.z += (dz/len) * moveSpeed * dt;
-                    }
-                    // Fissure collision — slide along impassable terrain
-                    float unitRadius = 2.0f;
-                    units[i].position = ResolveFissureCollision(fissures, units[i].position, oldPos, unitRadius);
-
-                    // Unit-unit collision — push overlapping units apart on XZ plane
-                    for (int j = 0; j < unitCount; j++) {
-                        if (j == i || !units[j].active) continue;
-                        float cdist = DistXZ(units[i].position, units[j].position);
-                        float minDist = UNIT_COLLISION_RADIUS * 2.0f;
-                        if (cdist < minDist && cdist > 0.001f) {
-                            float overlap = minDist - cdist;
-                            float pushX = (units[i].position.x - units[j].position.x) / cdist;
-                            float pushZ = (units[i].position.z - units[j].position.z) / cdist;
-                            units[i].position.x += pushX * overlap * 0.5f;
-                            units[i].position.z += pushZ * overlap * 0.5f;
-                            units[j].position.x -= pushX * overlap * 0.5f;
-                            units[j].position.z -= pushZ * overlap * 0.5f;
-                        }
-                    }
-                }
-                else
-                {
-                    units[i].attackCooldown -= dt;
-                    if (units[i].attackCooldown <= 0.0f)
-                    {
-                        if (isDevil) {
-                            // Devil ranged attack — spawn a bolt projectile
-                            float dmg = stats->attackDamage * units[i].dmgMultiplier;
-                            SpawnProjectile(projectiles, PROJ_DEVIL_BOLT,
-                                units[i].position, target, i, units[i].team, 0,
-                                50.0f, dmg, 0,
-                                (Color){200, 50, 50, 255});
-                            PlaySound(sfxProjectileWhoosh);
-                            units[i].attackCooldown = stats->attackSpeed;
-                            units[i].castPause = CAST_PAUSE_TIME;
-                        } else {
-                        if (!UnitHasModifier(modifiers, target, MOD_INVULNERABLE)) {
-                            float dmg = stats->attackDamage * units[i].dmgMultiplier;
-                            float armor = GetModifierValue(modifiers, target, MOD_ARMOR);
-                            dmg -= armor;
-                            if (dmg < 0) dmg = 0;
-                            // Shield absorption
-                            if (units[target].shieldHP > 0) {
-                                if (dmg <= units[target].shieldHP) { units[target].shieldHP -= dmg; dmg = 0; }
-                                else { dmg -= units[target].shieldHP; units[target].shieldHP = 0; }
-                            }
-                            units[target].currentHealth -= dmg;
-                            PlaySound(sfxMeleeHit);
-                            units[target].hitFlash = HIT_FLASH_DURATION;
-                            SpawnDamageNumber(floatingTexts, units[target].position, dmg, false);
-                            SpawnMeleeImpact(particles, units[target].position);
-                            // Minor tile wobble on melee hit
-                            {
-                                float gridOriginMH = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
-                                for (int tr = 0; tr < TILE_GRID_SIZE; tr++) {
-                                    for (int tc = 0; tc < TILE_GRID_SIZE; tc++) {
-                                        float cx = gridOriginMH + (tc + 0.5f) * TILE_WORLD_SIZE;
-                                        float cz = gridOriginMH + (tr + 0.5f) * TILE_WORLD_SIZE;
-                                        float dxw = cx - units[target].position.x, dzw = cz - units[target].position.z;
-                                        float dist = sqrtf(dxw*dxw + dzw*dzw);
-                                        float wobbleR = 25.0f;
-                                        if (dist < wobbleR) {
-                                            float strength = expf(-2.0f * dist / wobbleR) * 0.2f;
-                                            if (tileWobble[tr][tc] < TILE_WOBBLE_MAX * strength) {
-                                                tileWobble[tr][tc] = TILE_WOBBLE_MAX * strength;
-                                                tileWobbleTime[tr][tc] = -(dist * 0.008f);
-                                                float len = dist > 0.1f ? dist : 1.0f;
-                                                tileWobbleDirX[tr][tc] = dzw / len;
-                                                tileWobbleDirZ[tr][tc] = -dxw / len;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            // Lifesteal
-                            float ls = GetModifierValue(modifiers, i, MOD_LIFESTEAL);
-                            if (ls > 0) {
-                                float maxHP = stats->health * units[i].hpMultiplier;
-                                units[i].currentHealth += dmg * ls;
-                                if (units[i].currentHealth > maxHP)
-                                    units[i].currentHealth = maxHP;
-                            }
-                            // Craggy Armor retaliation — chance to stun attacker
-                            CheckCraggyArmorRetaliation(&combatState, i, target);
-                            // Maelstrom on-hit proc
-                            if (UnitHasModifier(modifiers, i, MOD_MAELSTROM)) {
-                                float procChance = GetModifierValue(modifiers, i, MOD_MAELSTROM);
-                                float roll = (float)GetRandomValue(0, 100) / 100.0f;
-                                if (roll < procChance) {
-                                    // Find maelstrom ability level
-                                    int mlLvl = 0;
-                                    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                                        if (units[i].abilities[a].abilityId == ABILITY_MAELSTROM) {
-                                            mlLvl = units[i].abilities[a].level; break;
-                                        }
-                                    }
-                                    const AbilityDef *mlDef = &ABILITY_DEFS[ABILITY_MAELSTROM];
-                                    SpawnMaelstromProjectile(projectiles,
-                                        units[target].position, target, i, units[i].team, mlLvl,
-                                        mlDef->values[mlLvl][AV_ML_SPEED],
-                                        mlDef->values[mlLvl][AV_ML_DAMAGE],
-                                        (int)mlDef->values[mlLvl][AV_ML_BOUNCES],
-                                        mlDef->values[mlLvl][AV_ML_BOUNCE_RANGE]);
-                                }
-                            }
-                            if (units[target].currentHealth <= 0) {
-                                PlaySound(units[target].typeIndex == 0 ? sfxToadDie : sfxGoblinDie);
-                                SpawnDeathExplosion(particles, units[target].position, units[target].team);
-                                TriggerShake(&shake, 6.0f, 0.3f);
-
-                                { Team killerTeam = (units[target].team == TEAM_BLUE) ? TEAM_RED : TEAM_BLUE;
-                                if (killerTeam != lastKillTeam) multiKillCount = 0;
-                                lastKillTeam = killerTeam; }
-                                killCount++; multiKillCount++; multiKillTimer = 2.0f;
-                                if (killCount == 1) { snprintf(killFeedText, sizeof(killFeedText), "FIRST BLOOD!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 2) { snprintf(killFeedText, sizeof(killFeedText), "DOUBLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount == 3) { snprintf(killFeedText, sizeof(killFeedText), "TRIPLE KILL!"); killFeedTimer = 0.0f; killFeedScale = 2.0f; }
-                                else if (multiKillCount >= 4) { snprintf(killFeedText, sizeof(killFeedText), "RAMPAGE!"); killFeedTimer = 0.0f; killFeedScale = 2.5f; }
-                                int ba2, ra2; CountTeams(units, unitCount, &ba2, &ra2);
-                                if (ba2 == 0 || ra2 == 0) { slowmoTimer = 0.5f; slowmoScale = 0.3f; }
-                                BattleLogAddKill(&battleLog, combatElapsedTime, units[i].team, units[i].typeIndex, units[target].team, units[target].typeIndex, -1);
-                                units[target].active = false;
-                            }
-                        }
-                        units[i].attackCooldown = stats->attackSpeed;
-                        units[i].attackAnimTimer = 0.4f;
-                        } // end else (non-devil melee)
+                        SpawnParticle(&particles, pos, vel, 0.5f + (float)GetRandomValue(0, 3) / 10.0f, sz, brown);
                     }
                 }
             }
-
-            // Stone Gaze update — enemies facing a stone-gazer accumulate gaze
-            for (int i = 0; i < unitCount; i++) {
-                if (!units[i].active) continue;
-                // Check if any enemy has Stone Gaze active
-                bool beingGazed = false;
-                for (int g = 0; g < unitCount; g++) {
-                    if (!units[g].active || units[g].team == units[i].team) continue;
-                    if (!UnitHasModifier(modifiers, g, MOD_STONE_GAZE)) continue;
-                    // Check if unit i is facing toward gazer g (within cone)
-                    float dx = units[g].position.x - units[i].position.x;
-                    float dz = units[g].position.z - units[i].position.z;
-                    float distToGazer = sqrtf(dx*dx + dz*dz);
-                    if (distToGazer < 0.1f) continue;
-                    // Unit i's facing direction
-                    float facingRad = units[i].facingAngle * (PI / 180.0f);
-                    float faceDirX = sinf(facingRad);
-                    float faceDirZ = cosf(facingRad);
-                    // Dot product to check if facing toward gazer
-                    float dot = (dx/distToGazer) * faceDirX + (dz/distToGazer) * faceDirZ;
-                    float coneAngle = 45.0f; // default cone half-angle
-                    // Get cone angle from the gazer's Stone Gaze ability
-                    for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                        if (units[g].abilities[a].abilityId == ABILITY_STONE_GAZE) {
-                            int lvl = units[g].abilities[a].level;
-                            coneAngle = ABILITY_DEFS[ABILITY_STONE_GAZE].values[lvl][AV_SG_CONE_ANGLE];
-                            break;
-                        }
-                    }
-                    float coneThresh = cosf(coneAngle * (PI / 180.0f));
-                    if (dot >= coneThresh) {
-                        units[i].gazeAccum += dt;
-                        beingGazed = true;
-                        // Check if threshold reached — find gazer's ability level
-                        for (int a = 0; a < MAX_ABILITIES_PER_UNIT; a++) {
-                            if (units[g].abilities[a].abilityId == ABILITY_STONE_GAZE) {
-                                int lvl = units[g].abilities[a].level;
-                                float thresh = ABILITY_DEFS[ABILITY_STONE_GAZE].values[lvl][AV_SG_GAZE_THRESH];
-                                float stunDur = ABILITY_DEFS[ABILITY_STONE_GAZE].values[lvl][AV_SG_STUN_DUR];
-                                if (units[i].gazeAccum >= thresh) {
-                                    AddModifier(modifiers, i, MOD_STUN, stunDur, 0);
-                                    units[i].gazeAccum = 0;
-                                    TriggerShake(&shake, 3.0f, 0.2f);
-                                    SpawnFloatingText(floatingTexts, units[i].position,
-                                        "PETRIFIED!", (Color){160, 80, 200, 255}, 1.0f);
-                                }
-                                break;
-                            }
-                        }
-                        break; // only accumulate from one gazer at a time
-                    }
-                }
-                if (!beingGazed && units[i].gazeAccum > 0) {
-                    units[i].gazeAccum -= dt * 2.0f; // decay twice as fast
-                    if (units[i].gazeAccum < 0) units[i].gazeAccum = 0;
-                }
+            for (int k = 0; k < projectilePool.liveCount; k++) {
+                int p = projectilePool.live[k];
+                if (projectiles[p].chargeTimer > 0) continue;
+                Vector3 tv = {
+                    ((GetRandomValue(0, 200) - 100) / 100.0f) * 3.0f,
+                    ((GetRandomValue(0, 100)) / 100.0f) * 4.0f + 3.0f,  // upward bias to fight gravity
+                    ((GetRandomValue(0, 200) - 100) / 100.0f) * 3.0f,
+                };
+                SpawnParticle(&particles, projectiles[p].position, tv,
+                    PROJ_TRAIL_LIFE, PROJ_TRAIL_SIZE, projectiles[p].color);
             }
+            UpdateParticles(&particles, dt);
+            UpdateFloatingTexts(floatingTexts, dt);
 
             // Smooth Y toward ground during combat
             for (int i = 0; i < unitCount; i++) {
                 if (!units[i].active) continue;
-                units[i].position.y += (0.0f - units[i].position.y) * 0.1f;
+                units[i].position.y += (0.0f - units[i].position.y) * FrameLerp(0.1f, dt);
             }
 
             // Check round end
             if (isMultiplayer) {
                 // In multiplayer, poll for server result
                 net_client_poll(&netClient);
-                if (netClient.roundResultReady) {
+                // A streamed battle ends once its final snapshot has played out
+                bool streamDone = !combatStream.active || combatStream.latestSeq < 0 ||
+                                  StreamClientFinished(&combatStream);
+                if (netClient.roundResultReady && streamDone) {
                     netClient.roundResultReady = false;
+                    combatStream.active = false;
                     if (netClient.roundWinner == 0) { blueWins++; roundResultText = "YOU WIN THE ROUND!"; }
                     else if (netClient.roundWinner == 1) { redWins++; roundResultText = "OPPONENT WINS!"; }
                     else roundResultText = "DRAW — NO SURVIVORS!";
@@ -3483,7 +3118,7 @@ int main(void)
                     phase = PHASE_ROUND_OVER;
                     roundOverTimer = 2.5f;
                     fightBannerTimer = -1.0f;
-                    ClearAllParticles(particles);
+                    ClearAllParticles(&particles);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     // Victory celebration confetti
@@ -3493,17 +3128,18 @@ int main(void)
                             Vector3 cpos = { (float)GetRandomValue(-80, 80), (float)GetRandomValue(30, 60), (float)GetRandomValue(-80, 80) };
                             Vector3 cvel = { (float)GetRandomValue(-20, 20)/10.0f, (float)GetRandomValue(-10, -2)/10.0f, (float)GetRandomValue(-20, 20)/10.0f };
                             Color cc = (Color){ (unsigned char)GetRandomValue(100, 255), (unsigned char)GetRandomValue(100, 255), (unsigned char)GetRandomValue(100, 255), 255 };
-                            SpawnParticle(particles, cpos, cvel, 2.0f + (float)GetRandomValue(0, 10)/10.0f, (float)GetRandomValue(3, 8)/10.0f, cc);
+                            SpawnParticle(&particles, cpos, cvel, 2.0f + (float)GetRandomValue(0, 10)/10.0f, (float)GetRandomValue(3, 8)/10.0f, cc);
                         }
                     }
                 }
-                if (netClient.gameOver) {
+                if (netClient.gameOver && streamDone) {
                     netClient.gameOver = false;
+                    combatStream.active = false;
                     if (netClient.gameWinner == 0) roundResultText = "YOU WIN THE MATCH!";
                     else roundResultText = "OPPONENT WINS THE MATCH!";
                     lastOutcomeWin = (netClient.gameWinner == 0);
                     phase = PHASE_GAME_OVER;
-                    ClearAllParticles(particles);
+                    ClearAllParticles(&particles);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                 }
@@ -3519,7 +3155,7 @@ int main(void)
                     phase = PHASE_ROUND_OVER;
                     roundOverTimer = 2.5f;
                     fightBannerTimer = -1.0f;
-                    ClearAllParticles(particles);
+                    ClearAllParticles(&particles);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     statueSpawn.phase = SSPAWN_INACTIVE;
@@ -3530,11 +3166,24 @@ int main(void)
                             Vector3 cpos = { (float)GetRandomValue(-80, 80), (float)GetRandomValue(30, 60), (float)GetRandomValue(-80, 80) };
                             Vector3 cvel = { (float)GetRandomValue(-20, 20)/10.0f, (float)GetRandomValue(-10, -2)/10.0f, (float)GetRandomValue(-20, 20)/10.0f };
                             Color cc = (Color){ (unsigned char)GetRandomValue(100, 255), (unsigned char)GetRandomValue(100, 255), (unsigned char)GetRandomValue(100, 255), 255 };
-                            SpawnParticle(particles, cpos, cvel, 2.0f + (float)GetRandomValue(0, 10)/10.0f, (float)GetRandomValue(3, 8)/10.0f, cc);
+                            SpawnParticle(&particles, cpos, cvel, 2.0f + (float)GetRandomValue(0, 10)/10.0f, (float)GetRandomValue(3, 8)/10.0f, cc);
                         }
                     }
                 }
             }
+            if (phase != PHASE_COMBAT) {
+#ifdef COMBAT_PROFILE
+                // Once joined the sim's own totals are safe to read, including ticks
+                // that were never published to a frame
+                if (clientSim.running) {
+                    ClientSimStop(&clientSim);
+                    combatProf = clientSim.prof;
+                }
+                CombatProfileAdd(&sessionProf, &combatProf);
+#else
+                ClientSimStop(&clientSim);
+#endif
+            }
         }
         //------------------------------------------------------------------------------
         // PHASE: ROUND_OVER — brief pause, then milestone/death/prep
@@ -3556,7 +3205,7 @@ int main(void)
                     for (int i = 0; i < unitCount; i++)
                         if (units[i].team == TEAM_RED) units[i].active = false;
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
+                    ClearAllProjectiles(&projectilePool);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     playerReady = false;
@@ -3593,7 +3242,7 @@ int main(void)
                         }
                     }
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
+                    ClearAllProjectiles(&projectilePool);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     ClearRedUnits(units, &unitCount);
@@ -3609,11 +3258,11 @@ int main(void)
                         }
                     }
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
+                    ClearAllProjectiles(&projectilePool);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     ClearRedUnits(units, &unitCount);
-                    SpawnWave(units, &unitCount, currentRound, unitTypeCount);
+                    SpawnWave(&gameRng, units, &unitCount, currentRound, unitTypeCount);
                     // Generate wave upgrade description
                     if (currentRound < TOTAL_ROUNDS) {
                         switch (currentRound) {
@@ -3630,7 +3279,7 @@ int main(void)
                         else snprintf(waveUpgradeText, sizeof(waveUpgradeText), "Enemy abilities upgraded");
                     }
                     playerGold += goldPerRound;
-                    RollShop(shopSlots, &playerGold, 0);
+                    RollShop(&gameRng, shopSlots, &playerGold, 0);
                     rollCost = rollCostBase;
                     phase = PHASE_PREP;
                 }
@@ -3699,7 +3348,7 @@ int main(void)
                 Rectangle contBtn = { (float)(btnStartX + btnW + btnGap), (float)btnY, (float)btnW, (float)btnH };
                 if (CheckCollisionPointRec(mouse, contBtn)) {
                     lastMilestoneRound = currentRound;
-                    SpawnWave(units, &unitCount, currentRound, unitTypeCount);
+                    SpawnWave(&gameRng, units, &unitCount, currentRound, unitTypeCount);
                     // Generate wave upgrade description
                     if (currentRound < TOTAL_ROUNDS) {
                         switch (currentRound) {
@@ -3716,7 +3365,7 @@ int main(void)
                         else snprintf(waveUpgradeText, sizeof(waveUpgradeText), "Enemy abilities upgraded");
                     }
                     playerGold += goldPerRound;
-                    RollShop(shopSlots, &playerGold, 0);
+                    RollShop(&gameRng, shopSlots, &playerGold, 0);
                     rollCost = rollCostBase;
                     phase = PHASE_PREP;
                 }
@@ -3739,8 +3388,8 @@ int main(void)
                 redWins = 0;
                 roundResultText = "";
                 ClearAllModifiers(modifiers);
-                ClearAllProjectiles(projectiles);
-                ClearAllParticles(particles);
+                ClearAllProjectiles(&projectilePool);
+                ClearAllParticles(&particles);
                 ClearAllFloatingTexts(floatingTexts);
                 ClearAllFissures(fissures);
                 playerGold = 25;
@@ -3750,7 +3399,7 @@ int main(void)
                 joinCodeInput[0] = '\0';
                 unitCount = 0;
                 memset(plazaData, 0, sizeof(plazaData));
-                PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                 plazaState = PLAZA_ROAMING;
                 phase = PHASE_PLAZA;
                 PlayMusicStream(bgm);
@@ -3813,8 +3462,8 @@ int main(void)
                     blueLostLastRound = false;
                     deathPenalty = false;
                     ClearAllModifiers(modifiers);
-                    ClearAllProjectiles(projectiles);
-                    ClearAllParticles(particles);
+                    ClearAllProjectiles(&projectilePool);
+                    ClearAllParticles(&particles);
                     ClearAllFloatingTexts(floatingTexts);
                     ClearAllFissures(fissures);
                     statueSpawn.phase = SSPAWN_INACTIVE;
@@ -3823,7 +3472,7 @@ int main(void)
                     dragState.dragging = false;
                     unitCount = 0;
                     memset(plazaData, 0, sizeof(plazaData));
-                    PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                    PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                     plazaState = PLAZA_ROAMING;
                     phase = PHASE_PLAZA;
                     PlayMusicStream(bgm);
@@ -3850,8 +3499,8 @@ int main(void)
                 blueLostLastRound = false;
                 deathPenalty = false;
                 ClearAllModifiers(modifiers);
-                ClearAllProjectiles(projectiles);
-                ClearAllParticles(particles);
+                ClearAllProjectiles(&projectilePool);
+                ClearAllParticles(&particles);
                 ClearAllFloatingTexts(floatingTexts);
                 ClearAllFissures(fissures);
                 intro.active = false;
@@ -3860,7 +3509,7 @@ int main(void)
                 for (int i = 0; i < MAX_INVENTORY_SLOTS; i++) inventory[i].abilityId = -1;
                 dragState.dragging = false;
                 memset(plazaData, 0, sizeof(plazaData));
-                PlazaSpawnEnemies(units, &unitCount, unitTypeCount, plazaData);
+                PlazaSpawnEnemies(&gameRng, units, &unitCount, unitTypeCount, plazaData);
                 plazaState = PLAZA_ROAMING;
                 phase = PHASE_PLAZA;
                 PlayMusicStream(bgm);
@@ -3906,11 +3555,14 @@ int main(void)
                 if (arr) {
                     int frameCount = arr[idx].frameCount;
                     if (frameCount > 0)
-                        units[i].animFrame = (units[i].animFrame + 1) % frameCount;
+                        units[i].animFrame = (units[i].animFrame + animSteps) % frameCount;
                 }
             }
         }
 
+        // Any other way out of combat (menu, disconnect) also stops the sim thread
+        if (phase != PHASE_COMBAT) ClientSimStop(&clientSim);
+
         //==============================================================================
         // WIN/LOSS SFX
         //==============================================================================
@@ -3925,6 +3577,7 @@ int main(void)
         // DRAW
         //==============================================================================
         BeginDrawing();
+        PoseCacheNewFrame(&poseCache);
         ClearBackground((Color){ 45, 40, 35, 255 });
 
         // Collect active blue units for HUD
@@ -3935,11 +3588,13 @@ int main(void)
                 blueHudUnits[blueHudCount++] = i;
         }
 
-        // Render unit portraits into offscreen textures
+        // Render portraits not in the atlas yet. They don't sample this frame's shadow
+        // map, so once rendered a cell stays valid for the rest of the session.
         for (int h = 0; h < blueHudCount; h++) {
             int ui = blueHudUnits[h];
             UnitType *type = &unitTypes[units[ui].typeIndex];
             if (!type->loaded) continue;
+            if (PortraitCacheFind(&portraitCache, units[ui].typeIndex, GetTeamTint(TEAM_BLUE)) >= 0) continue;
 
             // Auto-center camera on model
             BoundingBox bb = type->baseBounds;
@@ -3948,13 +3603,16 @@ int main(void)
             portraitCam.target = (Vector3){ 0.0f, centerY, 0.0f };
             portraitCam.position = (Vector3){ 0.0f, centerY, extent * 2.5f };
 
-            BeginTextureMode(portraits[h]);
-                ClearBackground((Color){ 30, 30, 40, 255 });
+            if (PortraitCacheBegin(&portraitCache, units[ui].typeIndex, GetTeamTint(TEAM_BLUE),
+                                   (Color){ 30, 30, 40, 255 }) < 0) continue;
+                SetShaderValue(lightShader, noShadowLoc, (int[]){1}, SHADER_UNIFORM_INT);
                 BeginMode3D(portraitCam);
-                    if (type->hasAnimations && type->animIndex[ANIM_IDLE] >= 0)
-                        UpdateModelAnimation(type->model, type->idleAnims[type->animIndex[ANIM_IDLE]], 0);
+                    PoseUnitModel(&poseCache, type, ANIM_IDLE, 0);
+                    SetShaderValue(lightShader, lightSkinnedLoc, (int[]){ type->hasAnimations }, SHADER_UNIFORM_INT);
                     DrawModel(type->model, (Vector3){ 0, 0, 0 }, type->scale, GetTeamTint(TEAM_BLUE));
+                    SetShaderValue(lightShader, lightSkinnedLoc, (int[]){0}, SHADER_UNIFORM_INT);
                 EndMode3D();
+                SetShaderValue(lightShader, noShadowLoc, (int[]){0}, SHADER_UNIFORM_INT);
             EndTextureMode();
         }
 
@@ -3992,12 +3650,102 @@ int main(void)
             }
         }
 
+        // Pick up whatever the layout editor changed since the batch was built
+        if (!debugMode && EnvBatchStale(&envBatch, envPieces, envPieceCount)) {
+            EnvBatchBuild(&envBatch, envModels, envPieces, envPieceCount);
+            shadowStaticDirty = true;
+        }
+
+        // --- Tile floor instances (shared by the shadow and main passes) ---
+        {
+            for (int vi = 0; vi < TILE_VARIANTS; vi++) tileInstanceCount[vi] = 0;
+            float gridOrigin = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
+            for (int r = 0; r < TILE_GRID_SIZE; r++) {
+                for (int c = 0; c < TILE_GRID_SIZE; c++) {
+                    int vi = tileVariantGrid[r][c];
+                    float cellX = gridOrigin + (c + 0.5f) * TILE_WORLD_SIZE + tileJitterX[r][c];
+                    float cellZ = gridOrigin + (r + 0.5f) * TILE_WORLD_SIZE + tileJitterZ[r][c];
+                    float totalRot = tileRotationGrid[r][c] + tileJitterAngle[r][c];
+                    // Scale→rotate→translate rotates the OBJ-space center offset too;
+                    // rotate it by the same angle to compensate
+                    float angle = totalRot * DEG2RAD;
+                    float cosA = cosf(angle);
+                    float sinA = sinf(angle);
+                    float sxo = tileCenters[vi].x * tileScale;
+                    float szo = tileCenters[vi].z * tileScale;
+                    float rxo = sxo * cosA + szo * sinA;
+                    float rzo = -sxo * sinA + szo * cosA;
+
+                    // Wobble: tilt tile around its cell center (propagating wave)
+                    float wobbleY = 0.0f;
+                    float wobbleTiltX = 0.0f, wobbleTiltZ = 0.0f;
+                    float wt = tileWobbleTime[r][c];
+                    if (tileWobble[r][c] > 0.01f && wt > 0.0f) {
+                        float envelope = tileWobble[r][c] * expf(-TILE_WOBBLE_DECAY * wt);
+                        float osc = sinf(wt * TILE_WOBBLE_FREQ * 2.0f * PI);
+                        wobbleTiltX = envelope * osc * tileWobbleDirX[r][c];
+                        wobbleTiltZ = envelope * osc * tileWobbleDirZ[r][c];
+                        wobbleY = envelope * fabsf(osc) * (TILE_WOBBLE_BOUNCE / TILE_WOBBLE_MAX);
+                        // Kill wobble when envelope is negligible
+                        if (envelope < 0.05f) tileWobble[r][c] = 0.0f;
+                    }
+
+                    Matrix m = MatrixMultiply(MatrixMultiply(MatrixScale(tileScale, tileScale, tileScale),
+                                                             MatrixRotateY(angle)),
+                                              MatrixTranslate(cellX - rxo,
+                                                              wobbleY - tileCenters[vi].y * tileScale - 0.5f,
+                                                              cellZ - rzo));
+                    if (wobbleTiltX != 0.0f || wobbleTiltZ != 0.0f) {
+                        // Tilt about the cell center, composed in the order rlRotatef stacked it
+                        Matrix tilt = MatrixMultiply(MatrixTranslate(-cellX, 0.0f, -cellZ),
+                                      MatrixMultiply(MatrixRotateZ(wobbleTiltZ * DEG2RAD),
+                                      MatrixMultiply(MatrixRotateX(wobbleTiltX * DEG2RAD),
+                                                     MatrixTranslate(cellX, 0.0f, cellZ))));
+                        m = MatrixMultiply(m, tilt);
+                    }
+                    tileInstances[vi][tileInstanceCount[vi]++] = MatrixMultiply(tileModels[vi].transform, m);
+                }
+            }
+
+            // A cached tile that starts moving must come out of the cache. Tiles only go
+            // back in after resting SHADOW_TILE_SETTLE seconds, so the ones combat keeps
+            // hitting stay dynamic instead of forcing a rebuild per impact, and folding
+            // settled tiles back in happens at most once per settle period. Layout edits
+            // only happen in debug mode, which rebuilds the cache every frame.
+            bool anySettled = false;
+            for (int r = 0; r < TILE_GRID_SIZE; r++) {
+                for (int c = 0; c < TILE_GRID_SIZE; c++) {
+                    bool moving = tileWobble[r][c] > 0.01f;
+                    tileStillTime[r][c] = moving ? 0.0f : tileStillTime[r][c] + rawDt;
+                    if (moving && tileInShadowCache[r][c]) shadowStaticDirty = true;
+                    if (!tileInShadowCache[r][c] && tileStillTime[r][c] >= SHADOW_TILE_SETTLE) anySettled = true;
+                }
+            }
+            shadowStaticAge += rawDt;
+            if (anySettled && shadowStaticAge >= SHADOW_TILE_SETTLE) shadowStaticDirty = true;
+            if (debugMode) shadowStaticDirty = true;
+            if (shadowStaticDirty) {
+                for (int r = 0; r < TILE_GRID_SIZE; r++)
+                    for (int c = 0; c < TILE_GRID_SIZE; c++)
+                        tileInShadowCache[r][c] = tileStillTime[r][c] >= SHADOW_TILE_SETTLE;
+                shadowStaticAge = 0.0f;
+            }
+            // Instances were appended in row-major order per variant; walk them the same way
+            int next[TILE_VARIANTS] = { 0 };
+            for (int vi = 0; vi < TILE_VARIANTS; vi++) tileStaticCount[vi] = tileDynamicCount[vi] = 0;
+            for (int r = 0; r < TILE_GRID_SIZE; r++) {
+                for (int c = 0; c < TILE_GRID_SIZE; c++) {
+                    int vi = tileVariantGrid[r][c];
+                    Matrix m = tileInstances[vi][next[vi]++];
+                    if (tileInShadowCache[r][c]) tileStaticInstances[vi][tileStaticCount[vi]++] = m;
+                    else tileDynamicInstances[vi][tileDynamicCount[vi]++] = m;
+                }
+            }
+        }
+
         // --- Shadow map pass ---
         {
             rlDrawRenderBatchActive();
-            rlEnableFramebuffer(shadowRT.id);
-            rlViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
-            rlClearScreenBuffers();
             rlEnableDepthTest();
             rlDisableColorBlend();
 
@@ -4005,92 +3753,61 @@ int main(void)
             rlSetMatrixProjection(lightProj);
             rlSetMatrixModelview(lightView);
 
-            // Swap all model materials to shadow depth shader
-            for (int i = 0; i < unitTypeCount; i++) {
-                if (!unitTypes[i].loaded) continue;
-                for (int m = 0; m < unitTypes[i].model.materialCount; m++)
-                    unitTypes[i].model.materials[m].shader = shadowDepthShader;
-            }
-            for (int i = 0; i < TILE_VARIANTS; i++)
-                for (int m = 0; m < tileModels[i].materialCount; m++)
-                    tileModels[i].materials[m].shader = shadowDepthShader;
-            // Swap env model materials to shadow depth shader (covers ground, stairs, circle, etc.)
-            for (int ei = 0; ei < envModelCount; ei++) {
-                if (!envModels[ei].loaded) continue;
-                for (int m = 0; m < envModels[ei].model.materialCount; m++)
-                    envModels[ei].model.materials[m].shader = shadowDepthShader;
-            }
-
-            // Draw shadow-casting geometry
-            {
-                float gridOrigin = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
-                for (int r = 0; r < TILE_GRID_SIZE; r++) {
-                    for (int c = 0; c < TILE_GRID_SIZE; c++) {
-                        int vi = tileVariantGrid[r][c];
-                        float cellX = gridOrigin + (c + 0.5f) * TILE_WORLD_SIZE + tileJitterX[r][c];
-                        float cellZ = gridOrigin + (r + 0.5f) * TILE_WORLD_SIZE + tileJitterZ[r][c];
-                        float totalRot = tileRotationGrid[r][c] + tileJitterAngle[r][c];
-                        float angle = totalRot * DEG2RAD;
-                        float cosA = cosf(angle);
-                        float sinA = sinf(angle);
-                        float sxo = tileCenters[vi].x * tileScale;
-                        float szo = tileCenters[vi].z * tileScale;
-                        float rxo = sxo * cosA + szo * sinA;
-                        float rzo = -sxo * sinA + szo * cosA;
-                        Vector3 pos = {
-                            cellX - rxo,
-                            -tileCenters[vi].y * tileScale - 0.5f,
-                            cellZ - rzo,
-                        };
-                        DrawModelEx(tileModels[vi], pos,
-                            (Vector3){ 0.0f, 1.0f, 0.0f }, totalRot,
-                            (Vector3){ tileScale, tileScale, tileScale }, WHITE);
+            // Static casters: resting tiles + env pieces, only when the cache is invalid
+            if (shadowStaticDirty) {
+                rlEnableFramebuffer(shadowStaticRT.id);
+                rlViewport(0, 0, shadowMapSize, shadowMapSize);
+                rlClearScreenBuffers();
+                SetShaderValue(shadowDepthShader, shadowInstancedLoc, (int[]){1}, SHADER_UNIFORM_INT);
+                for (int vi = 0; vi < TILE_VARIANTS; vi++)
+                    DrawModelInstanced(tileModels[vi], shadowDepthShaderInst, tileStaticInstances[vi], tileStaticCount[vi]);
+                SetShaderValue(shadowDepthShader, shadowInstancedLoc, (int[]){0}, SHADER_UNIFORM_INT);
+                // Draw env pieces (shadow pass — includes ground, stairs, circle)
+                if (debugMode) {
+                    for (int ep = 0; ep < envPieceCount; ep++) {
+                        if (!envPieces[ep].active) continue;
+                        EnvModelDef *emd = &envModels[envPieces[ep].modelIndex];
+                        if (!emd->loaded) continue;
+                        DrawModelPass(emd->model, emd->depthMaterials, envPieces[ep].position,
+                                      envPieces[ep].rotationY, envPieces[ep].scale);
+                    }
+                } else {
+                    for (int g = 0; g < envBatch.groupCount; g++) {
+                        Material mat = envBatch.groups[g].material;
+                        mat.shader = shadowDepthShader;
+                        DrawMesh(envBatch.groups[g].mesh, mat, MatrixIdentity());
                     }
                 }
+                rlDrawRenderBatchActive();
+                shadowStaticDirty = false;
             }
-            // Draw env pieces (shadow pass — includes ground, stairs, circle)
-            for (int ep = 0; ep < envPieceCount; ep++) {
-                if (!envPieces[ep].active) continue;
-                EnvModelDef *emd = &envModels[envPieces[ep].modelIndex];
-                if (!emd->loaded) continue;
-                float es = envPieces[ep].scale;
-                DrawModelEx(emd->model, envPieces[ep].position, (Vector3){0,1,0},
-                            envPieces[ep].rotationY, (Vector3){es,es,es}, WHITE);
-            }
-            for (int i = 0; i < unitCount; i++) {
-                if (!units[i].active) continue;
+
+            // Start this frame's map from the cache (color too, for the F10 preview)
+            rlBindFramebuffer(RL_READ_FRAMEBUFFER, shadowStaticRT.id);
+            rlBindFramebuffer(RL_DRAW_FRAMEBUFFER, shadowRT.id);
+            rlBlitFramebuffer(0, 0, shadowMapSize, shadowMapSize, 0, 0, shadowMapSize, shadowMapSize,
+                              0x00004100);  // GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT
+            rlEnableFramebuffer(shadowRT.id);
+            rlViewport(0, 0, shadowMapSize, shadowMapSize);
+
+            // Dynamic casters: wobbling tiles + units
+            SetShaderValue(shadowDepthShader, shadowInstancedLoc, (int[]){1}, SHADER_UNIFORM_INT);
+            for (int vi = 0; vi < TILE_VARIANTS; vi++)
+                DrawModelInstanced(tileModels[vi], shadowDepthShaderInst, tileDynamicInstances[vi], tileDynamicCount[vi]);
+            SetShaderValue(shadowDepthShader, shadowInstancedLoc, (int[]){0}, SHADER_UNIFORM_INT);
+            int drawCount = SortUnitDraws(units, unitCount, unitTypes, unitDrawOrder);
+            for (int d = 0; d < drawCount; d++) {
+                int i = unitDrawOrder[d];
                 UnitType *type = &unitTypes[units[i].typeIndex];
-                if (!type->loaded) continue;
-                // Update animation pose so shadow matches current frame
-                if (type->hasAnimations) {
-                    int idx = type->animIndex[units[i].currentAnim];
-                    if (idx >= 0) {
-                        ModelAnimation *arr = GetAnimArray(type, units[i].currentAnim);
-                        if (arr) UpdateModelAnimation(type->model, arr[idx], units[i].animFrame);
-                    }
-                }
-                float s = type->scale * units[i].scaleOverride;
+                // Pose so the shadow matches the current frame
+                PoseUnitModel(&poseCache, type, units[i].currentAnim, units[i].animFrame);
                 Vector3 drawPos = units[i].position;
                 drawPos.y += type->yOffset;
-                DrawModelEx(type->model, drawPos, (Vector3){0,1,0}, units[i].facingAngle,
-                    (Vector3){s, s, s}, WHITE);
-            }
-
-            // Restore lighting shader on all materials
-            for (int i = 0; i < unitTypeCount; i++) {
-                if (!unitTypes[i].loaded) continue;
-                for (int m = 0; m < unitTypes[i].model.materialCount; m++)
-                    unitTypes[i].model.materials[m].shader = lightShader;
-            }
-            for (int i = 0; i < TILE_VARIANTS; i++)
-                for (int m = 0; m < tileModels[i].materialCount; m++)
-                    tileModels[i].materials[m].shader = lightShader;
-            // Restore lighting shader on env model materials
-            for (int ei = 0; ei < envModelCount; ei++) {
-                if (!envModels[ei].loaded) continue;
-                for (int m = 0; m < envModels[ei].model.materialCount; m++)
-                    envModels[ei].model.materials[m].shader = lightShader;
+                SetShaderValue(shadowDepthShader, shadowSkinnedLoc, (int[]){ type->hasAnimations }, SHADER_UNIFORM_INT);
+                DrawModelPass(type->model, type->depthMaterials, drawPos, units[i].facingAngle,
+                              type->scale * units[i].scaleOverride);
             }
+            SetShaderValue(shadowDepthShader, shadowSkinnedLoc, (int[]){0}, SHADER_UNIFORM_INT);
 
             rlDrawRenderBatchActive();
             rlEnableColorBlend();
@@ -4108,75 +3825,26 @@ int main(void)
         BeginTextureMode(sceneRT);
         ClearBackground((Color){ 45, 40, 35, 255 });
         BeginMode3D(camera);
+            sceneViewProj = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
             // Draw tiled floor (bind normal map for tiles)
             rlActiveTextureSlot(3);
             rlEnableTexture(tileNormal.id);
             SetShaderValue(lightShader, normalMapLoc, (int[]){3}, SHADER_UNIFORM_INT);
             SetShaderValue(lightShader, useNormalMapLoc, (int[]){1}, SHADER_UNIFORM_INT);
-            {
-                float gridOrigin = -(TILE_GRID_SIZE * TILE_WORLD_SIZE) / 2.0f;
-                for (int r = 0; r < TILE_GRID_SIZE; r++) {
-                    for (int c = 0; c < TILE_GRID_SIZE; c++) {
-                        int vi = tileVariantGrid[r][c];
-                        float cellX = gridOrigin + (c + 0.5f) * TILE_WORLD_SIZE + tileJitterX[r][c];
-                        float cellZ = gridOrigin + (r + 0.5f) * TILE_WORLD_SIZE + tileJitterZ[r][c];
-                        float totalRot = tileRotationGrid[r][c] + tileJitterAngle[r][c];
-                        // DrawModelEx applies scale→rotate→translate, so the OBJ-space
-                        // center offset gets rotated. Rotate it by the same angle to compensate.
-                        float angle = totalRot * DEG2RAD;
-                        float cosA = cosf(angle);
-                        float sinA = sinf(angle);
-                        float sxo = tileCenters[vi].x * tileScale;
-                        float szo = tileCenters[vi].z * tileScale;
-                        float rxo = sxo * cosA + szo * sinA;
-                        float rzo = -sxo * sinA + szo * cosA;
-
-                        // Wobble: tilt tile around its cell center (propagating wave)
-                        float wobbleY = 0.0f;
-                        float wobbleTiltX = 0.0f, wobbleTiltZ = 0.0f;
-                        float wt = tileWobbleTime[r][c];
-                        if (tileWobble[r][c] > 0.01f && wt > 0.0f) {
-                            float envelope = tileWobble[r][c] * expf(-TILE_WOBBLE_DECAY * wt);
-                            float osc = sinf(wt * TILE_WOBBLE_FREQ * 2.0f * PI);
-                            wobbleTiltX = envelope * osc * tileWobbleDirX[r][c];
-                            wobbleTiltZ = envelope * osc * tileWobbleDirZ[r][c];
-                            wobbleY = envelope * fabsf(osc) * (TILE_WOBBLE_BOUNCE / TILE_WOBBLE_MAX);
-                            // Kill wobble when envelope is negligible
-                            if (envelope < 0.05f) tileWobble[r][c] = 0.0f;
-                        }
-
-                        Vector3 pos = {
-                            cellX - rxo,
-                            wobbleY - tileCenters[vi].y * tileScale - 0.5f,
-                            cellZ - rzo,
-                        };
-                        // Apply tilt via rlgl matrix if wobbling
-                        if (wobbleTiltX != 0.0f || wobbleTiltZ != 0.0f) {
-                            rlPushMatrix();
-                            rlTranslatef(cellX, 0.0f, cellZ);
-                            rlRotatef(wobbleTiltX, 1.0f, 0.0f, 0.0f);
-                            rlRotatef(wobbleTiltZ, 0.0f, 0.0f, 1.0f);
-                            rlTranslatef(-cellX, 0.0f, -cellZ);
-                        }
-                        DrawModelEx(tileModels[vi], pos,
-                            (Vector3){ 0.0f, 1.0f, 0.0f }, totalRot,
-                            (Vector3){ tileScale, tileScale, tileScale }, WHITE);
-                        if (wobbleTiltX != 0.0f || wobbleTiltZ != 0.0f) {
-                            rlPopMatrix();
-                        }
-                    }
-                }
-            }
+            SetShaderValue(lightShader, lightInstancedLoc, (int[]){1}, SHADER_UNIFORM_INT);
+            for (int vi = 0; vi < TILE_VARIANTS; vi++)
+                DrawModelInstanced(tileModels[vi], lightShaderInst, tileInstances[vi], tileInstanceCount[vi]);
+            SetShaderValue(lightShader, lightInstancedLoc, (int[]){0}, SHADER_UNIFORM_INT);
             SetShaderValue(lightShader, useNormalMapLoc, (int[]){0}, SHADER_UNIFORM_INT);
 
             // Draw env pieces (main render pass — includes ground, stairs, circle)
-            for (int ep = 0; ep < envPieceCount; ep++) {
+            for (int ep = 0; debugMode && ep < envPieceCount; ep++) {
                 if (!envPieces[ep].active) continue;
                 EnvModelDef *emd = &envModels[envPieces[ep].modelIndex];
                 if (!emd->loaded) continue;
                 float es = envPieces[ep].scale;
                 Color eTint = WHITE;
-                if (debugMode && ep == envSelectedPiece) eTint = (Color){150, 255, 150, 255};
+                if (ep == envSelectedPiece) eTint = (Color){150, 255, 150, 255};
                 if (emd->normalTexture.id > 0) {
                     rlActiveTextureSlot(3);
                     rlEnableTexture(emd->normalTexture.id);
@@ -4188,17 +3856,29 @@ int main(void)
                 DrawModelEx(emd->model, envPieces[ep].position, (Vector3){0,1,0},
                             envPieces[ep].rotationY, (Vector3){es,es,es}, eTint);
             }
+            for (int g = 0; !debugMode && g < envBatch.groupCount; g++) {
+                const EnvBatchGroup *group = &envBatch.groups[g];
+                if (group->normalTexture.id > 0) {
+                    rlActiveTextureSlot(3);
+                    rlEnableTexture(group->normalTexture.id);
+                    SetShaderValue(lightShader, normalMapLoc, (int[]){3}, SHADER_UNIFORM_INT);
+                    SetShaderValue(lightShader, useNormalMapLoc, (int[]){1}, SHADER_UNIFORM_INT);
+                } else {
+                    SetShaderValue(lightShader, useNormalMapLoc, (int[]){0}, SHADER_UNIFORM_INT);
+                }
+                DrawMesh(group->mesh, group->material, MatrixIdentity());
+            }
             // Reset normal map after env pieces so other models don't use it
             SetShaderValue(lightShader, useNormalMapLoc, (int[]){0}, SHADER_UNIFORM_INT);
 
-            // Draw units
-            for (int i = 0; i < unitCount; i++)
+            // Draw units, grouped by material and pose
+            int unitDrawCount = SortUnitDraws(units, unitCount, unitTypes, unitDrawOrder);
+            for (int d = 0; d < unitDrawCount; d++)
             {
-                if (!units[i].active) continue;
+                int i = unitDrawOrder[d];
                 if (IsUnitInStatueSpawn(&statueSpawn, i)) continue; // drawn separately as falling statue
                 if (intro.active && intro.unitIndex == i) continue; // hidden during intro splash
                 UnitType *type = &unitTypes[units[i].typeIndex];
-                if (!type->loaded) continue;
                 Color tint = GetTeamTint(units[i].team);
                 if (units[i].hitFlash > 0) {
                     float f = units[i].hitFlash / HIT_FLASH_DURATION;
@@ -4217,18 +3897,14 @@ int main(void)
                         tint.b = (unsigned char)(tint.b + (128 - (int)tint.b) * f);
                     }
                 }
-                if (type->hasAnimations) {
-                    int idx = type->animIndex[units[i].currentAnim];
-                    if (idx >= 0) {
-                        ModelAnimation *arr = GetAnimArray(type, units[i].currentAnim);
-                        if (arr) UpdateModelAnimation(type->model, arr[idx], units[i].animFrame);
-                    }
-                }
+                PoseUnitModel(&poseCache, type, units[i].currentAnim, units[i].animFrame);
                 float s = type->scale * units[i].scaleOverride;
                 Vector3 drawPos = units[i].position;
                 drawPos.y += type->yOffset;
+                SetShaderValue(lightShader, lightSkinnedLoc, (int[]){ type->hasAnimations }, SHADER_UNIFORM_INT);
                 DrawModelEx(type->model, drawPos, (Vector3){0,1,0}, units[i].facingAngle,
                     (Vector3){s, s, s}, tint);
+                SetShaderValue(lightShader, lightSkinnedLoc, (int[]){0}, SHADER_UNIFORM_INT);
 
                 if (units[i].selected)
                 {
@@ -4244,8 +3920,7 @@ int main(void)
                     UnitType *stype = &unitTypes[units[si].typeIndex];
                     if (stype->loaded) {
                         // Force idle frame 0 pose (frozen statue)
-                        if (stype->hasAnimations && stype->animIndex[ANIM_IDLE] >= 0)
-                            UpdateModelAnimation(stype->model, stype->idleAnims[stype->animIndex[ANIM_IDLE]], 0);
+                        PoseUnitModel(&poseCache, stype, ANIM_IDLE, 0);
                         float ss = stype->scale * units[si].scaleOverride;
                         // Compute drift offset based on height fraction
                         float hRange = SPAWN_ANIM_START_Y - statueSpawn.targetY;
@@ -4258,8 +3933,10 @@ int main(void)
                             units[si].position.z + statueSpawn.driftZ * dFrac
                         };
                         Color stoneTint = { 160, 160, 170, 255 }; // grayish stone tint
+                        SetShaderValue(lightShader, lightSkinnedLoc, (int[]){ stype->hasAnimations }, SHADER_UNIFORM_INT);
                         DrawModelEx(stype->model, statuePos, (Vector3){0,1,0}, units[si].facingAngle,
                             (Vector3){ss, ss, ss}, stoneTint);
+                        SetShaderValue(lightShader, lightSkinnedLoc, (int[]){0}, SHADER_UNIFORM_INT);
                     }
                 }
             }
@@ -4321,8 +3998,8 @@ int main(void)
             }
 
             // Draw projectiles
-            for (int p = 0; p < MAX_PROJECTILES; p++) {
-                if (!projectiles[p].active) continue;
+            for (int k = 0; k < projectilePool.liveCount; k++) {
+                int p = projectilePool.live[k];
                 float pr = 1.5f;
                 if (projectiles[p].chargeTimer > 0 && projectiles[p].chargeMax > 0) {
                     float t = 1.0f - projectiles[p].chargeTimer / projectiles[p].chargeMax;
@@ -4331,49 +4008,14 @@ int main(void)
                 DrawSphere(projectiles[p].position, pr, projectiles[p].color);
             }
 
-            // Draw particles as camera-facing billboards
-            {
-                // Compute camera right and up vectors for billboarding
-                Vector3 camFwd = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
-                Vector3 camRight = Vector3Normalize(Vector3CrossProduct(camFwd, camera.up));
-                Vector3 camUp = Vector3CrossProduct(camRight, camFwd);
-
-                rlDisableDepthMask();
-                rlDrawRenderBatchActive();
-                rlSetBlendFactors(RL_SRC_ALPHA, RL_ONE, RL_FUNC_ADD);  // additive blending
-                rlSetBlendMode(BLEND_CUSTOM);
-                rlSetTexture(particleTex.id);
-                rlBegin(RL_QUADS);
-                for (int p = 0; p < MAX_PARTICLES; p++) {
-                    if (!particles[p].active) continue;
-                    float sz = particles[p].size;
-                    Vector3 pos = particles[p].position;
-                    Color c = particles[p].color;
-
-                    // 4 corners: pos ± right*sz ± up*sz
-                    Vector3 r = { camRight.x * sz, camRight.y * sz, camRight.z * sz };
-                    Vector3 u = { camUp.x * sz, camUp.y * sz, camUp.z * sz };
-
-                    // Bottom-left
-                    rlColor4ub(c.r, c.g, c.b, c.a);
-                    rlTexCoord2f(0.0f, 1.0f);
-                    rlVertex3f(pos.x - r.x - u.x, pos.y - r.y - u.y, pos.z - r.z - u.z);
-                    // Bottom-right
-                    rlTexCoord2f(1.0f, 1.0f);
-                    rlVertex3f(pos.x + r.x - u.x, pos.y + r.y - u.y, pos.z + r.z - u.z);
-                    // Top-right
-                    rlTexCoord2f(1.0f, 0.0f);
-                    rlVertex3f(pos.x + r.x + u.x, pos.y + r.y + u.y, pos.z + r.z + u.z);
-                    // Top-left
-                    rlTexCoord2f(0.0f, 0.0f);
-                    rlVertex3f(pos.x - r.x + u.x, pos.y - r.y + u.y, pos.z - r.z + u.z);
-                }
-                rlEnd();
-                rlSetTexture(0);
-                rlDrawRenderBatchActive();
-                rlSetBlendMode(BLEND_ALPHA);  // restore normal blending
-                rlEnableDepthMask();
-            }
+            // Draw particles as camera-facing billboards (one instanced draw)
+            rlDisableDepthMask();
+            rlDrawRenderBatchActive();
+            rlSetBlendFactors(RL_SRC_ALPHA, RL_ONE, RL_FUNC_ADD);  // additive blending
+            rlSetBlendMode(BLEND_CUSTOM);
+            ParticleRendererDraw(&particleRenderer, &particles, camera, particleTex);
+            rlSetBlendMode(BLEND_ALPHA);  // restore normal blending
+            rlEnableDepthMask();
 
             // Draw fissures (gray cubes along the line)
             for (int f = 0; f < MAX_FISSURES; f++) {
@@ -4438,34 +4080,6 @@ int main(void)
         // Render offscreen textures before fxaaRT to avoid nested render targets
         // (raylib's EndTextureMode always restores to FBO 0, breaking nesting)
 
-        // Game-over portraits
-        if (phase == PHASE_GAME_OVER && !isMultiplayer && !deathPenalty) {
-            int noShadowOn = 1, noShadowOff = 0;
-            SetShaderValue(lightShader, noShadowLoc, &noShadowOn, SHADER_UNIFORM_INT);
-            int goBlueRT[BLUE_TEAM_MAX_SIZE]; int goCountRT = 0;
-            for (int i = 0; i < unitCount && goCountRT < BLUE_TEAM_MAX_SIZE; i++)
-                if (units[i].active && units[i].team == TEAM_BLUE) goBlueRT[goCountRT++] = i;
-            for (int h = 0; h < goCountRT; h++) {
-                int ui = goBlueRT[h];
-                UnitType *type = &unitTypes[units[ui].typeIndex];
-                if (!type->loaded) continue;
-                BoundingBox bb = type->baseBounds;
-                float centerY = (bb.min.y + bb.max.y) / 2.0f * type->scale;
-                float extent = (bb.max.y - bb.min.y) * type->scale;
-                portraitCam.target = (Vector3){ 0.0f, centerY, 0.0f };
-                portraitCam.position = (Vector3){ 0.0f, centerY, extent * 2.5f };
-                BeginTextureMode(portraits[h]);
-                    ClearBackground((Color){ 30, 30, 40, 255 });
-                    BeginMode3D(portraitCam);
-                        if (type->hasAnimations && type->animIndex[ANIM_IDLE] >= 0)
-                            UpdateModelAnimation(type->model, type->idleAnims[type->animIndex[ANIM_IDLE]], 0);
-                        DrawModel(type->model, (Vector3){ 0, 0, 0 }, type->scale, GetTeamTint(TEAM_BLUE));
-                    EndMode3D();
-                EndTextureMode();
-            }
-            SetShaderValue(lightShader, noShadowLoc, &noShadowOff, SHADER_UNIFORM_INT);
-        }
-
         // Intro model
         if (intro.active) {
             UnitType *itype = &unitTypes[intro.typeIndex];
@@ -4486,32 +4100,87 @@ int main(void)
                 BeginTextureMode(introModelRT);
                     ClearBackground(BLANK);
                     BeginMode3D(introCam);
-                        if (itype->hasAnimations && itype->animIndex[ANIM_IDLE] >= 0)
-                            UpdateModelAnimation(itype->model,
-                                itype->idleAnims[itype->animIndex[ANIM_IDLE]], intro.animFrame);
+                        PoseUnitModel(&poseCache, itype, ANIM_IDLE, intro.animFrame);
+                        SetShaderValue(lightShader, lightSkinnedLoc, (int[]){ itype->hasAnimations }, SHADER_UNIFORM_INT);
                         DrawModel(itype->model, (Vector3){0,0,0}, itype->scale,
                                   GetTeamTint(TEAM_BLUE));
+                        SetShaderValue(lightShader, lightSkinnedLoc, (int[]){0}, SHADER_UNIFORM_INT);
                     EndMode3D();
                 EndTextureMode();
                 SetShaderValue(lightShader, noShadowLoc, &noShadowOff, SHADER_UNIFORM_INT);
             }
         }
 
+        // AO at the preset's resolution (before fxaaRT; render targets don't nest)
+        float nearPlane = 0.1f, farPlane = 1000.0f;
+        int aoDivisor = SSAO_PRESETS[ssaoPreset].divisor;
+        {
+            int wantW = aoDivisor ? (sceneRTWidth + aoDivisor - 1) / aoDivisor : 0;
+            int wantH = aoDivisor ? (sceneRTHeight + aoDivisor - 1) / aoDivisor : 0;
+            if (wantW != aoRTWidth || wantH != aoRTHeight) {
+                for (int k = 0; k < 2; k++) {
+                    if (aoRT[k].id) UnloadRenderTexture(aoRT[k]);
+                    aoRT[k] = wantW ? LoadRenderTexture(wantW, wantH) : (RenderTexture2D){ 0 };
+                }
+                aoRTWidth = wantW;
+                aoRTHeight = wantH;
+                aoHistoryValid = false;
+            }
+        }
+        if (aoDivisor) {
+            bool temporal = SSAO_PRESETS[ssaoPreset].temporal;
+            int useHistory = (temporal && aoHistoryValid) ? 1 : 0;
+            // Golden-angle steps spread successive frames' patterns evenly
+            float jitter = temporal ? (float)(aoFrame++ % 64) * 2.39996f : 0.0f;
+            int prev = aoCurrent;
+            aoCurrent = temporal ? 1 - aoCurrent : 0;
+            float res[2] = { (float)sceneRTWidth, (float)sceneRTHeight };
+            float aoRes[2] = { (float)aoRTWidth, (float)aoRTHeight };
+            SetShaderValue(aoShader, aoResLoc, res, SHADER_UNIFORM_VEC2);
+            SetShaderValue(aoShader, aoAoResLoc, aoRes, SHADER_UNIFORM_VEC2);
+            SetShaderValue(aoShader, aoNearLoc, &nearPlane, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(aoShader, aoFarLoc, &farPlane, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(aoShader, aoJitterLoc, &jitter, SHADER_UNIFORM_FLOAT);
+            SetShaderValue(aoShader, aoTemporalLoc, &useHistory, SHADER_UNIFORM_INT);
+            SetShaderValueMatrix(aoShader, aoInvVPLoc, MatrixInvert(sceneViewProj));
+            SetShaderValueMatrix(aoShader, aoPrevVPLoc, prevSceneViewProj);
+            BeginTextureMode(aoRT[aoCurrent]);
+                rlActiveTextureSlot(1);
+                // Never bind the target itself; without history the shader ignores slot 1
+                rlEnableTexture(useHistory ? aoRT[prev].texture.id : sceneRT.depth.id);
+                SetShaderValue(aoShader, aoHistoryLoc, (int[]){1}, SHADER_UNIFORM_INT);
+                BeginShaderMode(aoShader);
+                    // Covers the target; the shader addresses depth by gl_FragCoord
+                    DrawTexturePro(sceneRT.depth, (Rectangle){ 0, 0, (float)sceneRTWidth, (float)sceneRTHeight },
+                        (Rectangle){ 0, 0, (float)aoRTWidth, (float)aoRTHeight }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+                EndShaderMode();
+                rlActiveTextureSlot(0);
+            EndTextureMode();
+            aoHistoryValid = temporal;
+        } else {
+            aoHistoryValid = false;
+        }
+        prevSceneViewProj = sceneViewProj;
+
         // Composite scene + post-process into FXAA RT (avoid nesting render targets)
         BeginTextureMode(fxaaRT);
         ClearBackground((Color){ 45, 40, 35, 255 });
 
         // Draw scene with SSAO post-process
         {
-            float res[2] = { (float)sceneRTWidth, (float)sceneRTHeight };
-            float nearPlane = 0.1f, farPlane = 1000.0f;
-            SetShaderValue(ssaoShader, ssaoResLoc, res, SHADER_UNIFORM_VEC2);
+            float aoRes[2] = { (float)aoRTWidth, (float)aoRTHeight };
+            int aoEnabled = aoDivisor ? 1 : 0;
             SetShaderValue(ssaoShader, ssaoNearLoc, &nearPlane, SHADER_UNIFORM_FLOAT);
             SetShaderValue(ssaoShader, ssaoFarLoc, &farPlane, SHADER_UNIFORM_FLOAT);
-            // Bind depth texture to texture unit 1
+            SetShaderValue(ssaoShader, ssaoAoResLoc, aoRes, SHADER_UNIFORM_VEC2);
+            SetShaderValue(ssaoShader, ssaoAoEnabledLoc, &aoEnabled, SHADER_UNIFORM_INT);
+            // Bind depth texture to texture unit 1, AO to unit 2
             rlActiveTextureSlot(1);
             rlEnableTexture(sceneRT.depth.id);
             SetShaderValue(ssaoShader, ssaoDepthLoc, (int[]){1}, SHADER_UNIFORM_INT);
+            rlActiveTextureSlot(2);
+            rlEnableTexture(aoRT[aoCurrent].texture.id);
+            SetShaderValue(ssaoShader, ssaoAoTexLoc, (int[]){2}, SHADER_UNIFORM_INT);
             BeginShaderMode(ssaoShader);
                 DrawTextureRec(sceneRT.texture,
                     (Rectangle){ 0, 0, (float)sceneRTWidth, -(float)sceneRTHeight },
@@ -5347,13 +5016,13 @@ int main(void)
                         GameDrawText("X", xBtnX + (xBtnSize - xw) / 2, xBtnY + 2, 12, WHITE);
                     }
 
-                    // Portrait (left side of card) — Y-flipped for RenderTexture
-                    // srcRect uses base texture size, dstRect uses scaled size
-                    Rectangle srcRect = { 0, 0, (float)HUD_PORTRAIT_SIZE_BASE, -(float)HUD_PORTRAIT_SIZE_BASE };
+                    // Portrait (left side of card) — atlas cell at base size, drawn scaled
+                    int portraitCell = PortraitCacheFind(&portraitCache, units[ui].typeIndex, GetTeamTint(TEAM_BLUE));
                     Rectangle dstRect = { (float)(cardX + S(4)), (float)(cardsY + S(4)),
                                           (float)hudPortraitSize, (float)hudPortraitSize };
-                    DrawTexturePro(portraits[slot].texture, srcRect, dstRect,
-                                  (Vector2){ 0, 0 }, 0.0f, WHITE);
+                    if (portraitCell >= 0)
+                        DrawTexturePro(portraitCache.atlas.texture, PortraitCacheRect(&portraitCache, portraitCell),
+                                       dstRect, (Vector2){ 0, 0 }, 0.0f, WHITE);
                     DrawRectangleLines(cardX + S(4), cardsY + S(4),
                                       hudPortraitSize, hudPortraitSize,
                                       (Color){ 60, 60, 80, 255 });
@@ -6307,11 +5976,12 @@ int main(void)
                 DrawRectangleLinesEx((Rectangle){(float)cx,(float)cardY,(float)cardW,(float)cardH}, 2, (Color){60,60,80,255});
 
                 // Portrait
-                if (h < blueHudCount) {
+                int portraitCell = PortraitCacheFind(&portraitCache, units[ui].typeIndex, GetTeamTint(TEAM_BLUE));
+                if (portraitCell >= 0) {
                     int portSize = 80;
-                    Rectangle srcRect = { 0, 0, (float)hudPortraitSize, -(float)hudPortraitSize };
                     Rectangle dstRect = { (float)(cx + 10), (float)(cardY + 10), (float)portSize, (float)portSize };
-                    DrawTexturePro(portraits[h].texture, srcRect, dstRect, (Vector2){0,0}, 0.0f, WHITE);
+                    DrawTexturePro(portraitCache.atlas.texture, PortraitCacheRect(&portraitCache, portraitCell),
+                                   dstRect, (Vector2){0,0}, 0.0f, WHITE);
                     DrawRectangleLines(cx + 10, cardY + 10, portSize, portSize, (Color){60,60,80,255});
                 }
 
@@ -6466,11 +6136,12 @@ int main(void)
                 DrawRectangleLinesEx((Rectangle){(float)cx,(float)goCardY,(float)goCardW,(float)goCardH}, 2, (Color){60,60,80,255});
 
                 // Portrait
-                if (h < BLUE_TEAM_MAX_SIZE) {
+                int portraitCell = PortraitCacheFind(&portraitCache, units[ui].typeIndex, GetTeamTint(TEAM_BLUE));
+                if (portraitCell >= 0) {
                     int portSize = 80;
-                    Rectangle srcRect = { 0, 0, (float)hudPortraitSize, -(float)hudPortraitSize };
                     Rectangle dstRect = { (float)(cx + 10), (float)(goCardY + 6), (float)portSize, (float)portSize };
-                    DrawTexturePro(portraits[h].texture, srcRect, dstRect, (Vector2){0,0}, 0.0f, WHITE);
+                    DrawTexturePro(portraitCache.atlas.texture, PortraitCacheRect(&portraitCache, portraitCell),
+                                   dstRect, (Vector2){0,0}, 0.0f, WHITE);
                     DrawRectangleLines(cx + 10, goCardY + 6, portSize, portSize, (Color){60,60,80,255});
                 }
 
@@ -6741,7 +6412,7 @@ int main(void)
                 10, GetScreenHeight() - 30, 20, YELLOW);
             // Draw shadow map depth as small preview in corner
             float previewSize = 256.0f;
-            Rectangle srcRec = { 0, 0, (float)SHADOW_MAP_SIZE, -(float)SHADOW_MAP_SIZE };
+            Rectangle srcRec = { 0, 0, (float)shadowMapSize, -(float)shadowMapSize };
             Rectangle dstRec = { GetScreenWidth() - previewSize - 10, 10, previewSize, previewSize };
             DrawTexturePro(shadowRT.texture, srcRec, dstRec, (Vector2){0,0}, 0.0f, WHITE);
             DrawRectangleLines((int)dstRec.x, (int)dstRec.y, (int)previewSize, (int)previewSize, YELLOW);
@@ -6822,7 +6493,7 @@ int main(void)
         // Color grading debug overlay
         if (cgDebugOverlay) {
             int oy = 30;
-            DrawRectangle(5, oy - 2, 320, 200, Fade(BLACK, 0.7f));
+            DrawRectangle(5, oy - 2, 320, 214, Fade(BLACK, 0.7f));
             DrawText(TextFormat("Color Grade [F6]  1/2:exp 3/4:con 5/6:sat 7/8:temp 9/0:vig"), 10, oy, 10, GREEN);
             oy += 16;
             DrawText(TextFormat("exposure:    %.3f", cgExposure),    10, oy, 10, WHITE); oy += 14;
@@ -6833,8 +6504,38 @@ int main(void)
             DrawText(TextFormat("vignetteSft: %.3f", cgVignetteSoft),10, oy, 10, WHITE); oy += 14;
             DrawText(TextFormat("lift: %.2f %.2f %.2f", cgLift[0], cgLift[1], cgLift[2]), 10, oy, 10, WHITE); oy += 14;
             DrawText(TextFormat("gain: %.2f %.2f %.2f", cgGain[0], cgGain[1], cgGain[2]), 10, oy, 10, WHITE); oy += 14;
-            DrawText("-/=: vignetteSoftness", 10, oy, 10, GRAY);
+            DrawText("-/=: vignetteSoftness", 10, oy, 10, GRAY); oy += 14;
+            DrawText(TextFormat("ssao [F8]:   %s (%dx%d)", SSAO_PRESETS[ssaoPreset].name, aoRTWidth, aoRTHeight),
+                10, oy, 10, WHITE);
+        }
+
+#ifdef COMBAT_PROFILE
+        // Combat profiling overlay — per-tick averages for this battle and the session
+        if (combatProfOverlay) {
+            int ox = GetScreenWidth() - 330;
+            int oy = 30;
+            DrawRectangle(ox - 5, oy - 2, 330, 230, Fade(BLACK, 0.7f));
+            DrawText("Combat Profile [F7]   ns/tick   (session)", ox, oy, 10, GREEN);
+            oy += 16;
+            double bt = combatProf.ticks ? (double)combatProf.ticks : 1.0;
+            double st = sessionProf.ticks ? (double)sessionProf.ticks : 1.0;
+            for (int sec = 0; sec < PROF_SEC_COUNT; sec++) {
+                DrawText(TextFormat("%-16s %8.0f   (%8.0f)", PROF_SECTION_NAMES[sec],
+                         combatProf.ns[sec] / bt, sessionProf.ns[sec] / st), ox, oy, 10, WHITE);
+                oy += 14;
+            }
+            oy += 4;
+            DrawText("counters           per tick  (session)", ox, oy, 10, GREEN);
+            oy += 16;
+            for (int c = 0; c < PROF_CNT_COUNT; c++) {
+                DrawText(TextFormat("%-16s %8.2f   (%8.2f)", PROF_COUNTER_NAMES[c],
+                         combatProf.counters[c] / bt, sessionProf.counters[c] / st), ox, oy, 10, WHITE);
+                oy += 14;
+            }
+            DrawText(TextFormat("ticks %llu   battles %llu", (unsigned long long)combatProf.ticks,
+                     (unsigned long long)sessionProf.battles), ox, oy + 4, 10, GRAY);
         }
+#endif
 
         DrawFPS(10, 10);
         EndDrawing();
@@ -6846,7 +6547,7 @@ int main(void)
         pclose(nfcPipe);
         printf("[NFC] Bridge closed\n");
     }
-    for (int i = 0; i < BLUE_TEAM_MAX_SIZE; i++) UnloadRenderTexture(portraits[i]);
+    PortraitCacheUnload(&portraitCache);
     UnloadRenderTexture(introModelRT);
     UnloadRenderTexture(fxaaRT);
     UnloadRenderTexture(colorGradeRT);
@@ -6854,13 +6555,16 @@ int main(void)
     rlUnloadTexture(sceneRT.texture.id);
     rlUnloadTexture(sceneRT.depth.id);
     UnloadShader(ssaoShader);
+    UnloadShader(aoShader);
+    for (int k = 0; k < 2; k++) if (aoRT[k].id) UnloadRenderTexture(aoRT[k]);
     UnloadShader(fxaaShader);
     UnloadShader(colorGradeShader);
-    rlUnloadFramebuffer(shadowRT.id);
-    rlUnloadTexture(shadowRT.texture.id);
-    rlUnloadTexture(shadowRT.depth.id);
+    UnloadShadowTarget(shadowRT);
+    UnloadShadowTarget(shadowStaticRT);
     UnloadShader(shadowDepthShader);
     UnloadTexture(particleTex);
+    ParticleRendererUnload(&particleRenderer);
+    UnloadShader(particleShader);
     UnloadShader(lightShader);
     UnloadShader(borderShader);
     UnloadMesh(borderMesh);
@@ -6876,6 +6580,7 @@ int main(void)
         if (unitTypes[i].castAnims)
             UnloadModelAnimations(unitTypes[i].castAnims, unitTypes[i].castAnimCount);
         if (unitTypes[i].loaded) UnloadModel(unitTypes[i].model);
+        MemFree(unitTypes[i].depthMaterials);
     }
     for (int i = 0; i < TILE_VARIANTS; i++) UnloadModel(tileModels[i]);
     UnloadTexture(tileDiffuse);
@@ -6895,9 +6600,11 @@ int main(void)
     UnloadTexture(circleDiffuse);
     UnloadTexture(circleORM);
     UnloadTexture(circleNormal);
+    EnvBatchUnload(&envBatch);
     // Unload env models (skip 2=stairs, 3=circle, 5=ground which alias stairsModel/circleModel/platformModel)
     // Skip textures for 7=PillarSmall which shares textures with 6=PillarBig
     for (int i = 0; i < envModelCount; i++) {
+        MemFree(envModels[i].depthMaterials);
         if (i == 2 || i == 3 || i == 5) continue;  // reused models, already unloaded above
         if (envModels[i].loaded) UnloadModel(envModels[i].model);
         if (i == 4 || i == 7) continue;  // shared textures (FloorTiles=tiles, PillarSmall=PillarBig)
@@ -6925,6 +6632,8 @@ int main(void)
     UnloadSound(sfxUiDrag);
     UnloadSound(sfxUiDrop);
     UnloadSound(sfxUiReroll);
+    ClientSimStop(&clientSim);
+    CombatEventQueueFree(&combatEvents);
     CloseAudioDevice();
     CloseWindow();
     return 0;
@@ -136,10 +136,20 @@ static void handle_server_msg(NetClient *nc, const NetMessage *msg)
                        nc->combatNetUnitCount * sizeof(NetUnit));
             }
             nc->combatStarted = true;
+            if (nc->stream) StreamClientBegin(nc->stream, nc->stream->events);
             printf("[Net] Combat start: %d units\n", nc->combatNetUnitCount);
         }
         break;
 
+    case MSG_COMBAT_SNAPSHOT: {
+        if (!nc->stream || !nc->stream->active) break;
+        uint16_t ackSeq;
+        if (StreamClientReceive(nc->stream, msg->payload, msg->size, &ackSeq)) {
+            uint8_t payload[2] = { (uint8_t)(ackSeq & 0xFF), (uint8_t)(ackSeq >> 8) };
+            net_send_msg(nc->sockfd, MSG_SNAPSHOT_ACK, payload, 2);
+        }
+    } break;
+
     case MSG_ROUND_RESULT:
         if (msg->size >= 5) {
             nc->roundWinner = msg->payload[0];
@@ -260,6 +270,13 @@ void net_client_send_remove_unit(NetClient *nc, int unitIndex)
     net_send_msg(nc->sockfd, MSG_REMOVE_UNIT, payload, 1);
 }
 
+void net_client_send_stream_request(NetClient *nc, int hz)
+{
+    if (nc->sockfd < 0) return;
+    uint8_t payload[1] = { (uint8_t)hz };
+    net_send_msg(nc->sockfd, MSG_STREAM_REQUEST, payload, 1);
+}
+
 void net_client_disconnect(NetClient *nc)
 {
     if (nc->sockfd >= 0) {
@@ -2,6 +2,7 @@
 #include "net_protocol.h"
 #include "net_common.h"
 #include "game.h"
+#include "combat_stream.h"
 
 //------------------------------------------------------------------------------------
 // Client Network State
@@ -55,6 +56,10 @@ typedef struct {
 
     // Shop from server
     ShopSlot serverShop[MAX_SHOP_SLOTS];
+
+    // Streamed combat (NULL = simulate locally). Restarted on every MSG_COMBAT_START,
+    // so snapshots arriving in the same poll are never lost.
+    StreamClient *stream;
 } NetClient;
 
 // Initialize client state (does not connect)
@@ -82,6 +87,9 @@ void net_client_send_place_unit(NetClient *nc, int typeIndex, float posX, float
 // Send MSG_REMOVE_UNIT
 void net_client_send_remove_unit(NetClient *nc, int unitIndex);
 
+// Send MSG_STREAM_REQUEST (hz = 0: simulate combat locally)
+void net_client_send_stream_request(NetClient *nc, int hz);
+
 // Disconnect and cleanup
 void net_client_disconnect(NetClient *nc);
 
@@ -29,6 +29,8 @@ typedef enum {
     MSG_BUY_ABILITY      = 0x05,  // payload: shop slot index
     MSG_ROLL_SHOP        = 0x06,  // payload: none
     MSG_ASSIGN_ABILITY   = 0x07,  // payload: inventory slot, unit index, ability slot
+    MSG_STREAM_REQUEST   = 0x08,  // payload: snapshot rate in Hz (0 = simulate combat locally)
+    MSG_SNAPSHOT_ACK     = 0x09,  // payload: [seq:2] newest combat snapshot decoded
     MSG_LEADERBOARD_SUBMIT  = 0x10, // payload: serialized leaderboard entry (55 bytes)
     MSG_LEADERBOARD_REQUEST = 0x11, // payload: none
     MSG_NFC_REGISTER        = 0x12, // payload: [uidLen:1][uid:4-7][typeIndex:1][rarity:1]
@@ -53,6 +55,7 @@ typedef enum {
     MSG_OPPONENT_READY   = 0x87,  // payload: none
     MSG_ERROR            = 0x88,  // payload: error string
     MSG_GOLD_UPDATE      = 0x89,  // payload: current gold amount
+    MSG_COMBAT_SNAPSHOT  = 0x8A,  // payload: delta-encoded combat state + events (combat_stream.h)
     MSG_LEADERBOARD_DATA = 0x90,  // payload: entry count + serialized entries
     MSG_NFC_DATA         = 0x91,  // payload: [uidLen:1][uid:4-7][status:1][typeIndex:1][rarity:1][abilities × 4 × (id:1, level:1)]
     MSG_NFC_PREFETCH_DATA = 0x92, // payload: [count:2][uids × (uidLen:1, uid:4-7)]
@@ -0,0 +1,82 @@
+#include "particle_render.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <stdio.h>
+
+void ParticleRendererInit(ParticleRenderer *pr, Shader shader, int capacity)
+{
+    static const float corners[12] = { -1, -1,  1, -1,  1, 1,   -1, -1,  1, 1,  -1, 1 };
+    *pr = (ParticleRenderer){ .shader = shader, .capacity = capacity };
+    pr->camRightLoc = GetShaderLocation(shader, "camRight");
+    pr->camUpLoc = GetShaderLocation(shader, "camUp");
+    int cornerLoc = GetShaderLocationAttrib(shader, "vertexCorner");
+    int posSizeLoc = GetShaderLocationAttrib(shader, "instancePosSize");
+    int colorLoc = GetShaderLocationAttrib(shader, "instanceColor");
+    if (cornerLoc < 0 || posSizeLoc < 0 || colorLoc < 0) {
+        printf("[PARTICLE] particle shader is missing its vertex attributes\n");
+        return;
+    }
+
+    pr->vao = rlLoadVertexArray();
+    rlEnableVertexArray(pr->vao);
+    pr->cornerVbo = rlLoadVertexBuffer(corners, sizeof(corners), false);
+    rlSetVertexAttribute(cornerLoc, 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(cornerLoc);
+    pr->instanceVbo = rlLoadVertexBuffer(NULL, capacity * (int)sizeof(ParticleInstance), true);
+    rlSetVertexAttribute(posSizeLoc, 4, RL_FLOAT, false, sizeof(ParticleInstance), 0);
+    rlEnableVertexAttribute(posSizeLoc);
+    rlSetVertexAttributeDivisor(posSizeLoc, 1);
+    rlSetVertexAttribute(colorLoc, 4, RL_UNSIGNED_BYTE, true, sizeof(ParticleInstance), 4 * sizeof(float));
+    rlEnableVertexAttribute(colorLoc);
+    rlSetVertexAttributeDivisor(colorLoc, 1);
+    rlDisableVertexArray();
+
+    pr->staging = MemAlloc(capacity * sizeof(ParticleInstance));
+    printf("[PARTICLE] Instanced renderer ready (%d particles, %d KB buffer)\n",
+           capacity, (int)(capacity * sizeof(ParticleInstance) / 1024));
+}
+
+void ParticleRendererDraw(ParticleRenderer *pr, const ParticleSystem *particles, Camera3D camera, Texture2D texture)
+{
+    if (!pr->vao) return;
+    int count = particles->count < pr->capacity ? particles->count : pr->capacity;
+    if (count == 0) return;
+    for (int p = 0; p < count; p++) {
+        Color c = particles->color[p];
+        pr->staging[p] = (ParticleInstance){ particles->posX[p], particles->posY[p], particles->posZ[p],
+                                             particles->size[p], c.r, c.g, c.b, c.a };
+    }
+
+    // Camera right and up vectors for billboarding
+    Vector3 camFwd = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+    Vector3 camRight = Vector3Normalize(Vector3CrossProduct(camFwd, camera.up));
+    Vector3 camUp = Vector3CrossProduct(camRight, camFwd);
+
+    rlDrawRenderBatchActive();
+    rlUpdateVertexBuffer(pr->instanceVbo, pr->staging, count * (int)sizeof(ParticleInstance), 0);
+    rlEnableShader(pr->shader.id);
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    rlSetUniformMatrix(pr->shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(pr->camRightLoc, &camRight, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(pr->camUpLoc, &camUp, RL_SHADER_UNIFORM_VEC3, 1);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(texture.id);
+    rlSetUniform(pr->shader.locs[SHADER_LOC_MAP_DIFFUSE], (int[]){ 0 }, RL_SHADER_UNIFORM_INT, 1);
+
+    rlEnableVertexArray(pr->vao);
+    rlDrawVertexArrayInstanced(0, 6, count);
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+void ParticleRendererUnload(ParticleRenderer *pr)
+{
+    if (pr->vao) {
+        rlUnloadVertexArray(pr->vao);
+        rlUnloadVertexBuffer(pr->cornerVbo);
+        rlUnloadVertexBuffer(pr->instanceVbo);
+    }
+    MemFree(pr->staging);
+    *pr = (ParticleRenderer){ 0 };
+}
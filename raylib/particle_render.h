@@ -0,0 +1,28 @@
+#pragma once
+#include "game.h"
+
+//------------------------------------------------------------------------------------
+// Instanced particle renderer — live particles are packed into a compact per-instance
+// record (position, half-size, RGBA8) and streamed into one VBO allocated for the full
+// particle budget at startup. particle.vs expands every instance into a camera-facing
+// quad, so all particles go out in a single instanced draw.
+//------------------------------------------------------------------------------------
+typedef struct {
+    float x, y, z, size;        // world position, billboard half-size
+    unsigned char r, g, b, a;
+} ParticleInstance;             // 20 bytes
+
+typedef struct {
+    Shader shader;
+    unsigned int vao;
+    unsigned int cornerVbo;     // 6 quad corners, shared by every instance
+    unsigned int instanceVbo;   // capacity * ParticleInstance, rewritten each frame
+    int capacity;
+    int camRightLoc, camUpLoc;
+    ParticleInstance *staging;
+} ParticleRenderer;
+
+void ParticleRendererInit(ParticleRenderer *pr, Shader shader, int capacity);
+// Draw inside BeginMode3D; blend mode and depth mask are left to the caller
+void ParticleRendererDraw(ParticleRenderer *pr, const ParticleSystem *particles, Camera3D camera, Texture2D texture);
+void ParticleRendererUnload(ParticleRenderer *pr);
@@ -20,30 +20,30 @@
 static const float zoneCentersX[5] = { -50.0f, 50.0f, 0.0f, -50.0f, 50.0f };
 static const float zoneCentersZ[5] = { -40.0f, -40.0f, 0.0f,  40.0f, 40.0f };
 
-void PlazaSpawnEnemies(Unit units[], int *unitCount, int unitTypeCount, PlazaUnitData plazaData[])
+void PlazaSpawnEnemies(Rng *rng, Unit units[], int *unitCount, int unitTypeCount, PlazaUnitData plazaData[])
 {
     (void)unitTypeCount; // use VALID_UNIT_TYPES instead
     for (int i = 0; i < PLAZA_ENEMY_COUNT; i++) {
-        int type = VALID_UNIT_TYPES[GetRandomValue(0, VALID_UNIT_TYPE_COUNT - 1)];
+        int type = VALID_UNIT_TYPES[RngRange(rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
         if (SpawnUnit(units, unitCount, type, TEAM_RED)) {
             int idx = *unitCount - 1;
             Unit *u = &units[idx];
-            u->position.x = zoneCentersX[i] + (float)GetRandomValue(-15, 15);
-            u->position.z = zoneCentersZ[i] + (float)GetRandomValue(-15, 15);
+            u->position.x = zoneCentersX[i] + (float)RngRange(rng, -15, 15);
+            u->position.z = zoneCentersZ[i] + (float)RngRange(rng, -15, 15);
             u->position.y = 0.0f;
-            u->facingAngle = (float)GetRandomValue(0, 360);
+            u->facingAngle = (float)RngRange(rng, 0, 360);
             u->currentAnim = ANIM_IDLE;
 
             PlazaUnitData *pd = &plazaData[idx];
             pd->zoneIndex = i;
             pd->isScared = false;
             // Initial roam target within their zone
-            pd->roamTarget.x = zoneCentersX[i] + (float)GetRandomValue((int)(-PLAZA_ZONE_HALF_RANGE), (int)(PLAZA_ZONE_HALF_RANGE));
+            pd->roamTarget.x = zoneCentersX[i] + (float)RngRange(rng, (int)(-PLAZA_ZONE_HALF_RANGE), (int)(PLAZA_ZONE_HALF_RANGE));
             pd->roamTarget.y = 0.0f;
-            pd->roamTarget.z = zoneCentersZ[i] + (float)GetRandomValue((int)(-PLAZA_ZONE_HALF_RANGE), (int)(PLAZA_ZONE_HALF_RANGE));
+            pd->roamTarget.z = zoneCentersZ[i] + (float)RngRange(rng, (int)(-PLAZA_ZONE_HALF_RANGE), (int)(PLAZA_ZONE_HALF_RANGE));
             // Brief idle before first walk so they don't all move frame 1
             pd->roamWaitTimer = PLAZA_WAIT_MIN +
-                (float)GetRandomValue(0, (int)((PLAZA_WAIT_MAX - PLAZA_WAIT_MIN) * 10)) / 10.0f;
+                (float)RngRange(rng, 0, (int)((PLAZA_WAIT_MAX - PLAZA_WAIT_MIN) * 10)) / 10.0f;
         }
     }
 }
@@ -192,7 +192,7 @@ void PlazaTriggerScared(Unit units[], int unitCount, PlazaUnitData plazaData[],
 // Flee update — returns true when all red units are gone
 //------------------------------------------------------------------------------------
 bool PlazaUpdateFlee(Unit units[], int unitCount, PlazaUnitData plazaData[] __attribute__((unused)),
-                     Particle particles[], float dt)
+                     ParticleSystem *particles, float dt)
 {
     int redAlive = 0;
     for (int i = 0; i < unitCount; i++) {
@@ -236,23 +236,11 @@ bool PlazaUpdateFlee(Unit units[], int unitCount, PlazaUnitData plazaData[] __at
 //------------------------------------------------------------------------------------
 // Smoke poof a single unit
 //------------------------------------------------------------------------------------
-void PlazaPoofUnit(Unit *unit, Particle particles[])
+void PlazaPoofUnit(Unit *unit, ParticleSystem *particles)
 {
     Vector3 pos = unit->position;
     pos.y += 3.0f;
-    for (int i = 0; i < 20; i++) {
-        float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-        float speed = (float)GetRandomValue(20, 60) / 10.0f;
-        Vector3 vel = {
-            cosf(angle) * speed,
-            (float)GetRandomValue(10, 40) / 10.0f,
-            sinf(angle) * speed
-        };
-        int shade = GetRandomValue(160, 230);
-        Color smokeColor = { (unsigned char)shade, (unsigned char)shade, (unsigned char)shade, 255 };
-        float sz = (float)GetRandomValue(5, 15) / 10.0f;
-        SpawnParticle(particles, pos, vel, 0.6f + (float)GetRandomValue(0, 4) / 10.0f, sz, smokeColor);
-    }
+    SpawnPoofBurst(particles, pos, 20);
     unit->active = false;
 }
 
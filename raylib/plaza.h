@@ -24,7 +24,7 @@ typedef struct {
 // Plaza Functions
 //------------------------------------------------------------------------------------
 // Spawn a set of roaming red enemies for the plaza
-void PlazaSpawnEnemies(Unit units[], int *unitCount, int unitTypeCount, PlazaUnitData plazaData[]);
+void PlazaSpawnEnemies(Rng *rng, Unit units[], int *unitCount, int unitTypeCount, PlazaUnitData plazaData[]);
 
 // Update roaming AI (wander, pause, smooth rotation)
 void PlazaUpdateRoaming(Unit units[], int unitCount, PlazaUnitData plazaData[], float dt);
@@ -36,10 +36,10 @@ void PlazaTriggerScared(Unit units[], int unitCount, PlazaUnitData plazaData[],
 // Update flee behavior (run to edges, poof when off-board)
 // Returns true when all red units are gone
 bool PlazaUpdateFlee(Unit units[], int unitCount, PlazaUnitData plazaData[],
-                     Particle particles[], float dt);
+                     ParticleSystem *particles, float dt);
 
 // Smoke poof a single unit
-void PlazaPoofUnit(Unit *unit, Particle particles[]);
+void PlazaPoofUnit(Unit *unit, ParticleSystem *particles);
 
 // Draw interactive 3D objects (door, trophy) with cel shading white tint — call inside BeginMode3D
 void PlazaDrawObjects(Model doorModel, Model trophyModel, Vector3 doorPos, Vector3 trophyPos,
@@ -6,12 +6,21 @@ in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
 in vec4 vertexTangent;
+in vec4 vertexBoneIds;
+in vec4 vertexBoneWeights;
+in mat4 instanceTransform;
 
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matModel;
 uniform mat4 matNormal;
 uniform mat4 lightVP;
+uniform int instanced;      // 1 = DrawMeshInstanced: model matrix per instance, mvp is view-projection
+uniform int skinned;        // 1 = mesh has bone attributes and a palette posed by PoseUnitModel
+
+// Skinning palette for the mesh being drawn (filled by DrawMesh from mesh.boneMatrices)
+#define MAX_BONE_NUM 128
+uniform mat4 boneMatrices[MAX_BONE_NUM];
 
 // Output vertex attributes (to fragment shader)
 out vec3 fragPosition;
@@ -21,23 +30,43 @@ out vec3 fragNormal;
 out vec4 fragPosLightSpace;
 out mat3 fragTBN;
 
+// Linear blend of up to four bones. Static meshes have no bone attributes enabled, so
+// whatever value the weight attribute holds is ignored unless the draw sets skinned.
+mat4 SkinMatrix()
+{
+    if (skinned != 1) return mat4(1.0);
+    return vertexBoneWeights.x*boneMatrices[int(vertexBoneIds.x)] +
+           vertexBoneWeights.y*boneMatrices[int(vertexBoneIds.y)] +
+           vertexBoneWeights.z*boneMatrices[int(vertexBoneIds.z)] +
+           vertexBoneWeights.w*boneMatrices[int(vertexBoneIds.w)];
+}
+
 void main()
 {
+    mat4 skin = SkinMatrix();
+    vec4 skinnedPos = skin*vec4(vertexPosition, 1.0);
+    vec3 skinnedNormal = mat3(skin)*vertexNormal;
+    vec3 skinnedTangent = mat3(skin)*vertexTangent.xyz;
+
+    // Instances are rigid with uniform scale, so their own 3x3 transforms normals
+    mat4 model = (instanced == 1) ? instanceTransform : matModel;
+    mat3 normalMat = (instanced == 1) ? mat3(instanceTransform) : mat3(matNormal);
+
     // Send vertex attributes to fragment shader
-    vec4 worldPos = matModel*vec4(vertexPosition, 1.0);
+    vec4 worldPos = model*skinnedPos;
     fragPosition = worldPos.xyz;
     fragTexCoord = vertexTexCoord;
     fragColor = vertexColor;
-    fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
+    fragNormal = normalize(normalMat*skinnedNormal);
     fragPosLightSpace = lightVP * worldPos;
 
     // Compute TBN matrix for normal mapping
-    vec3 T = normalize(vec3(matModel*vec4(vertexTangent.xyz, 0.0)));
+    vec3 T = normalize(vec3(model*vec4(skinnedTangent, 0.0)));
     vec3 N = fragNormal;
     T = normalize(T - dot(T, N)*N); // re-orthogonalize
     vec3 B = cross(N, T) * vertexTangent.w;
     fragTBN = mat3(T, B, N);
 
     // Calculate final vertex position
-    gl_Position = mvp*vec4(vertexPosition, 1.0);
+    gl_Position = (instanced == 1) ? mvp*worldPos : mvp*skinnedPos;
 }
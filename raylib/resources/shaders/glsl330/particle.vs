@@ -0,0 +1,23 @@
+#version 330
+
+// Per vertex: quad corner in [-1, 1]
+in vec2 vertexCorner;
+// Per instance
+in vec4 instancePosSize;    // xyz = world position, w = half-size
+in vec4 instanceColor;
+
+uniform mat4 mvp;
+uniform vec3 camRight;
+uniform vec3 camUp;
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    // Camera-facing billboard: pos ± right*size ± up*size
+    vec3 offset = (camRight * vertexCorner.x + camUp * vertexCorner.y) * instancePosSize.w;
+    fragTexCoord = vec2(vertexCorner.x * 0.5 + 0.5, 0.5 - vertexCorner.y * 0.5);
+    fragColor = instanceColor;
+    gl_Position = mvp * vec4(instancePosSize.xyz + offset, 1.0);
+}
@@ -1,10 +1,27 @@
 #version 330
 
 in vec3 vertexPosition;
+in vec4 vertexBoneIds;
+in vec4 vertexBoneWeights;
+in mat4 instanceTransform;
 
 uniform mat4 mvp;
+uniform int instanced;      // 1 = DrawMeshInstanced (see lighting.vs)
+uniform int skinned;        // 1 = posed unit mesh (see lighting.vs)
+
+// Same skinning as lighting.vs so shadows follow the animated pose
+#define MAX_BONE_NUM 128
+uniform mat4 boneMatrices[MAX_BONE_NUM];
 
 void main()
 {
-    gl_Position = mvp * vec4(vertexPosition, 1.0);
+    vec4 pos = vec4(vertexPosition, 1.0);
+    if (skinned == 1) {
+        pos = vertexBoneWeights.x*(boneMatrices[int(vertexBoneIds.x)]*pos) +
+              vertexBoneWeights.y*(boneMatrices[int(vertexBoneIds.y)]*pos) +
+              vertexBoneWeights.z*(boneMatrices[int(vertexBoneIds.z)]*pos) +
+              vertexBoneWeights.w*(boneMatrices[int(vertexBoneIds.w)]*pos);
+    }
+    if (instanced == 1) pos = instanceTransform * pos;
+    gl_Position = mvp * pos;
 }
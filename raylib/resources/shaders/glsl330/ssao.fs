@@ -5,7 +5,9 @@ out vec4 finalColor;
 
 uniform sampler2D texture0;      // scene color
 uniform sampler2D texture1;      // scene depth
-uniform vec2 resolution;
+uniform sampler2D texture2;      // AO from ssao_ao.fs at aoResolution
+uniform vec2 aoResolution;
+uniform int aoEnabled;           // 0 = preset "off"
 uniform float near;              // camera near plane
 uniform float far;               // camera far plane
 
@@ -14,6 +16,26 @@ float linearizeDepth(float d) {
     return near * far / (far - d * (far - near));
 }
 
+// Depth-aware upsample: the four AO texels around uv, bilinear weights scaled down
+// by how far each texel's depth is from this pixel's, so AO doesn't bleed across edges
+float upsampleAO(vec2 uv, float linDepth) {
+    vec2 p = uv * aoResolution - 0.5;
+    vec2 base = floor(p);
+    vec2 f = p - base;
+    float sum = 0.0, wsum = 0.0;
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            vec2 texelUV = (base + vec2(i, j) + 0.5) / aoResolution;
+            float bw = (i == 0 ? 1.0 - f.x : f.x) * (j == 0 ? 1.0 - f.y : f.y);
+            float dz = abs(linearizeDepth(texture(texture1, texelUV).r) - linDepth);
+            float w = bw / (0.05 + dz);
+            sum += texture(texture2, texelUV).r * w;
+            wsum += w;
+        }
+    }
+    return wsum > 0.0 ? sum / wsum : 1.0;
+}
+
 void main() {
     vec4 sceneColor = texture(texture0, fragTexCoord);
     float depth = texture(texture1, fragTexCoord).r;
@@ -25,32 +47,7 @@ void main() {
         return;
     }
 
-    // Sample offsets in screen space (small radius for performance)
-    float radius = 3.0 / resolution.y;  // ~3 pixels
-    float occlusion = 0.0;
-    const int samples = 8;
-    // Fixed sample directions (no noise texture needed)
-    vec2 offsets[8] = vec2[](
-        vec2( 1.0,  0.0), vec2(-1.0,  0.0),
-        vec2( 0.0,  1.0), vec2( 0.0, -1.0),
-        vec2( 0.707,  0.707), vec2(-0.707,  0.707),
-        vec2( 0.707, -0.707), vec2(-0.707, -0.707)
-    );
-
-    for (int i = 0; i < samples; i++) {
-        vec2 sampleUV = fragTexCoord + offsets[i] * radius;
-        float sampleDepth = linearizeDepth(texture(texture1, sampleUV).r);
-
-        // If neighbor is closer to camera, this pixel is occluded
-        float diff = linDepth - sampleDepth;
-        // Only count occlusion within a range to avoid halos
-        if (diff > 0.1 && diff < 8.0) {
-            occlusion += 1.0;
-        }
-    }
-
-    occlusion = occlusion / float(samples);
-    float ao = 1.0 - occlusion * 0.6;  // strength factor
+    float ao = (aoEnabled == 1) ? upsampleAO(fragTexCoord, linDepth) : 1.0;
 
     vec3 color = sceneColor.rgb * ao;
 
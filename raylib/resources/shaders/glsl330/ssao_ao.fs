@@ -0,0 +1,94 @@
+#version 330
+
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+uniform sampler2D texture0;      // scene depth (full resolution)
+uniform sampler2D texture1;      // last frame's output (temporal presets): AO + packed depth
+uniform vec2 resolution;         // scene resolution
+uniform vec2 aoResolution;       // this target's resolution (scene / divisor)
+uniform float near;              // camera near plane
+uniform float far;               // camera far plane
+uniform float jitter;            // sample pattern rotation, varied per frame when temporal
+uniform int temporal;            // 1 = blend with reprojected history
+uniform mat4 invViewProj;        // this frame's scene camera, inverted
+uniform mat4 prevViewProj;       // last frame's scene camera
+
+// Linearize depth from depth buffer [0,1] to view-space distance
+float linearizeDepth(float d) {
+    return near * far / (far - d * (far - near));
+}
+
+// View depth / far in two 8-bit channels (g = coarse, b = fine) so history can be
+// checked against the depth it was computed at
+vec2 packDepth(float linDepth) {
+    float d = clamp(linDepth / far, 0.0, 1.0) * 255.0;
+    return vec2(floor(d) / 255.0, fract(d));
+}
+
+float unpackDepth(vec2 p) {
+    return (p.x + p.y / 255.0) * far;
+}
+
+void main() {
+    // Address by framebuffer position so AO texel uv == scene uv in the composite
+    vec2 uv = gl_FragCoord.xy / aoResolution;
+    float depth = texture(texture0, uv).r;
+
+    // Skip SSAO for sky / far pixels
+    if (depth > 0.999) {
+        finalColor = vec4(1.0, packDepth(far), 1.0);
+        return;
+    }
+    float linDepth = linearizeDepth(depth);
+
+    // Same pattern and radius as the full-resolution pass, in scene pixels
+    float radius = 3.0 / resolution.y;  // ~3 pixels
+    float occlusion = 0.0;
+    const int samples = 8;
+    vec2 offsets[8] = vec2[](
+        vec2( 1.0,  0.0), vec2(-1.0,  0.0),
+        vec2( 0.0,  1.0), vec2( 0.0, -1.0),
+        vec2( 0.707,  0.707), vec2(-0.707,  0.707),
+        vec2( 0.707, -0.707), vec2(-0.707, -0.707)
+    );
+    mat2 rot = mat2(cos(jitter), sin(jitter), -sin(jitter), cos(jitter));
+
+    for (int i = 0; i < samples; i++) {
+        vec2 sampleUV = uv + rot * offsets[i] * radius;
+        float sampleDepth = linearizeDepth(texture(texture0, sampleUV).r);
+
+        // If neighbor is closer to camera, this pixel is occluded
+        float diff = linDepth - sampleDepth;
+        // Only count occlusion within a range to avoid halos
+        if (diff > 0.1 && diff < 8.0) {
+            occlusion += 1.0;
+        }
+    }
+
+    occlusion = occlusion / float(samples);
+    float ao = 1.0 - occlusion * 0.6;  // strength factor
+
+    // Temporal: reproject this pixel into last frame and accumulate the rotated patterns.
+    // History is only trusted where last frame saw the same surface — if the depth it
+    // stored differs from where this point should have been, it was hidden (or the
+    // pixel belonged to a unit that has since moved), so start fresh there.
+    if (temporal == 1) {
+        vec4 world = invViewProj * vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+        world /= world.w;
+        vec4 prevClip = prevViewProj * world;
+        vec3 prevNdc = prevClip.xyz / prevClip.w;
+        vec2 prevUV = prevNdc.xy * 0.5 + 0.5;
+        if (prevUV.x >= 0.0 && prevUV.x <= 1.0 && prevUV.y >= 0.0 && prevUV.y <= 1.0) {
+            // Nearest texel: the packed depth must not be filtered
+            ivec2 texel = min(ivec2(prevUV * aoResolution), ivec2(aoResolution) - 1);
+            vec4 history = texelFetch(texture1, texel, 0);
+            float expected = linearizeDepth(prevNdc.z * 0.5 + 0.5);
+            float stored = unpackDepth(history.gb);
+            if (abs(stored - expected) < 0.05 * expected + 0.1)
+                ao = mix(history.r, ao, 0.25);
+        }
+    }
+
+    finalColor = vec4(ao, packDepth(linDepth), 1.0);
+}
@@ -0,0 +1,257 @@
+// CombatTick microbenchmark — runs canned battles to completion and reports
+// ns/tick, ticks/battle and heap allocations per scenario.
+//
+//   make bench && ./combat_bench [iterations] [--json] [--event]
+//
+// --event also runs every battle with event-driven stepping (CombatNextStep) and
+// reports ticks and ns per battle against fixed stepping, plus how many battles
+// kept their winner. Event timings include the CombatNextStep calls.
+//
+// Every scenario is seeded, so two runs on the same commit simulate identical
+// battles and the numbers can be compared across commits.
+#include "../raylib/combat_sim.h"
+#include "../raylib/helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_ITERS 200
+#define BENCH_DT            (1.0f / 60.0f)
+#define BENCH_MAX_TICKS     (60 * 180)   // 3 minute cap so a stalemate can't hang the run
+#define BENCH_EVENT_MAX_STEP 0.5f        // same cap the server would use (COMBAT_MAX_STEP)
+
+//------------------------------------------------------------------------------------
+// Allocation counting (linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc)
+//------------------------------------------------------------------------------------
+static long allocCount = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+void *__wrap_malloc(size_t size)            { allocCount++; return __real_malloc(size); }
+void *__wrap_calloc(size_t n, size_t size)  { allocCount++; return __real_calloc(n, size); }
+void *__wrap_realloc(void *p, size_t size)  { allocCount++; return __real_realloc(p, size); }
+
+//------------------------------------------------------------------------------------
+// Scenario setup
+//------------------------------------------------------------------------------------
+typedef void (*ScenarioSetup)(CombatArena *arena);
+
+typedef struct {
+    const char *name;
+    ScenarioSetup setup;
+} Scenario;
+
+// SpawnUnit caps blue at BLUE_TEAM_MAX_SIZE, so spawn as red and flip for big boards
+static Unit *add_unit(CombatArena *a, int type, Team team, float x, float z)
+{
+    if (!SpawnUnit(a->units, &a->unitCount, type, TEAM_RED)) return NULL;
+    Unit *u = &a->units[a->unitCount - 1];
+    u->team = team;
+    u->facingAngle = (team == TEAM_BLUE) ? 180.0f : 0.0f;
+    u->position = (Vector3){ x, 0.0f, z };
+    return u;
+}
+
+// n units per side in mirrored rows
+static void add_lines(CombatArena *a, int n)
+{
+    for (int i = 0; i < n; i++) {
+        float x = -80.0f + 160.0f * ((float)(i % 8) + 0.5f) / 8.0f;
+        float z = 25.0f + 10.0f * (float)(i / 8);
+        int type = VALID_UNIT_TYPES[RngRange(&a->rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
+        add_unit(a, type, TEAM_BLUE, x, z);
+        type = VALID_UNIT_TYPES[RngRange(&a->rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
+        add_unit(a, type, TEAM_RED, x, -z);
+    }
+}
+
+static void setup_melee_4v4(CombatArena *a)
+{
+    add_lines(a, 4);
+}
+
+static void setup_all_abilities_4v4(CombatArena *a)
+{
+    add_lines(a, 4);
+    // Walk every ability across the 32 slots, all at max level
+    int id = 0;
+    for (int i = 0; i < a->unitCount; i++) {
+        for (int s = 0; s < MAX_ABILITIES_PER_UNIT; s++) {
+            a->units[i].abilities[s].abilityId = id;
+            a->units[i].abilities[s].level = ABILITY_MAX_LEVELS - 1;
+            id = (id + 1) % ABILITY_COUNT;
+        }
+    }
+}
+
+static void setup_pve_wave(CombatArena *a)
+{
+    for (int i = 0; i < BLUE_TEAM_MAX_SIZE; i++) {
+        Unit *u = add_unit(a, VALID_UNIT_TYPES[i % VALID_UNIT_TYPE_COUNT], TEAM_BLUE,
+                           -60.0f + 40.0f * (float)i, 40.0f);
+        if (u) AssignRandomAbilities(&a->rng, u, 2);
+    }
+    // Late infinite-scaling round so SpawnWave fields a full MAX_WAVE_ENEMIES
+    SpawnWave(&a->rng, a->units, &a->unitCount, TOTAL_ROUNDS + 20, 0);
+}
+
+static void setup_full_board(CombatArena *a)
+{
+    add_lines(a, MAX_UNITS / 2);
+    for (int i = 0; i < a->unitCount; i++)
+        AssignRandomAbilities(&a->rng, &a->units[i], RngRange(&a->rng, 0, 2));
+}
+
+static void setup_projectile_storm(CombatArena *a)
+{
+    add_lines(a, 4);
+    const int ids[MAX_ABILITIES_PER_UNIT] = { ABILITY_CHAIN_FROST, ABILITY_MAELSTROM,
+                                              ABILITY_MAGIC_MISSILE, ABILITY_CHAIN_FROST };
+    for (int i = 0; i < a->unitCount; i++) {
+        for (int s = 0; s < MAX_ABILITIES_PER_UNIT; s++) {
+            a->units[i].abilities[s].abilityId = ids[s];
+            a->units[i].abilities[s].level = ABILITY_MAX_LEVELS - 1;
+        }
+    }
+}
+
+static const Scenario SCENARIOS[] = {
+    { "melee_4v4",         setup_melee_4v4 },
+    { "all_abilities_4v4", setup_all_abilities_4v4 },
+    { "pve_wave_8",        setup_pve_wave },
+    { "full_board_64",     setup_full_board },
+    { "projectile_storm",  setup_projectile_storm },
+};
+#define SCENARIO_COUNT (int)(sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+//------------------------------------------------------------------------------------
+// Runner
+//------------------------------------------------------------------------------------
+typedef struct {
+    double seconds;      // time inside CombatTick only
+    long ticks;
+    long battles;
+    long allocs;
+    int results[4];      // 0 = timed out, 1 = blue, 2 = red, 3 = draw
+} BenchResult;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// event: step with CombatNextStep instead of BENCH_DT. winners (may be NULL) gets
+// each iteration's result.
+static BenchResult run_scenario(const Scenario *sc, int iters, bool event, int *winners)
+{
+    static CombatArena arena;
+    BenchResult r = { 0 };
+    for (int it = 0; it < iters; it++) {
+        memset(&arena, 0, sizeof(arena));
+        RngSeed(&arena.rng, (uint64_t)it);
+        sc->setup(&arena);
+        ApplyRarityBuffs(arena.units, arena.unitCount);
+        ApplySynergies(arena.units, arena.unitCount);
+        CombatArenaBegin(&arena);
+
+        long allocsBefore = allocCount;
+        int result = 0;
+        double t0 = now_seconds();
+        if (event) {
+            while (!result && arena.simTime < BENCH_MAX_TICKS * BENCH_DT) {
+                float step = CombatNextStep(arena.units, arena.unitCount, arena.modifiers, &arena.projectiles,
+                                            arena.fissures, BENCH_DT, BENCH_EVENT_MAX_STEP);
+                result = CombatArenaTick(&arena, step, NULL);
+            }
+        } else {
+            while (!result && arena.tickCount < BENCH_MAX_TICKS)
+                result = CombatArenaTick(&arena, BENCH_DT, NULL);
+        }
+        r.seconds += now_seconds() - t0;
+        r.allocs += allocCount - allocsBefore;
+        r.ticks += arena.tickCount;
+        r.battles++;
+        r.results[result]++;
+        if (winners) winners[it] = result;
+    }
+    return r;
+}
+
+// Fixed vs event-driven stepping on the same battles
+static void run_event_comparison(int iters, bool json)
+{
+    int *fixedWinners = malloc(iters * sizeof(int));
+    int *eventWinners = malloc(iters * sizeof(int));
+    if (json) printf("{\n  \"iterations\": %d,\n  \"dt\": %.6f,\n  \"max_step\": %.3f,\n  \"scenarios\": [\n",
+                     iters, BENCH_DT, BENCH_EVENT_MAX_STEP);
+    else printf("%-20s %14s %14s %14s %14s %8s %8s\n", "scenario", "fixed ticks/b", "event ticks/b",
+                "fixed ns/b", "event ns/b", "speedup", "same win");
+
+    for (int s = 0; s < SCENARIO_COUNT; s++) {
+        BenchResult f = run_scenario(&SCENARIOS[s], iters, false, fixedWinners);
+        BenchResult e = run_scenario(&SCENARIOS[s], iters, true, eventWinners);
+        int same = 0;
+        for (int it = 0; it < iters; it++) same += fixedWinners[it] == eventWinners[it];
+        double fixedNs = f.seconds * 1e9 / (double)f.battles, eventNs = e.seconds * 1e9 / (double)e.battles;
+        double fixedTicks = (double)f.ticks / (double)f.battles, eventTicks = (double)e.ticks / (double)e.battles;
+        double speedup = eventNs > 0 ? fixedNs / eventNs : 0.0;
+        if (json) {
+            printf("    { \"name\": \"%s\", \"fixed_ticks_per_battle\": %.1f, \"event_ticks_per_battle\": %.1f, "
+                   "\"fixed_ns_per_battle\": %.0f, \"event_ns_per_battle\": %.0f, \"speedup\": %.2f, "
+                   "\"same_winner\": %d }%s\n",
+                   SCENARIOS[s].name, fixedTicks, eventTicks, fixedNs, eventNs, speedup, same,
+                   (s + 1 < SCENARIO_COUNT) ? "," : "");
+        } else {
+            printf("%-20s %14.1f %14.1f %14.0f %14.0f %7.2fx %4d/%-4d\n", SCENARIOS[s].name,
+                   fixedTicks, eventTicks, fixedNs, eventNs, speedup, same, iters);
+        }
+    }
+    if (json) printf("  ]\n}\n");
+    free(fixedWinners);
+    free(eventWinners);
+}
+
+int main(int argc, char *argv[])
+{
+    int iters = BENCH_DEFAULT_ITERS;
+    bool json = false, event = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) json = true;
+        else if (strcmp(argv[i], "--event") == 0) event = true;
+        else iters = atoi(argv[i]);
+    }
+    if (iters < 1) iters = 1;
+    if (event) {
+        run_event_comparison(iters, json);
+        return 0;
+    }
+
+    if (json) printf("{\n  \"iterations\": %d,\n  \"dt\": %.6f,\n  \"scenarios\": [\n", iters, BENCH_DT);
+    else printf("%-20s %10s %12s %10s %8s   blue/red/draw/timeout\n",
+                "scenario", "ns/tick", "ticks/battle", "ms/battle", "allocs");
+
+    for (int s = 0; s < SCENARIO_COUNT; s++) {
+        BenchResult r = run_scenario(&SCENARIOS[s], iters, false, NULL);
+        double nsPerTick = r.ticks ? r.seconds * 1e9 / (double)r.ticks : 0.0;
+        double ticksPerBattle = (double)r.ticks / (double)r.battles;
+        double msPerBattle = r.seconds * 1e3 / (double)r.battles;
+        if (json) {
+            printf("    { \"name\": \"%s\", \"ns_per_tick\": %.1f, \"ticks_per_battle\": %.1f, "
+                   "\"ms_per_battle\": %.3f, \"allocs\": %ld, "
+                   "\"blue\": %d, \"red\": %d, \"draw\": %d, \"timeout\": %d }%s\n",
+                   SCENARIOS[s].name, nsPerTick, ticksPerBattle, msPerBattle, r.allocs,
+                   r.results[1], r.results[2], r.results[3], r.results[0],
+                   (s + 1 < SCENARIO_COUNT) ? "," : "");
+        } else {
+            printf("%-20s %10.1f %12.1f %10.3f %8ld   %d/%d/%d/%d\n",
+                   SCENARIOS[s].name, nsPerTick, ticksPerBattle, msPerBattle, r.allocs,
+                   r.results[1], r.results[2], r.results[3], r.results[0]);
+        }
+    }
+    if (json) printf("  ]\n}\n");
+    return 0;
+}
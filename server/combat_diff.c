@@ -0,0 +1,322 @@
+// Differential sim harness — runs the reference CombatTick and a candidate
+// stepping strategy side by side on seeded random battles, hashing both states
+// every tick and reporting the first diverging tick and field.
+//
+//   make difftest
+//   ./combat_diff [battles] [--candidate fixed|rollback|event] [--stop]
+//   ./combat_diff [battles] --record trace.bin   (on the known-good build)
+//   ./combat_diff [battles] --check trace.bin    (on the build under test)
+//
+// --record/--check compare the reference sim across two builds: the trace holds
+// per-tick state hashes, so the check names the battle, tick and section that
+// changed. To test a new sim in-process, add it to CANDIDATES below.
+//
+// Exact candidates must match the reference bit for bit. Approximate ones (event
+// stepping rounds differently every jump) are judged on the finished battles instead:
+// final HP and position error per unit and the share of battles whose winner changed.
+// Battles are chaotic — stretching or shrinking the fixed step by a rounding-sized
+// DIFF_NOISE_DT moves timer expiries by a tick and already flips some winners — so
+// each metric is held against that noise floor (both signs pooled, same battles)
+// times DIFF_TOL_NOISE_FACTOR.
+#include "../raylib/combat_sim.h"
+#include "../raylib/helpers.h"
+#include "../raylib/synergies.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DIFF_DEFAULT_BATTLES 200
+#define DIFF_DT              (1.0f / 60.0f)
+#define DIFF_MAX_TICKS       (60 * 180)
+#define DIFF_TIME_EPS        (DIFF_DT * 0.25f)
+#define DIFF_EVENT_MAX_STEP  0.5f
+#define DIFF_ROLLBACK_TICKS  20     // rollback candidate rewinds this far
+#define DIFF_NOISE_DT        1e-5f  // noise-floor battles step at DIFF_DT * (1 +/- this)
+#define DIFF_TOL_NOISE_FACTOR 2.0f  // approximate candidates may err this much more than noise
+
+//------------------------------------------------------------------------------------
+// Candidates — advance the arena to (at least) targetTime
+//------------------------------------------------------------------------------------
+typedef int (*CandidateAdvance)(CombatArena *arena, float targetTime);
+
+// Plain fixed step — must always match; catches nondeterminism
+static int advance_fixed(CombatArena *arena, float targetTime)
+{
+    (void)targetTime;
+    return CombatArenaTick(arena, DIFF_DT, NULL);
+}
+
+// Fixed step with every tick pushed into a CombatHistory; every DIFF_ROLLBACK_TICKS
+// ticks it rewinds that far, re-simulates and checks it lands on the same state
+static int advance_rollback(CombatArena *arena, float targetTime)
+{
+    (void)targetTime;
+    static CombatArena frames[DIFF_ROLLBACK_TICKS + 1], live;
+    static CombatHistory history;
+    if (arena->tickCount == 0) {
+        CombatHistoryInit(&history, frames, DIFF_ROLLBACK_TICKS + 1);
+        CombatHistoryPush(&history, arena);
+    }
+    int result = CombatArenaTick(arena, DIFF_DT, NULL);
+    CombatHistoryPush(&history, arena);
+    if (arena->tickCount % DIFF_ROLLBACK_TICKS != 0) return result;
+
+    live = *arena;
+    if (!CombatHistoryRewind(&history, DIFF_ROLLBACK_TICKS, arena)) {
+        printf("  rollback: history missing at tick %d\n", live.tickCount);
+        *arena = live;
+        return result;
+    }
+    int replayed = 0;
+    for (int k = 0; k < DIFF_ROLLBACK_TICKS && !replayed; k++) {
+        replayed = CombatArenaTick(arena, DIFF_DT, NULL);
+        CombatHistoryPush(&history, arena);
+    }
+    char why[160];
+    if (replayed != result || DiffCombatState(&live, arena, why, sizeof(why)))
+        printf("  rollback replay of ticks %d-%d differs: %s\n", live.tickCount - DIFF_ROLLBACK_TICKS + 1,
+               live.tickCount, replayed != result ? "battle result" : why);
+    return result;
+}
+
+// Event-driven stepping (CombatNextStep) — only comparable when it lands on targetTime
+static int advance_event(CombatArena *arena, float targetTime)
+{
+    int result = 0;
+    while (!result) {
+        float step = CombatNextStep(arena->units, arena->unitCount, arena->modifiers,
+                                    &arena->projectiles, arena->fissures, DIFF_DT, DIFF_EVENT_MAX_STEP);
+        if (arena->simTime + step > targetTime + DIFF_TIME_EPS) break;
+        result = CombatArenaTick(arena, step, NULL);
+    }
+    return result;
+}
+
+typedef struct {
+    const char *name;
+    CandidateAdvance advance;
+    bool exact;             // false: judged on final-state tolerance, not per-tick hashes
+} Candidate;
+
+static const Candidate CANDIDATES[] = {
+    { "fixed",    advance_fixed,    true },
+    { "rollback", advance_rollback, true },
+    { "event",    advance_event,    false },
+};
+#define CANDIDATE_COUNT (int)(sizeof(CANDIDATES) / sizeof(CANDIDATES[0]))
+
+//------------------------------------------------------------------------------------
+// Battles
+//------------------------------------------------------------------------------------
+static void setup_battle(CombatArena *arena, int seed)
+{
+    memset(arena, 0, sizeof(*arena));
+    RngSeed(&arena->rng, (uint64_t)seed);
+    Rng *rng = &arena->rng;
+    for (int k = 0; k < BLUE_TEAM_MAX_SIZE; k++) {
+        int type = VALID_UNIT_TYPES[RngRange(rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
+        if (!SpawnUnit(arena->units, &arena->unitCount, type, TEAM_BLUE)) continue;
+        Unit *u = &arena->units[arena->unitCount - 1];
+        u->position = (Vector3){ (float)RngRange(rng, -80, 80), 0.0f, (float)RngRange(rng, 20, 80) };
+        AssignRandomAbilities(rng, u, RngRange(rng, 0, MAX_ABILITIES_PER_UNIT));
+    }
+    SpawnWave(rng, arena->units, &arena->unitCount, RngRange(rng, 0, TOTAL_ROUNDS + 6), 0);
+    ApplyRarityBuffs(arena->units, arena->unitCount);
+    ApplySynergies(arena->units, arena->unitCount);
+    CombatArenaBegin(arena);
+}
+
+static const char *first_section(CombatStateHash a, CombatStateHash b)
+{
+    if (a.units != b.units) return "units";
+    if (a.modifiers != b.modifiers) return "modifiers";
+    if (a.projectiles != b.projectiles) return "projectiles";
+    if (a.fissures != b.fissures) return "fissures";
+    return "none";
+}
+
+//------------------------------------------------------------------------------------
+// Final-state tolerance
+//------------------------------------------------------------------------------------
+typedef struct {
+    int battles, winnerChanges;
+    int hpUnits, posUnits;
+    double hpErrSum, posErrSum;
+    float hpErrMax, posErrMax;
+} ToleranceStats;
+
+static void compare_final(const CombatArena *ref, const CombatArena *cand, int refResult, int candResult,
+                          ToleranceStats *t)
+{
+    t->battles++;
+    if (refResult != candResult) t->winnerChanges++;
+    int count = ref->unitCount < cand->unitCount ? ref->unitCount : cand->unitCount;
+    for (int i = 0; i < count; i++) {
+        const Unit *a = &ref->units[i], *b = &cand->units[i];
+        float maxHP = UNIT_STATS[a->typeIndex].health * a->hpMultiplier;
+        float hpA = a->active ? fmaxf(a->currentHealth, 0.0f) : 0.0f;
+        float hpB = b->active ? fmaxf(b->currentHealth, 0.0f) : 0.0f;
+        float hpErr = maxHP > 0 ? fabsf(hpA - hpB) / maxHP : 0.0f;
+        t->hpErrSum += hpErr;
+        t->hpErrMax = fmaxf(t->hpErrMax, hpErr);
+        t->hpUnits++;
+        if (a->active && b->active) {
+            float posErr = DistXZ(a->position, b->position);
+            t->posErrSum += posErr;
+            t->posErrMax = fmaxf(t->posErrMax, posErr);
+            t->posUnits++;
+        }
+    }
+}
+
+static float winner_rate(const ToleranceStats *t) { return t->battles ? (float)t->winnerChanges / t->battles : 0.0f; }
+static float hp_mean(const ToleranceStats *t) { return t->hpUnits ? (float)(t->hpErrSum / t->hpUnits) : 0.0f; }
+static float pos_mean(const ToleranceStats *t) { return t->posUnits ? (float)(t->posErrSum / t->posUnits) : 0.0f; }
+
+// Prints candidate vs noise floor; true when every mean is within the noise limit
+static bool report_tolerance(const ToleranceStats *t, const ToleranceStats *noise)
+{
+    float k = DIFF_TOL_NOISE_FACTOR;
+    // At least one changed winner is always allowed so tiny runs aren't decided by luck
+    float winnerLimit = fmaxf(winner_rate(noise) * k, noise->battles ? 1.0f / noise->battles : 0.0f);
+    bool winnerOk = winner_rate(t) <= winnerLimit;
+    bool hpOk = hp_mean(t) <= hp_mean(noise) * k;
+    bool posOk = pos_mean(t) <= pos_mean(noise) * k;
+    printf("  %-22s %10s %10s %10s\n", "", "candidate", "noise", "limit");
+    printf("  %-22s %9.1f%% %9.1f%% %9.1f%%  %s\n", "winner changed", winner_rate(t) * 100.0f,
+           winner_rate(noise) * 100.0f, winnerLimit * 100.0f, winnerOk ? "ok" : "FAIL");
+    printf("  %-22s %9.2f%% %9.2f%% %9.2f%%  %s\n", "final HP error (mean)", hp_mean(t) * 100.0f,
+           hp_mean(noise) * 100.0f, hp_mean(noise) * k * 100.0f, hpOk ? "ok" : "FAIL");
+    printf("  %-22s %9.1f%% %9.1f%%\n", "final HP error (max)", t->hpErrMax * 100.0f, noise->hpErrMax * 100.0f);
+    printf("  %-22s %10.2f %10.2f %10.2f  %s\n", "final pos error (mean)", pos_mean(t), pos_mean(noise),
+           pos_mean(noise) * k, posOk ? "ok" : "FAIL");
+    printf("  %-22s %10.1f %10.1f\n", "final pos error (max)", t->posErrMax, noise->posErrMax);
+    bool pass = winnerOk && hpOk && posOk;
+    printf("  tolerance %s\n", pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+typedef struct {
+    int battle;
+    int tick;
+    CombatStateHash hash;
+} TraceRecord;
+
+// Next trace record for this battle; leaves the stream on the next battle otherwise
+static bool read_trace(FILE *trace, int battle, TraceRecord *rec)
+{
+    long pos = ftell(trace);
+    if (fread(rec, sizeof(*rec), 1, trace) != 1) return false;
+    if (rec->battle == battle) return true;
+    fseek(trace, pos, SEEK_SET);
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    int battles = DIFF_DEFAULT_BATTLES;
+    const Candidate *cand = &CANDIDATES[0];
+    const char *recordPath = NULL, *checkPath = NULL;
+    bool stopOnFirst = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stop") == 0) stopOnFirst = true;
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) checkPath = argv[++i];
+        else if (strcmp(argv[i], "--candidate") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            cand = NULL;
+            for (int c = 0; c < CANDIDATE_COUNT; c++)
+                if (strcmp(CANDIDATES[c].name, name) == 0) cand = &CANDIDATES[c];
+            if (!cand) { fprintf(stderr, "unknown candidate '%s'\n", name); return 2; }
+        }
+        else battles = atoi(argv[i]);
+    }
+
+    FILE *trace = NULL;
+    if (recordPath && !(trace = fopen(recordPath, "wb"))) { perror(recordPath); return 2; }
+    if (checkPath && !(trace = fopen(checkPath, "rb"))) { perror(checkPath); return 2; }
+
+    static CombatArena ref, cand_state, noise[2];
+    int diverged = 0, outcomeDiffs = 0;
+    long ticks = 0, candTicks = 0;
+    ToleranceStats tol = { 0 }, noiseTol = { 0 };
+    for (int b = 0; b < battles; b++) {
+        setup_battle(&ref, b);
+        cand_state = ref;
+        noise[0] = noise[1] = ref;
+        int refResult = 0, candResult = 0;
+        bool reported = false;
+        while (!refResult && ref.tickCount < DIFF_MAX_TICKS) {
+            refResult = CombatArenaTick(&ref, DIFF_DT, NULL);
+            float target = ref.tickCount * DIFF_DT;
+            if (!candResult) candResult = cand->advance(&cand_state, target);
+            CombatStateHash hr = HashCombatState(&ref);
+            ticks++;
+
+            if (trace) {
+                TraceRecord rec = { b, ref.tickCount, hr };
+                if (recordPath) {
+                    fwrite(&rec, sizeof(rec), 1, trace);
+                } else if (!reported) {
+                    TraceRecord want;
+                    if (!read_trace(trace, b, &want)) {
+                        printf("battle %d tick %d: trace battle already ended\n", b, ref.tickCount);
+                        diverged++; reported = true;
+                        if (stopOnFirst) goto done;
+                    } else if (want.hash.all != hr.all) {
+                        printf("battle %d tick %d: %s differ from trace\n", b, ref.tickCount, first_section(want.hash, hr));
+                        diverged++; reported = true;
+                        if (stopOnFirst) goto done;
+                    }
+                }
+                continue;
+            }
+
+            // Candidate only comparable when it sits on the same sim time
+            if (reported || candResult || fabsf(cand_state.simTime - target) > DIFF_TIME_EPS) continue;
+            CombatStateHash hc = HashCombatState(&cand_state);
+            if (hc.all != hr.all) {
+                char why[160];
+                DiffCombatState(&ref, &cand_state, why, sizeof(why));
+                if (cand->exact) printf("battle %d tick %d (t=%.3fs): %s\n", b, ref.tickCount, target, why);
+                diverged++; reported = true;
+                if (stopOnFirst) goto done;
+            }
+        }
+        // Skip trace records left over when this build ended the battle early
+        if (checkPath) {
+            TraceRecord want;
+            bool leftover = false;
+            while (read_trace(trace, b, &want)) leftover = true;
+            if (leftover && !reported) {
+                printf("battle %d: ended at tick %d, trace continues to tick %d\n", b, ref.tickCount, want.tick);
+                diverged++;
+                if (stopOnFirst) goto done;
+            }
+        }
+        if (!trace) {
+            // Let the candidate finish so outcomes can be compared too
+            while (!candResult && cand_state.tickCount < DIFF_MAX_TICKS * 4)
+                candResult = cand->advance(&cand_state, cand_state.simTime + DIFF_EVENT_MAX_STEP);
+            if (candResult != refResult) outcomeDiffs++;
+            candTicks += cand_state.tickCount;
+            compare_final(&ref, &cand_state, refResult, candResult, &tol);
+            for (int n = 0; n < 2 && !cand->exact; n++) {
+                float dt = DIFF_DT * (n ? 1.0f + DIFF_NOISE_DT : 1.0f - DIFF_NOISE_DT);
+                int noiseResult = 0;
+                while (!noiseResult && noise[n].tickCount < DIFF_MAX_TICKS)
+                    noiseResult = CombatArenaTick(&noise[n], dt, NULL);
+                compare_final(&ref, &noise[n], refResult, noiseResult, &noiseTol);
+            }
+        }
+    }
+done:
+    if (trace) fclose(trace);
+    if (recordPath) printf("recorded %d battles, %ld ticks -> %s\n", battles, ticks, recordPath);
+    else if (checkPath) printf("%d/%d battles diverge from %s\n", diverged, battles, checkPath);
+    else printf("candidate '%s': %d/%d battles diverge, %d different outcomes (%ld reference ticks, %ld candidate)\n",
+                cand->name, diverged, battles, outcomeDiffs, ticks, candTicks);
+    if (trace || cand->exact) return diverged ? 1 : 0;
+    return report_tolerance(&tol, &noiseTol) ? 0 : 1;
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/socket.h>
@@ -13,15 +14,15 @@
 //------------------------------------------------------------------------------------
 // Internal helpers
 //------------------------------------------------------------------------------------
-static void generate_lobby_code(char code[LOBBY_CODE_LEN + 1])
+static void generate_lobby_code(Rng *rng, char code[LOBBY_CODE_LEN + 1])
 {
     const char chars[] = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789"; // no ambiguous chars
     for (int i = 0; i < LOBBY_CODE_LEN; i++)
-        code[i] = chars[rand() % (sizeof(chars) - 1)];
+        code[i] = chars[RngRange(rng, 0, (int)sizeof(chars) - 2)];
     code[LOBBY_CODE_LEN] = '\0';
 }
 
-static void setup_pve_enemies(Unit combatUnits[], int *combatUnitCount,
+static void setup_pve_enemies(Rng *rng, Unit combatUnits[], int *combatUnitCount,
                               const Unit playerUnits[], int playerUnitCount,
                               int waveIndex)
 {
@@ -44,7 +45,7 @@ static void setup_pve_enemies(Unit combatUnits[], int *combatUnitCount,
     *combatUnitCount = count;
 
     // Use the solo wave system for red PVE enemies
-    SpawnWave(combatUnits, combatUnitCount, waveIndex, 2);
+    SpawnWave(rng, combatUnits, combatUnitCount, waveIndex, 2);
 }
 
 static void setup_pvp_combat(Unit combatUnits[], int *combatUnitCount,
@@ -104,13 +105,87 @@ static void send_combat_start(GameSession *s, int playerIdx,
                  payload, 2 + count * sizeof(NetUnit));
 }
 
+// Read whatever both players have sent; session_handle_msg ignores what doesn't fit the state
+static void poll_players(GameSession *s)
+{
+    for (int p = 0; p < 2; p++) {
+        if (!s->players[p].connected) continue;
+        NetMessage msg;
+        int r = net_recv_msg_nonblock(s->players[p].sockfd, &msg);
+        if (r == 1) session_handle_msg(s, p, &msg);
+        else if (r < 0) {
+            s->players[p].connected = false;
+            close(s->players[p].sockfd);
+        }
+    }
+}
+
+// Player 0's view is the server's own; player 1 sees their army first, mirrored
+static void begin_streams(GameSession *s)
+{
+    s->streaming = false;
+    s->streamPendingCount = 0;
+    int blueCount = CountTeamUnits(s->combat.units, s->combat.unitCount, TEAM_BLUE);
+    for (int p = 0; p < 2; p++) {
+        s->streamers[p].hz = 0;
+        if (!s->players[p].connected || s->players[p].streamHz <= 0) continue;
+        StreamView view;
+        StreamViewInit(&view, s->combat.unitCount, p == 0 ? 0 : blueCount, p == 1);
+        CombatStreamerBegin(&s->streamers[p], s->players[p].streamHz, &view);
+        s->streaming = true;
+    }
+    if (s->streaming && !s->streamEvents.head && !CombatEventQueueInit(&s->streamEvents)) {
+        printf("[Session %s] Out of memory for the combat stream, clients simulate\n", s->lobbyCode);
+        s->streaming = false;
+        for (int p = 0; p < 2; p++) s->streamers[p].hz = 0;
+    }
+}
+
+// Collect this tick's events, then send each streaming player a snapshot if one is due
+static void send_streams(GameSession *s, bool final)
+{
+    CombatEvent ev;
+    while (CombatEventPop(&s->streamEvents, &ev))
+        if (s->streamPendingCount < STREAM_MAX_EVENTS) s->streamPending[s->streamPendingCount++] = ev;
+
+    bool sent = false;
+    for (int p = 0; p < 2; p++) {
+        CombatStreamer *st = &s->streamers[p];
+        if (!st->hz || !s->players[p].connected) continue;
+        if (!final && !CombatStreamerDue(st, s->combat.simTime)) continue;
+        uint8_t payload[NET_MAX_PAYLOAD];
+        int size = CombatStreamerEncode(st, &s->combat, final, s->streamPending,
+                                        s->streamPendingCount, payload, sizeof(payload));
+        if (size < 0) {
+            printf("[Session %s] Combat snapshot too large for player %d, skipped\n", s->lobbyCode, p);
+            continue;
+        }
+        net_send_msg(s->players[p].sockfd, MSG_COMBAT_SNAPSHOT, payload, (uint16_t)size);
+        sent = true;
+    }
+    // Both players see the same events, so they go out with whichever snapshot is next
+    if (sent) s->streamPendingCount = 0;
+}
+
+static CombatCache *combatCache = NULL;
+
 //------------------------------------------------------------------------------------
 // Public API
 //------------------------------------------------------------------------------------
+void session_set_combat_cache(CombatCache *cache)
+{
+    combatCache = cache;
+}
+
 void session_init(GameSession *s, int player0_sock)
 {
+    static uint64_t sessionSerial = 0;
+    CombatRecorderFree(&s->recorder);   // slot reused after a session died mid-battle
+    CombatEventQueueFree(&s->streamEvents);
     memset(s, 0, sizeof(*s));
-    generate_lobby_code(s->lobbyCode);
+    // Unique stream per session: wall clock plus a serial so same-second sessions differ
+    RngSeed(&s->rng, ((uint64_t)time(NULL) << 20) ^ ++sessionSerial);
+    generate_lobby_code(&s->rng, s->lobbyCode);
     s->state = SESSION_WAITING;
     s->players[0].sockfd = player0_sock;
     s->players[0].connected = true;
@@ -166,7 +241,7 @@ void session_start_prep(GameSession *s)
         if (!s->players[p].connected) continue;
 
         // Free shop roll
-        RollShop(s->players[p].shop, &s->players[p].gold, 0);
+        RollShop(&s->rng, s->players[p].shop, &s->players[p].gold, 0);
 
         // Send prep start: round number, gold
         uint8_t payload[16];
@@ -191,20 +266,46 @@ void session_send_shop(GameSession *s, int playerIdx)
 void session_start_combat(GameSession *s)
 {
     s->state = SESSION_COMBAT;
-    memset(s->combatModifiers, 0, sizeof(s->combatModifiers));
-    memset(s->combatProjectiles, 0, sizeof(s->combatProjectiles));
-    memset(s->combatFissures, 0, sizeof(s->combatFissures));
+    s->combatClock = 0;
 
     // All multiplayer rounds are PVP
     // Server simulates p0=blue vs p1=red
-    setup_pvp_combat(s->combatUnits, &s->combatUnitCount,
+    setup_pvp_combat(s->combat.units, &s->combat.unitCount,
                      s->players[0].units, s->players[0].unitCount,
                      s->players[1].units, s->players[1].unitCount);
-    ApplyRarityBuffs(s->combatUnits, s->combatUnitCount);
-    ApplySynergies(s->combatUnits, s->combatUnitCount);
+    ApplyRarityBuffs(s->combat.units, s->combat.unitCount);
+    ApplySynergies(s->combat.units, s->combat.unitCount);
+    // Fresh per-battle stream from the session rng; replays record it as the seed
+    uint64_t combatSeed = (uint64_t)RngNext(&s->rng) << 32;
+    combatSeed |= RngNext(&s->rng);
+    RngSeed(&s->combat.rng, combatSeed);
+    CombatArenaBegin(&s->combat);
+#ifdef COMBAT_PROFILE
+    CombatProfileReset(&s->combatProf);
+#endif
+    begin_streams(s);
+    // Same armies as a battle already fought: replay its outcome on the same clock.
+    // Streamed battles always simulate — the snapshots need the live state.
+    s->combatKey = CombatCacheKeyFor(&s->combat, COMBAT_EVENT_STEP);
+    s->cachedOutcome = (CombatOutcome){ 0 };
+    if (!s->streaming && combatCache && CombatCacheLookup(combatCache, s->combatKey, &s->cachedOutcome)) {
+        printf("[Session %s] Combat cache hit (%.1fs battle, %llu/%llu hits)\n", s->lobbyCode,
+               s->cachedOutcome.simTime, (unsigned long long)combatCache->hits,
+               (unsigned long long)(combatCache->hits + combatCache->misses));
+    } else {
+        NetUnit netUnits[NET_MAX_UNITS];
+        int netCount = serialize_units(s->combat.units, s->combat.unitCount, netUnits, NET_MAX_UNITS);
+        CombatRecorderBegin(&s->recorder, &s->combat, netUnits, netCount, s->currentRound,
+                            COMBAT_EVENT_STEP ? REPLAY_FLAG_EVENT_STEP : 0, COMBAT_DT, COMBAT_MAX_STEP);
+    }
+#if COMBAT_EVENT_STEP
+    s->combatNextStep = CombatNextStep(s->combat.units, s->combat.unitCount,
+                                       s->combat.modifiers, &s->combat.projectiles,
+                                       s->combat.fissures, COMBAT_DT, COMBAT_MAX_STEP);
+#endif
 
     // Player 0 sees: their army (blue) vs p1 mirror (red)
-    send_combat_start(s, 0, s->combatUnits, s->combatUnitCount);
+    send_combat_start(s, 0, s->combat.units, s->combat.unitCount);
 
     // Player 1 sees: their army (blue) vs p0 mirror (red)
     Unit p1View[MAX_UNITS];
@@ -251,7 +352,7 @@ void session_handle_msg(GameSession *s, int playerIdx, const NetMessage *msg)
         if (s->state != SESSION_PREP) break;
         int rollCost = 2;
         if (player->gold >= rollCost) {
-            RollShop(player->shop, &player->gold, rollCost);
+            RollShop(&s->rng, player->shop, &player->gold, rollCost);
             session_send_shop(s, playerIdx);
             // Send gold update
             uint8_t goldBuf[2] = { (player->gold >> 8) & 0xFF, player->gold & 0xFF };
@@ -325,6 +426,22 @@ void session_handle_msg(GameSession *s, int playerIdx, const NetMessage *msg)
         player->inventory[invSlot].level = oldLv;
     } break;
 
+    case MSG_STREAM_REQUEST: {
+        if (msg->size < 1) break;
+        int hz = msg->payload[0];
+        if (hz > 0 && hz < STREAM_MIN_HZ) hz = STREAM_MIN_HZ;
+        if (hz > STREAM_MAX_HZ) hz = STREAM_MAX_HZ;
+        player->streamHz = hz;
+        printf("[Session %s] Player %d combat: %s\n", s->lobbyCode, playerIdx,
+               hz ? "streamed snapshots" : "local sim");
+    } break;
+
+    case MSG_SNAPSHOT_ACK: {
+        if (s->state != SESSION_COMBAT || msg->size < 2) break;
+        uint16_t seq = (uint16_t)(msg->payload[0] | (msg->payload[1] << 8));
+        CombatStreamerAck(&s->streamers[playerIdx], seq);
+    } break;
+
     default:
         printf("[Session %s] Unknown msg type 0x%02X from player %d\n",
                s->lobbyCode, msg->type, playerIdx);
@@ -369,24 +486,77 @@ int session_tick(GameSession *s, float dt)
         }
 
         // Poll for messages from both players
-        for (int p = 0; p < 2; p++) {
-            if (!s->players[p].connected) continue;
-            NetMessage msg;
-            int r = net_recv_msg_nonblock(s->players[p].sockfd, &msg);
-            if (r == 1) session_handle_msg(s, p, &msg);
-            else if (r < 0) {
-                s->players[p].connected = false;
-                close(s->players[p].sockfd);
-            }
-        }
+        poll_players(s);
     } break;
 
     case SESSION_COMBAT: {
-        // Run headless combat simulation
-        int result = CombatTick(s->combatUnits, s->combatUnitCount,
-                                s->combatModifiers, s->combatProjectiles,
-                                s->combatFissures, COMBAT_DT, NULL, NULL);
+        // Run headless combat simulation, paced to wall-clock so the result
+        // lands when the clients' local battle does
+        int result = 0;
+        s->combatClock += COMBAT_DT;
+        if (s->streaming) poll_players(s);   // snapshot acks
+        CombatEventQueue *events = s->streaming ? &s->streamEvents : NULL;
+        if (s->cachedOutcome.result) {
+            if (s->combatClock >= s->cachedOutcome.simTime) result = s->cachedOutcome.result;
+        } else {
+#ifdef COMBAT_PROFILE
+            CombatProfileBind(&s->combatProf);
+#endif
+#if COMBAT_EVENT_STEP
+            // Nothing changes between events — sit idle until the next one is due,
+            // then cover the whole gap in a single tick
+            while (!result && s->combat.simTime + s->combatNextStep <= s->combatClock + COMBAT_DT * 0.5f) {
+                result = CombatArenaTick(&s->combat, s->combatNextStep, events);
+                CombatRecorderTick(&s->recorder, &s->combat);
+                s->combatNextStep = CombatNextStep(s->combat.units, s->combat.unitCount,
+                                                   s->combat.modifiers, &s->combat.projectiles,
+                                                   s->combat.fissures, COMBAT_DT, COMBAT_MAX_STEP);
+            }
+#else
+            result = CombatArenaTick(&s->combat, COMBAT_DT, events);
+            CombatRecorderTick(&s->recorder, &s->combat);
+#endif
+#ifdef COMBAT_PROFILE
+            CombatProfileBind(NULL);
+#endif
+            if (s->streaming) send_streams(s, result > 0);
+            if (result > 0) {
+                CombatRecorderEnd(&s->recorder, &s->combat, result);
+                bool haveReplay = !s->recorder.failed;
+                if (combatCache) {
+                    CombatOutcome outcome = { result, s->combat.tickCount, s->combat.simTime,
+                                              haveReplay ? s->recorder.data : NULL,
+                                              haveReplay ? s->recorder.size : 0 };
+                    CombatCacheStore(combatCache, s->combatKey, &outcome);
+                }
+                const char *replayDir = COMBAT_REPLAY_DIR;
+                if (replayDir && haveReplay) {
+                    char path[256];
+                    snprintf(path, sizeof(path), "%s/%s_r%d.rpl", replayDir, s->lobbyCode, s->currentRound);
+                    if (!CombatRecorderSave(&s->recorder, path))
+                        printf("[Session %s] Could not write replay %s\n", s->lobbyCode, path);
+                }
+                CombatRecorderFree(&s->recorder);
+            }
+        }
         if (result > 0) {
+            for (int p = 0; p < 2; p++) {
+                const CombatStreamer *st = &s->streamers[p];
+                if (!st->hz) continue;
+                float secs = s->combat.simTime > 0.0f ? s->combat.simTime : 1.0f;
+                printf("[Session %s] Streamed %d snapshots to player %d at %d Hz: %.1f KB, %.0f B/s\n",
+                       s->lobbyCode, st->nextSeq, p, st->hz, (double)st->bytesSent / 1024.0,
+                       (double)st->bytesSent / secs);
+            }
+#ifdef COMBAT_PROFILE
+            char profLine[512];
+            CombatProfileAdd(&s->sessionProf, &s->combatProf);
+            CombatProfileFormat(&s->combatProf, profLine, sizeof(profLine));
+            printf("[Session %s] Combat profile (battle): %s\n", s->lobbyCode, profLine);
+            CombatProfileFormat(&s->sessionProf, profLine, sizeof(profLine));
+            printf("[Session %s] Combat profile (session, %llu battles): %s\n", s->lobbyCode,
+                   (unsigned long long)s->sessionProf.battles, profLine);
+#endif
             int winner = -1; // -1 = draw
             if (result == 1) winner = 0;       // blue wins = player 0
             else if (result == 2) winner = 1;  // red wins = player 1
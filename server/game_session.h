@@ -3,11 +3,25 @@
 #include "../raylib/net_protocol.h"
 #include "../raylib/net_common.h"
 #include "../raylib/pve_waves.h"
+#include "../raylib/combat_sim.h"
+#include "../raylib/combat_prof.h"
+#include "../raylib/combat_cache.h"
+#include "../raylib/combat_replay.h"
+#include "../raylib/combat_stream.h"
 
 //------------------------------------------------------------------------------------
 // Game Session — manages one 1v1 match between two players
 //------------------------------------------------------------------------------------
 #define COMBAT_DT (1.0f / 60.0f)  // headless combat tick rate
+// Event-driven stepping (only tick when the next event is due) stays off for PvP: clients
+// simulate fixed-step and the server's result must match theirs. combat_bench --event
+// measures its cost against fixed stepping and combat_diff --candidate event its outcome
+// tolerance; build with -DCOMBAT_EVENT_STEP=1 to try it here.
+#ifndef COMBAT_EVENT_STEP
+#define COMBAT_EVENT_STEP 0       // 1 = only tick combat when the next event is due (0 = every COMBAT_DT)
+#endif
+#define COMBAT_MAX_STEP 0.5f      // longest single jump in event-driven mode
+#define COMBAT_REPLAY_DIR NULL    // e.g. "replays" to also write every battle to <dir>/<lobby>_r<round>.rpl
 #define MAX_PVP_WINS 3     // best-of-5: first to 3 PVP wins
 #define MAX_ROUNDS 10      // absolute max rounds
 #define PREP_TIMER 45.0f   // seconds before auto-ready
@@ -33,6 +47,8 @@ typedef struct {
     int gold;
     ShopSlot shop[MAX_SHOP_SLOTS];
     InventorySlot inventory[MAX_INVENTORY_SLOTS];
+    // Combat snapshots per second (MSG_STREAM_REQUEST); 0 = client runs its own sim
+    int streamHz;
 } PlayerState;
 
 typedef struct {
@@ -40,21 +56,37 @@ typedef struct {
     char lobbyCode[LOBBY_CODE_LEN + 1];
     PlayerState players[2];
 
+    Rng rng;               // shop rolls, waves, lobby code — never the global rand()
+
     // Round state
     int currentRound;
     int pvpWins[2];        // PVP round wins per player
 
     // Combat state (headless)
-    Unit combatUnits[MAX_UNITS];
-    int combatUnitCount;
-    Modifier combatModifiers[MAX_MODIFIERS];
-    Projectile combatProjectiles[MAX_PROJECTILES];
-    Fissure combatFissures[MAX_FISSURES];
+    CombatArena combat;    // combat.simTime trails combatClock while waiting on an event
+    float combatClock;     // wall-clock combat time (COMBAT_DT per server tick)
+    float combatNextStep;  // cached CombatNextStep() for the current state
+    CombatCacheKey combatKey;   // canonical key of this battle's starting armies
+    CombatOutcome cachedOutcome;// result != 0 = cache hit, battle isn't simulated
+    CombatRecorder recorder;    // replay of the battle being simulated (kept in the cache)
+    // Authoritative snapshot stream, for players that asked for one
+    bool streaming;
+    CombatStreamer streamers[2];
+    CombatEventQueue streamEvents;
+    CombatEvent streamPending[STREAM_MAX_EVENTS];   // emitted since the last snapshot
+    int streamPendingCount;
+#ifdef COMBAT_PROFILE
+    CombatProfile combatProf;   // current battle
+    CombatProfile sessionProf;  // all finished battles this session
+#endif
 
     // Prep timer
     float prepTimer;
 } GameSession;
 
+// Outcome cache shared by every session (NULL = always simulate)
+void session_set_combat_cache(CombatCache *cache);
+
 // Initialize a new session with the first player's socket
 void session_init(GameSession *s, int player0_sock);
 
@@ -0,0 +1,292 @@
+// Combat replay tool — inspect, verify, seek and benchmark .rpl files, or record
+// a corpus of seeded battles to use as CombatTick benchmark input.
+//
+//   make replaytool
+//   ./replay_tool info   file.rpl
+//   ./replay_tool verify file.rpl...          re-simulate, check every recorded hash
+//   ./replay_tool seek   file.rpl tick        jump via the nearest keyframe, print units
+//   ./replay_tool bench  file.rpl...          ns/tick re-simulating the replays
+//   ./replay_tool record dir [battles]        seeded random battles -> dir/battle_N.rpl
+//   ./replay_tool stream file.rpl... [--hz N] stream both players' views through a
+//                                             decoder with 2 snapshots of ack lag,
+//                                             check the round trip, report bytes/s
+#include "../raylib/combat_replay.h"
+#include "../raylib/combat_stream.h"
+#include "../raylib/helpers.h"
+#include "../raylib/synergies.h"
+#include "../raylib/net_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RECORD_DT        (1.0f / 60.0f)
+#define RECORD_MAX_TICKS (60 * 180)
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool open_replay(CombatReplay *rep, const char *path)
+{
+    if (CombatReplayMap(rep, path)) return true;
+    fprintf(stderr, "%s: not a readable replay\n", path);
+    return false;
+}
+
+//------------------------------------------------------------------------------------
+// Commands
+//------------------------------------------------------------------------------------
+static int cmd_info(const char *path)
+{
+    CombatReplay rep;
+    if (!open_replay(&rep, path)) return 1;
+    const ReplayHeader *h = rep.header;
+    printf("%s: %zu bytes, format %u, sim version %u%s\n", path, rep.size, h->formatVersion,
+           h->simVersion, h->simVersion != COMBAT_SIM_VERSION ? " (differs from this build)" : "");
+    printf("  round %u, dt %.4f, %s stepping\n", h->round, h->dt,
+           (h->flags & REPLAY_FLAG_EVENT_STEP) ? "event" : "fixed");
+    printf("  %d units sent, %d keyframes, %d hashes (every %u ticks)\n",
+           rep.netUnitCount, rep.keyframeCount, rep.hashCount, h->hashInterval);
+    if (rep.hasEnd)
+        printf("  result %d after %d ticks (%.2fs)\n", rep.end.result, rep.end.tickCount, rep.end.simTime);
+    CombatReplayClose(&rep);
+    return 0;
+}
+
+// Simulate from tick 0 checking each recorded hash; returns first bad tick or -1
+static int verify_replay(const CombatReplay *rep, int *resultOut)
+{
+    static CombatArena arena;
+    if (!CombatReplayRestore(rep, 0, &arena)) return 0;
+    int result = 0;
+    uint64_t want;
+    while (!result) {
+        if (CombatReplayHashAt(rep, arena.tickCount, &want) && HashCombatState(&arena).all != want)
+            return arena.tickCount;
+        if (arena.tickCount >= RECORD_MAX_TICKS * 4) break;
+        result = CombatReplayStep(rep, &arena, NULL);
+    }
+    *resultOut = result;
+    if (rep->hasEnd && (result != rep->end.result || arena.tickCount != rep->end.tickCount))
+        return arena.tickCount;
+    return -1;
+}
+
+static int cmd_verify(int count, char **paths)
+{
+    int bad = 0;
+    for (int i = 0; i < count; i++) {
+        CombatReplay rep;
+        if (!open_replay(&rep, paths[i])) { bad++; continue; }
+        int result = 0;
+        int tick = verify_replay(&rep, &result);
+        if (tick >= 0) { printf("%s: diverges at tick %d\n", paths[i], tick); bad++; }
+        else printf("%s: ok (result %d, %d ticks)\n", paths[i], result, rep.end.tickCount);
+        CombatReplayClose(&rep);
+    }
+    return bad ? 1 : 0;
+}
+
+static int cmd_seek(const char *path, int tick)
+{
+    CombatReplay rep;
+    if (!open_replay(&rep, path)) return 1;
+    static CombatArena arena;
+    int result = CombatReplaySeek(&rep, tick, &arena);
+    if (result < 0) { fprintf(stderr, "no keyframe at or before tick %d\n", tick); CombatReplayClose(&rep); return 1; }
+    printf("tick %d (t=%.2fs)%s\n", arena.tickCount, arena.simTime, result ? " — battle over" : "");
+    for (int i = 0; i < arena.unitCount; i++) {
+        const Unit *u = &arena.units[i];
+        if (!u->active) continue;
+        printf("  [%2d] %-4s type %2d  hp %7.1f  pos (%6.1f, %6.1f)  target %d\n", i,
+               u->team == TEAM_BLUE ? "blue" : "red", u->typeIndex, u->currentHealth,
+               u->position.x, u->position.z, u->targetIndex);
+    }
+    CombatReplayClose(&rep);
+    return 0;
+}
+
+static int cmd_bench(int count, char **paths)
+{
+    static CombatArena arena;
+    double seconds = 0.0;
+    long ticks = 0;
+    int replays = 0;
+    for (int i = 0; i < count; i++) {
+        CombatReplay rep;
+        if (!open_replay(&rep, paths[i])) continue;
+        if (CombatReplayRestore(&rep, 0, &arena)) {
+            int result = 0;
+            double t0 = now_seconds();
+            while (!result && arena.tickCount < RECORD_MAX_TICKS * 4)
+                result = CombatReplayStep(&rep, &arena, NULL);
+            seconds += now_seconds() - t0;
+            ticks += arena.tickCount;
+            replays++;
+        }
+        CombatReplayClose(&rep);
+    }
+    printf("%d replays, %ld ticks, %.1f ns/tick\n", replays, ticks,
+           ticks ? seconds * 1e9 / (double)ticks : 0.0);
+    return 0;
+}
+
+static int cmd_record(const char *dir, int battles)
+{
+    static CombatArena arena;
+    CombatRecorder rec = { 0 };
+    long bytes = 0;
+    for (int b = 0; b < battles; b++) {
+        memset(&arena, 0, sizeof(arena));
+        RngSeed(&arena.rng, (uint64_t)b);
+        Rng *rng = &arena.rng;
+        for (int k = 0; k < BLUE_TEAM_MAX_SIZE; k++) {
+            int type = VALID_UNIT_TYPES[RngRange(rng, 0, VALID_UNIT_TYPE_COUNT - 1)];
+            if (!SpawnUnit(arena.units, &arena.unitCount, type, TEAM_BLUE)) continue;
+            Unit *u = &arena.units[arena.unitCount - 1];
+            u->position = (Vector3){ (float)RngRange(rng, -80, 80), 0.0f, (float)RngRange(rng, 20, 80) };
+            AssignRandomAbilities(rng, u, RngRange(rng, 0, MAX_ABILITIES_PER_UNIT));
+        }
+        int round = RngRange(rng, 0, TOTAL_ROUNDS + 6);
+        SpawnWave(rng, arena.units, &arena.unitCount, round, 0);
+        NetUnit netUnits[NET_MAX_UNITS];
+        int netCount = serialize_units(arena.units, arena.unitCount, netUnits, NET_MAX_UNITS);
+        ApplyRarityBuffs(arena.units, arena.unitCount);
+        ApplySynergies(arena.units, arena.unitCount);
+        CombatArenaBegin(&arena);
+
+        CombatRecorderBegin(&rec, &arena, netUnits, netCount, round, 0, RECORD_DT, RECORD_DT);
+        int result = 0;
+        while (!result && arena.tickCount < RECORD_MAX_TICKS) {
+            result = CombatArenaTick(&arena, RECORD_DT, NULL);
+            CombatRecorderTick(&rec, &arena);
+        }
+        CombatRecorderEnd(&rec, &arena, result);
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/battle_%04d.rpl", dir, b);
+        if (!CombatRecorderSave(&rec, path)) { perror(path); CombatRecorderFree(&rec); return 1; }
+        bytes += rec.size;
+    }
+    CombatRecorderFree(&rec);
+    printf("recorded %d battles, %.1f KB average -> %s\n", battles,
+           battles ? (double)bytes / battles / 1024.0 : 0.0, dir);
+    return 0;
+}
+
+#define STREAM_ACK_LAG 2    // snapshots in flight before the ack reaches the server
+
+// Full encodings of two snapshots match iff they quantized to the same state
+static bool same_snapshot(const StreamSnapshot *a, const StreamSnapshot *b, const StreamView *view)
+{
+    static uint8_t bufA[NET_MAX_PAYLOAD * 4], bufB[NET_MAX_PAYLOAD * 4];
+    int sizeA = StreamEncode(NULL, a, NULL, 0, view, bufA, sizeof(bufA));
+    int sizeB = StreamEncode(NULL, b, NULL, 0, view, bufB, sizeof(bufB));
+    return sizeA == sizeB && sizeA >= 0 && memcmp(bufA, bufB, sizeA) == 0;
+}
+
+// Returns false on the first snapshot that doesn't decode back to what was captured
+static bool stream_replay(const CombatReplay *rep, int hz, int player,
+                          uint64_t *bytes, int *snapshots, int *maxSize, float *seconds)
+{
+    static CombatArena arena;
+    static CombatStreamer st;
+    static StreamClient sc;
+    static StreamSnapshot decoded;
+    static CombatEvent pendingEvents[STREAM_MAX_EVENTS], decodedEvents[STREAM_MAX_EVENTS];
+    if (!CombatReplayRestore(rep, 0, &arena)) return false;
+
+    StreamView view;
+    int blueCount = CountTeamUnits(arena.units, arena.unitCount, TEAM_BLUE);
+    StreamViewInit(&view, arena.unitCount, player ? blueCount : 0, player == 1);
+    CombatStreamerBegin(&st, hz, &view);
+    StreamClientBegin(&sc, NULL);
+    CombatEventQueue events;
+    if (!CombatEventQueueInit(&events)) return false;
+
+    uint16_t acks[STREAM_ACK_LAG + 1];
+    int ackCount = 0, pendingCount = 0, result = 0;
+    bool ok = true;
+    while (ok && !result && arena.tickCount < RECORD_MAX_TICKS * 4) {
+        result = CombatReplayStep(rep, &arena, &events);
+        CombatEvent ev;
+        while (CombatEventPop(&events, &ev))
+            if (pendingCount < STREAM_MAX_EVENTS) pendingEvents[pendingCount++] = ev;
+        if (!result && !CombatStreamerDue(&st, arena.simTime)) continue;
+
+        uint8_t buf[NET_MAX_PAYLOAD];
+        int size = CombatStreamerEncode(&st, &arena, result > 0, pendingEvents, pendingCount, buf, sizeof(buf));
+        if (size < 0) { ok = false; break; }
+        *bytes += (uint64_t)size;
+        (*snapshots)++;
+        if (size > *maxSize) *maxSize = size;
+
+        // Decode against the client's own copy of the baseline, as the game does
+        uint16_t seq, baseSeq;
+        int eventCount = 0;
+        StreamMessageBase(buf, size, &seq, &baseSeq);
+        const StreamSnapshot *base = baseSeq == STREAM_NO_BASE ? NULL : &sc.frames[baseSeq % STREAM_HISTORY];
+        ok = StreamDecode(base, buf, size, &decoded, decodedEvents, STREAM_MAX_EVENTS, &eventCount) &&
+             same_snapshot(&decoded, &st.history[seq % STREAM_HISTORY], &view) &&
+             eventCount == pendingCount;
+        uint16_t ackSeq;
+        ok = ok && StreamClientReceive(&sc, buf, size, &ackSeq);
+        pendingCount = 0;
+
+        acks[ackCount++] = ackSeq;
+        if (ackCount > STREAM_ACK_LAG) {
+            CombatStreamerAck(&st, acks[0]);
+            memmove(acks, acks + 1, STREAM_ACK_LAG * sizeof(acks[0]));
+            ackCount--;
+        }
+    }
+    *seconds += arena.simTime;
+    CombatEventQueueFree(&events);
+    return ok;
+}
+
+static int cmd_stream(int count, char **paths)
+{
+    int hz = STREAM_DEFAULT_HZ;
+    int bad = 0, replays = 0, snapshots = 0, maxSize = 0;
+    uint64_t bytes = 0;
+    float seconds = 0.0f;
+    for (int i = 0; i + 1 < count; i++)
+        if (strcmp(paths[i], "--hz") == 0) hz = atoi(paths[i + 1]);
+    if (hz < STREAM_MIN_HZ) hz = STREAM_MIN_HZ;
+    if (hz > STREAM_MAX_HZ) hz = STREAM_MAX_HZ;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(paths[i], "--hz") == 0) { i++; continue; }
+        CombatReplay rep;
+        if (!open_replay(&rep, paths[i])) { bad++; continue; }
+        for (int player = 0; player < 2; player++) {
+            if (!stream_replay(&rep, hz, player, &bytes, &snapshots, &maxSize, &seconds)) {
+                printf("%s: player %d stream does not round-trip\n", paths[i], player);
+                bad++;
+            }
+        }
+        replays++;
+        CombatReplayClose(&rep);
+    }
+    printf("%d replays at %d Hz: %d snapshots, %.0f bytes average, %d max, %.0f B/s per player\n",
+           replays, hz, snapshots, snapshots ? (double)bytes / snapshots : 0.0, maxSize,
+           seconds > 0.0f ? (double)bytes / seconds : 0.0);
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 3 && strcmp(argv[1], "info") == 0) return cmd_info(argv[2]);
+    if (argc >= 3 && strcmp(argv[1], "verify") == 0) return cmd_verify(argc - 2, argv + 2);
+    if (argc >= 4 && strcmp(argv[1], "seek") == 0) return cmd_seek(argv[2], atoi(argv[3]));
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) return cmd_bench(argc - 2, argv + 2);
+    if (argc >= 3 && strcmp(argv[1], "record") == 0)
+        return cmd_record(argv[2], argc >= 4 ? atoi(argv[3]) : 50);
+    if (argc >= 3 && strcmp(argv[1], "stream") == 0) return cmd_stream(argc - 2, argv + 2);
+    fprintf(stderr, "usage: %s info|verify|seek|bench|record|stream ... (see replay_tool.c)\n", argv[0]);
+    return 2;
+}
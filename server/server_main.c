@@ -40,6 +40,15 @@ static Leaderboard globalLeaderboard;
 #define NFC_TAGS_FILE "nfc_tags.json"
 static NfcStore nfcStore;
 
+//------------------------------------------------------------------------------------
+// Combat outcome cache — rematches with unchanged armies skip the simulation
+//------------------------------------------------------------------------------------
+#define COMBAT_CACHE_ENTRIES      4096
+#define COMBAT_CACHE_REPLAY_BYTES (16 * 1024 * 1024)
+#define COMBAT_CACHE_PERSIST      1     // 0 = memory only
+#define COMBAT_CACHE_FILE         "combat_cache.bin"
+static CombatCache combatCache;
+
 static void send_leaderboard_data(int sockfd)
 {
     // Payload: [entryCount:1][entries × 55 bytes]
@@ -382,7 +391,6 @@ int main(int argc, char *argv[])
 
     signal(SIGINT, sigint_handler);
     signal(SIGPIPE, SIG_IGN);
-    srand((unsigned)time(NULL));
 
     // Load global leaderboard
     LoadLeaderboard(&globalLeaderboard, GLOBAL_LEADERBOARD_FILE);
@@ -392,6 +400,15 @@ int main(int argc, char *argv[])
     NfcStoreLoad(&nfcStore, NFC_TAGS_FILE);
     printf("Loaded %d NFC tags from %s\n", nfcStore.tagCount, NFC_TAGS_FILE);
 
+    // Combat outcome cache
+    if (CombatCacheInit(&combatCache, COMBAT_CACHE_ENTRIES, COMBAT_CACHE_REPLAY_BYTES)) {
+#if COMBAT_CACHE_PERSIST
+        CombatCacheLoad(&combatCache, COMBAT_CACHE_FILE);
+        printf("Loaded %d cached combat outcomes from %s\n", combatCache.count, COMBAT_CACHE_FILE);
+#endif
+        session_set_combat_cache(&combatCache);
+    }
+
     // Create listening socket
     int listenfd = socket(AF_INET, SOCK_STREAM, 0);
     if (listenfd < 0) { perror("socket"); return 1; }
@@ -452,6 +469,11 @@ int main(int argc, char *argv[])
     printf("[Server] Saved %d leaderboard entries\n", globalLeaderboard.entryCount);
     NfcStoreSave(&nfcStore, NFC_TAGS_FILE);
     printf("[Server] Saved %d NFC tags\n", nfcStore.tagCount);
+#if COMBAT_CACHE_PERSIST
+    CombatCacheSave(&combatCache, COMBAT_CACHE_FILE);
+    printf("[Server] Saved %d cached combat outcomes\n", combatCache.count);
+#endif
+    CombatCacheFree(&combatCache);
 
     // Close all sessions
     for (int i = 0; i < sessionCount; i++) {
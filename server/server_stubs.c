@@ -1,12 +1,17 @@
 // Stubs for raylib functions used by shared code in the headless server build.
 // The server links without raylib, so these provide minimal implementations.
-#include <stdlib.h>
 #include "raylib.h"
+#include "../raylib/helpers.h"
 
+// Only cosmetic paths (e.g. SpawnUnit's idle anim offset) still reach this —
+// gameplay randomness goes through each session's Rng. Per-thread state keeps
+// it off the shared global rand().
 int GetRandomValue(int min, int max)
 {
-    if (min > max) { int t = min; min = max; max = t; }
-    return min + rand() % (max - min + 1);
+    static _Thread_local Rng rng;
+    static _Thread_local bool seeded = false;
+    if (!seeded) { RngSeed(&rng, (uint64_t)(uintptr_t)&rng); seeded = true; }
+    return RngRange(&rng, min, max);
 }
 
 void DrawLine3D(Vector3 startPos, Vector3 endPos, Color color)